@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_ROUTING_MATRIX_CHANGE_H_
 #define MAIDSAFE_ROUTING_MATRIX_CHANGE_H_
 
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -28,15 +29,20 @@
 #include "maidsafe/common/node_id.h"
 #include "maidsafe/common/utils.h"
 
+#include "maidsafe/routing/uint512.h"
+
 namespace maidsafe {
 
 namespace routing {
 
 class RoutingTable;
 class GroupMatrix;
+class ChangeCoalescer;
+class CheckHoldersCursor;
 
 namespace test {
 class MatrixChangeTest_BEH_CheckHolders_Test;
+class MatrixChangeTest_BEH_CheckHoldersBatch_Test;
 class SingleMatrixChangeTest_BEH_ChoosePmidNode_Test;
 class GroupMatrixTest_BEH_EmptyMatrix_Test;
 }
@@ -61,26 +67,74 @@ class MatrixChange {
   MatrixChange& operator=(MatrixChange other);
 
   CheckHoldersResult CheckHolders(const NodeId& target) const;
+  // Equivalent to calling CheckHolders for each target in turn, but sorts the matrices once for the
+  // whole batch, e.g. for every key held when handling a single churn event.  The targets are split
+  // into 'worker_count' contiguous parts checked concurrently, each with a CheckHoldersCursor, so
+  // passing them sorted by id lets most results be reused from the previous target.
+  std::vector<CheckHoldersResult> CheckHolders(const std::vector<NodeId>& targets,
+                                               unsigned worker_count = 1) const;
   NodeId ChoosePmidNode(const std::set<NodeId>& online_pmids, const NodeId& target) const;
-  std::vector<NodeId> lost_nodes() const { return lost_nodes_; }
-  std::vector<NodeId> new_nodes() const { return new_nodes_; }
+  std::vector<NodeId> lost_nodes() const { return Derive()->lost_nodes; }
+  std::vector<NodeId> new_nodes() const { return Derive()->new_nodes; }
   void Print();
 
   friend void swap(MatrixChange& lhs, MatrixChange& rhs) MAIDSAFE_NOEXCEPT;
   friend class GroupMatrix;
   friend class RoutingTable;
+  friend class ChangeCoalescer;
+  friend class CheckHoldersCursor;
   friend class test::MatrixChangeTest_BEH_CheckHolders_Test;
+  friend class test::MatrixChangeTest_BEH_CheckHoldersBatch_Test;
   friend class test::SingleMatrixChangeTest_BEH_ChoosePmidNode_Test;
   friend class test::GroupMatrixTest_BEH_EmptyMatrix_Test;
 
  private:
+  // Everything derived from the old and new matrices.  Built on first use and then shared by copies
+  // of the MatrixChange, since many changes are only checked with OldEqualsToNew and discarded.
+  struct Derived {
+    Derived()
+        : old_matrix(), new_matrix(), lost_nodes(), new_nodes(), radius(), distinguishing_bits(0) {}
+    std::vector<NodeId> old_matrix, new_matrix;  // Sorted by id
+    std::vector<NodeId> lost_nodes, new_nodes;   // Sorted by distance from node_id_
+    Uint512 radius;
+    // The number of leading bits needed to tell apart every id in either matrix.  Targets sharing
+    // these bits see all of the ids in the same order of distance, so have the same holders.
+    int distinguishing_bits;
+  };
+
   MatrixChange(NodeId this_node_id, const std::vector<NodeId>& old_matrix,
                const std::vector<NodeId>& new_matrix);
   bool OldEqualsToNew() const;
+  std::shared_ptr<const Derived> Derive() const;
+  CheckHoldersResult CheckHolders(const Derived& derived, const NodeId& target) const;
 
   NodeId node_id_;
-  std::vector<NodeId> old_matrix_, new_matrix_, lost_nodes_, new_nodes_;
-  crypto::BigInt radius_;
+  // As passed to the constructor, in no particular order.
+  std::vector<NodeId> old_ids_, new_ids_;
+  // False if the matrices' sizes or XOR of all their ids differ, so they can't hold the same ids.
+  bool may_be_equal_;
+  mutable std::shared_ptr<const Derived> derived_;
+};
+
+// Answers MatrixChange::CheckHolders for a stream of targets, e.g. keys read in order from a store.
+// While consecutive targets share the matrix ids' distinguishing bits, the previous target's
+// holders are reused rather than looked up again, so it is most effective when targets arrive
+// sorted by id.  Not thread-safe; use one cursor per thread.
+class CheckHoldersCursor {
+ public:
+  explicit CheckHoldersCursor(const MatrixChange& matrix_change);
+  CheckHoldersResult CheckHolders(const NodeId& target);
+
+ private:
+  CheckHoldersCursor(const CheckHoldersCursor&);
+  CheckHoldersCursor& operator=(const CheckHoldersCursor&);
+
+  const MatrixChange kMatrixChange_;
+  const std::shared_ptr<const MatrixChange::Derived> kDerived_;
+  const Uint512 kNodeIdValue_;
+  // The last target looked up in full and its result.
+  std::string region_target_;
+  CheckHoldersResult region_result_;
 };
 
 }  // namespace routing
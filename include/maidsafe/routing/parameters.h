@@ -46,6 +46,9 @@ struct Parameters {
   static std::chrono::seconds recovery_time_lag;
   static std::chrono::seconds re_bootstrap_time_lag;
   static std::chrono::seconds find_close_node_interval;
+  // Matrix and connected group changes within this window of the first are passed on as one net
+  // change; zero passes each on as it happens.
+  static std::chrono::milliseconds matrix_change_coalescing_window;
   static uint16_t find_node_repeats_per_num_requested;
   static uint16_t maximum_find_close_node_failures;
   static uint16_t max_route_history;
@@ -54,11 +57,19 @@ struct Parameters {
   static uint16_t split_avoidance;
   static uint16_t routing_table_ready_to_response;
   static uint16_t accepted_distance_tolerance;
+  // Roughly how many of the most recent network average distances reported by other nodes
+  // NetworkStatistics' moving average is taken over.
+  static uint16_t average_distance_window;
   static boost::posix_time::time_duration connect_rpc_prune_timeout;
   static bool append_maidsafe_endpoints;
   static bool append_maidsafe_local_endpoints;
   static bool append_local_live_port_endpoint;
   static bool caching;
+  // The lowest maidsafe::log level at which TRACE statements on the per-message paths are run.
+  // Below it their arguments aren't evaluated at all, whatever the logging filter.  Defaults to
+  // kVerbose, leaving the choice to the logging filter, which TRACE also checks before doing any
+  // work (and to ROUTING_STRIP_VERBOSE_TRACE).
+  static int trace_level;
 
  private:
   Parameters();
@@ -0,0 +1,106 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_UINT512_H_
+#define MAIDSAFE_ROUTING_UINT512_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "maidsafe/common/node_id.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+// Fixed-width 512-bit unsigned integer, held as eight 64-bit words with the most significant word
+// first.  Converting a NodeId reads its raw bytes as a big-endian number, so comparing two values
+// orders them exactly as comparing the ids does, and comparing 'id ^ target' values orders ids by
+// XOR distance from 'target' like NodeId::CloserToTarget.  Comparisons work a word at a time and
+// stop at the first differing word.  The arithmetic covers what distance and radius calculations
+// need (adding distances and scaling by small factors) without going through crypto::BigInt.
+class Uint512 {
+ public:
+  static const size_t kWordCount = NodeId::kSize / sizeof(uint64_t);
+
+  static Uint512 Max() {
+    Uint512 max;
+    max.words_.fill(~uint64_t(0));
+    return max;
+  }
+
+  Uint512() : words_() {}
+  explicit Uint512(const NodeId& node_id) : words_() {
+    const std::string raw_id(node_id.string());
+    for (size_t word_index(0), byte_index(0); word_index != kWordCount; ++word_index) {
+      uint64_t word(0);
+      for (size_t i(0); i != sizeof(uint64_t); ++i, ++byte_index)
+        word = (word << 8) | static_cast<unsigned char>(raw_id[byte_index]);
+      words_[word_index] = word;
+    }
+  }
+
+  Uint512& operator^=(const Uint512& other) {
+    for (size_t i(0); i != kWordCount; ++i)
+      words_[i] ^= other.words_[i];
+    return *this;
+  }
+
+  // Adds 'other', returning the carry out of the most significant word (0 or 1).
+  uint32_t Add(const Uint512& other);
+  // Multiplies by 'factor', returning the part of the product above the 512 bits kept.
+  uint32_t MultiplyBy(uint32_t factor);
+  // Replaces this with (high_word * 2^512 + this) / divisor, returning the remainder.  'high_word'
+  // must be less than 'divisor' so that the quotient fits.
+  uint32_t DivideBy(uint32_t divisor, uint32_t high_word = 0);
+
+  uint64_t word(size_t index) const { return words_[index]; }
+  bool IsZero() const;
+  // Returns the number of leading zero bits, i.e. 512 for zero.
+  int CountLeadingZeros() const;
+  NodeId ToNodeId() const;
+
+  friend bool operator==(const Uint512& lhs, const Uint512& rhs) {
+    return lhs.words_ == rhs.words_;
+  }
+  friend bool operator<(const Uint512& lhs, const Uint512& rhs) {
+    for (size_t i(0); i != kWordCount; ++i) {
+      if (lhs.words_[i] != rhs.words_[i])
+        return lhs.words_[i] < rhs.words_[i];
+    }
+    return false;
+  }
+
+ private:
+  std::array<uint64_t, kWordCount> words_;
+};
+
+inline Uint512 operator^(Uint512 lhs, const Uint512& rhs) { return lhs ^= rhs; }
+// Returns value * factor, or Uint512::Max() if the product doesn't fit.
+Uint512 MultiplySaturating(Uint512 value, uint32_t factor);
+inline bool operator!=(const Uint512& lhs, const Uint512& rhs) { return !(lhs == rhs); }
+inline bool operator>(const Uint512& lhs, const Uint512& rhs) { return rhs < lhs; }
+inline bool operator<=(const Uint512& lhs, const Uint512& rhs) { return !(rhs < lhs); }
+inline bool operator>=(const Uint512& lhs, const Uint512& rhs) { return !(lhs < rhs); }
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_UINT512_H_
@@ -0,0 +1,210 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/change_coalescer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace {
+
+bool SameNodeIds(const std::vector<NodeInfo>& lhs, const std::vector<NodeInfo>& rhs) {
+  return lhs.size() == rhs.size() &&
+         std::equal(std::begin(lhs), std::end(lhs), std::begin(rhs),
+                    [](const NodeInfo& lhs_node, const NodeInfo& rhs_node) {
+                      return lhs_node.node_id == rhs_node.node_id;
+                    });
+}
+
+}  // unnamed namespace
+
+ChangeCoalescer::State::State(boost::asio::io_service& io_service,
+                              std::chrono::steady_clock::duration window)
+    : kWindow(window),
+      mutex(),
+      notify_mutex(),
+      connected_group_change_functor(),
+      matrix_change_functor(),
+      connected_group_change_pending(false),
+      new_connected_peers(),
+      old_connected_peers(),
+      first_matrix_change(),
+      last_matrix_change(),
+      window_open(false),
+      stopped(false),
+      timer(io_service) {}
+
+ChangeCoalescer::ChangeCoalescer(boost::asio::io_service& io_service,
+                                 std::chrono::steady_clock::duration window)
+    : state_(std::make_shared<State>(io_service, window)) {}
+
+ChangeCoalescer::~ChangeCoalescer() { Stop(); }
+
+void ChangeCoalescer::InitialiseFunctors(ConnectedGroupChangeFunctor connected_group_change_functor,
+                                         MatrixChangedFunctor matrix_change_functor) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  if (state_->stopped)
+    return;
+  state_->connected_group_change_functor = connected_group_change_functor;
+  state_->matrix_change_functor = matrix_change_functor;
+}
+
+void ChangeCoalescer::AddConnectedGroupChange(std::vector<NodeInfo> new_connected_peers,
+                                              std::vector<NodeInfo> old_connected_peers) {
+  State& state(*state_);
+  std::unique_lock<std::mutex> lock(state.mutex);
+  if (state.stopped)
+    return;
+  if (state.kWindow == std::chrono::steady_clock::duration::zero()) {
+    lock.unlock();
+    std::lock_guard<std::mutex> notify_lock(state.notify_mutex);
+    lock.lock();
+    ConnectedGroupChangeFunctor connected_group_change_functor(
+        state.stopped ? ConnectedGroupChangeFunctor() : state.connected_group_change_functor);
+    lock.unlock();
+    if (connected_group_change_functor)
+      connected_group_change_functor(new_connected_peers, old_connected_peers);
+    return;
+  }
+  if (!state.connected_group_change_pending) {
+    state.old_connected_peers.swap(old_connected_peers);
+    state.connected_group_change_pending = true;
+  }
+  state.new_connected_peers.swap(new_connected_peers);
+  StartWindow(state_, lock);
+}
+
+void ChangeCoalescer::AddMatrixChange(std::shared_ptr<MatrixChange> matrix_change) {
+  State& state(*state_);
+  std::unique_lock<std::mutex> lock(state.mutex);
+  if (state.stopped)
+    return;
+  if (state.kWindow == std::chrono::steady_clock::duration::zero()) {
+    lock.unlock();
+    std::lock_guard<std::mutex> notify_lock(state.notify_mutex);
+    lock.lock();
+    MatrixChangedFunctor matrix_change_functor(state.stopped ? MatrixChangedFunctor()
+                                                             : state.matrix_change_functor);
+    lock.unlock();
+    if (matrix_change_functor)
+      matrix_change_functor(matrix_change);
+    return;
+  }
+  if (!state.first_matrix_change)
+    state.first_matrix_change = matrix_change;
+  state.last_matrix_change = matrix_change;
+  StartWindow(state_, lock);
+}
+
+void ChangeCoalescer::Flush() { Flush(*state_); }
+
+void ChangeCoalescer::Stop() {
+  State& state(*state_);
+  // Taking notify_mutex waits for a flush which is passing changes on to finish.
+  std::lock_guard<std::mutex> notify_lock(state.notify_mutex);
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (state.stopped)
+    return;
+  state.stopped = true;
+  state.timer.cancel();
+  state.window_open = false;
+  state.connected_group_change_functor = ConnectedGroupChangeFunctor();
+  state.matrix_change_functor = MatrixChangedFunctor();
+  state.connected_group_change_pending = false;
+  state.new_connected_peers.clear();
+  state.old_connected_peers.clear();
+  state.first_matrix_change.reset();
+  state.last_matrix_change.reset();
+}
+
+void ChangeCoalescer::Flush(State& state) {
+  // Held while the functors run so that a flush can't overtake the previous one's notifications,
+  // and so that Stop waits for them.
+  std::lock_guard<std::mutex> notify_lock(state.notify_mutex);
+  ConnectedGroupChangeFunctor connected_group_change_functor;
+  MatrixChangedFunctor matrix_change_functor;
+  bool connected_group_change_pending(false);
+  std::vector<NodeInfo> new_connected_peers, old_connected_peers;
+  std::shared_ptr<MatrixChange> first_matrix_change, last_matrix_change;
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.stopped)
+      return;
+    if (state.window_open) {
+      state.timer.cancel();
+      state.window_open = false;
+    }
+    connected_group_change_functor = state.connected_group_change_functor;
+    matrix_change_functor = state.matrix_change_functor;
+    std::swap(connected_group_change_pending, state.connected_group_change_pending);
+    new_connected_peers.swap(state.new_connected_peers);
+    old_connected_peers.swap(state.old_connected_peers);
+    first_matrix_change.swap(state.first_matrix_change);
+    last_matrix_change.swap(state.last_matrix_change);
+  }
+
+  if (connected_group_change_pending && connected_group_change_functor &&
+      !SameNodeIds(new_connected_peers, old_connected_peers))
+    connected_group_change_functor(new_connected_peers, old_connected_peers);
+
+  if (!last_matrix_change || !matrix_change_functor)
+    return;
+  std::shared_ptr<MatrixChange> matrix_change(last_matrix_change);
+  if (first_matrix_change != last_matrix_change) {
+    matrix_change = std::make_shared<MatrixChange>(MatrixChange(
+        last_matrix_change->node_id_, first_matrix_change->old_ids_, last_matrix_change->new_ids_));
+  }
+  if (!matrix_change->OldEqualsToNew())
+    matrix_change_functor(matrix_change);
+}
+
+void ChangeCoalescer::StartWindow(const std::shared_ptr<State>& state,
+                                  std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  if (state->window_open || state->stopped)
+    return;
+  state->window_open = true;
+  state->timer.expires_from_now(state->kWindow);
+  std::weak_ptr<State> weak_state(state);
+  state->timer.async_wait([weak_state](const boost::system::error_code& error_code) {
+    if (error_code != boost::asio::error::operation_aborted)
+      OnWindowClosed(weak_state, error_code);
+  });
+}
+
+void ChangeCoalescer::OnWindowClosed(const std::weak_ptr<State>& weak_state,
+                                     const boost::system::error_code& error_code) {
+  std::shared_ptr<State> state(weak_state.lock());
+  if (!state)
+    return;
+  if (error_code)
+    LOG(kWarning) << "Change coalescing timer error: " << error_code.message();
+  Flush(*state);
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
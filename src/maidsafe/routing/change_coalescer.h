@@ -0,0 +1,95 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_CHANGE_COALESCER_H_
+#define MAIDSAFE_ROUTING_CHANGE_COALESCER_H_
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "boost/asio/io_service.hpp"
+#include "boost/asio/steady_timer.hpp"
+#include "boost/system/error_code.hpp"
+
+#include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/matrix_change.h"
+#include "maidsafe/routing/node_info.h"
+#include "maidsafe/routing/routing_table.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+// Merges the matrix and connected group changes reported by the routing table within a short
+// window into one net change of each kind (old from the first change, new from the last), so a
+// burst of churn gives a single round of callbacks and ClosestNodesUpdate RPCs rather than one per
+// node added, dropped or updated.  The window opens at the first change after a flush and isn't
+// extended by later ones, so under continuous churn each kind is still passed on once per window.
+// Net changes which leave things as they were are dropped.  A zero window passes every change
+// straight on.
+class ChangeCoalescer {
+ public:
+  ChangeCoalescer(boost::asio::io_service& io_service, std::chrono::steady_clock::duration window);
+  ~ChangeCoalescer();
+  void InitialiseFunctors(ConnectedGroupChangeFunctor connected_group_change_functor,
+                          MatrixChangedFunctor matrix_change_functor);
+  void AddConnectedGroupChange(std::vector<NodeInfo> new_connected_peers,
+                               std::vector<NodeInfo> old_connected_peers);
+  void AddMatrixChange(std::shared_ptr<MatrixChange> matrix_change);
+  // Passes on any pending changes now rather than at the end of the window.
+  void Flush();
+  // Drops any pending changes and passes nothing on from now on.  Waits for any notification
+  // already under way to finish, so mustn't be called from within one of the functors.  The owner
+  // must call this while the functors' targets are still alive.
+  void Stop();
+
+ private:
+  // Everything the window's timer handler uses.  The handler only holds a weak_ptr to it, so a
+  // window closing after the coalescer has gone finds nothing rather than a destroyed object.
+  struct State {
+    State(boost::asio::io_service& io_service, std::chrono::steady_clock::duration window);
+    const std::chrono::steady_clock::duration kWindow;
+    std::mutex mutex, notify_mutex;
+    ConnectedGroupChangeFunctor connected_group_change_functor;
+    MatrixChangedFunctor matrix_change_functor;
+    bool connected_group_change_pending;
+    std::vector<NodeInfo> new_connected_peers, old_connected_peers;
+    std::shared_ptr<MatrixChange> first_matrix_change, last_matrix_change;
+    bool window_open, stopped;
+    boost::asio::steady_timer timer;
+  };
+
+  ChangeCoalescer(const ChangeCoalescer&);
+  ChangeCoalescer(const ChangeCoalescer&&);
+  ChangeCoalescer& operator=(const ChangeCoalescer&);
+
+  static void StartWindow(const std::shared_ptr<State>& state, std::unique_lock<std::mutex>& lock);
+  static void OnWindowClosed(const std::weak_ptr<State>& weak_state,
+                             const boost::system::error_code& error_code);
+  static void Flush(State& state);
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_CHANGE_COALESCER_H_
@@ -18,6 +18,9 @@
 
 #include "maidsafe/routing/client_routing_table.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "maidsafe/common/log.h"
 
 #include "maidsafe/routing/node_info.h"
@@ -34,7 +37,7 @@ typedef boost::asio::ip::udp::endpoint Endpoint;
 }  // unnamed namespace
 
 ClientRoutingTable::ClientRoutingTable(NodeId node_id)
-    : kNodeId_(std::move(node_id)), nodes_(), mutex_() {}
+    : kNodeId_(std::move(node_id)), nodes_(), connection_index_(), node_index_(), mutex_() {}
 
 bool ClientRoutingTable::AddNode(NodeInfo& node, const NodeId& furthest_close_node_id) {
   return AddOrCheckNode(node, furthest_close_node_id, true);
@@ -51,7 +54,7 @@ bool ClientRoutingTable::AddOrCheckNode(NodeInfo& node, const NodeId& furthest_c
   std::lock_guard<std::mutex> lock(mutex_);
   if (CheckRangeForNodeToBeAdded(node, furthest_close_node_id, add)) {
     if (add) {
-      nodes_.push_back(node);
+      InsertNode(node);
       LOG(kInfo) << "Added to ClientRoutingTable :" << DebugId(node.node_id);
       LOG(kVerbose) << PrintClientRoutingTable();
     }
@@ -63,46 +66,37 @@ bool ClientRoutingTable::AddOrCheckNode(NodeInfo& node, const NodeId& furthest_c
 std::vector<NodeInfo> ClientRoutingTable::DropNodes(const NodeId& node_to_drop) {
   std::vector<NodeInfo> nodes_info;
   std::lock_guard<std::mutex> lock(mutex_);
-  uint16_t i(0);
-  while (i < nodes_.size()) {
-    if (nodes_.at(i).node_id == node_to_drop) {
-      nodes_info.push_back(nodes_.at(i));
-      nodes_.erase(nodes_.begin() + i);
-    } else {
-      ++i;
-    }
-  }
+  std::vector<size_t> indices;
+  auto range(node_index_.equal_range(node_to_drop));
+  for (auto itr(range.first); itr != range.second; ++itr)
+    indices.push_back(itr->second);
+  // Erasing from the back first leaves the remaining indices valid.
+  std::sort(indices.begin(), indices.end(), std::greater<size_t>());
+  for (auto index : indices)
+    nodes_info.push_back(EraseNode(index));
   return nodes_info;
 }
 
 NodeInfo ClientRoutingTable::DropConnection(const NodeId& connection_to_drop) {
-  NodeInfo node_info;
   std::lock_guard<std::mutex> lock(mutex_);
-  for (auto it = nodes_.begin(); it != nodes_.end(); ++it) {
-    if ((*it).connection_id == connection_to_drop) {
-      node_info = *it;
-      nodes_.erase(it);
-      break;
-    }
-  }
-  return node_info;
+  auto found(connection_index_.find(connection_to_drop));
+  if (found == connection_index_.end())
+    return NodeInfo();
+  return EraseNode(found->second);
 }
 
 std::vector<NodeInfo> ClientRoutingTable::GetNodesInfo(const NodeId& node_id) const {
   std::vector<NodeInfo> nodes_info;
   std::lock_guard<std::mutex> lock(mutex_);
-  for (const auto& elem : nodes_) {
-    if ((elem).node_id == node_id)
-      nodes_info.push_back(elem);
-  }
+  auto range(node_index_.equal_range(node_id));
+  for (auto itr(range.first); itr != range.second; ++itr)
+    nodes_info.push_back(nodes_.at(itr->second));
   return nodes_info;
 }
 
 bool ClientRoutingTable::Contains(const NodeId& node_id) const {
   std::lock_guard<std::mutex> lock(mutex_);
-  return std::find_if(nodes_.begin(), nodes_.end(), [node_id](const NodeInfo & node_info) {
-           return node_info.node_id == node_id;
-         }) != nodes_.end();
+  return node_index_.count(node_id) != 0;
 }
 
 bool ClientRoutingTable::IsConnected(const NodeId& node_id) const { return Contains(node_id); }
@@ -124,9 +118,7 @@ bool ClientRoutingTable::CheckValidParameters(const NodeInfo& node) const {
 
 bool ClientRoutingTable::CheckParametersAreUnique(const NodeInfo& node) const {
   // If we already have a duplicate endpoint return false
-  if (std::find_if(nodes_.begin(), nodes_.end(), [node](const NodeInfo & node_info) {
-        return (node_info.connection_id == node.connection_id);
-      }) != nodes_.end()) {
+  if (connection_index_.count(node.connection_id) != 0) {
     LOG(kInfo) << "Already have node with this connection_id.";
     return false;
   }
@@ -169,6 +161,41 @@ bool ClientRoutingTable::IsThisNodeInRange(const NodeId& node_id,
   return (furthest_close_node_id ^ kNodeId_) > (node_id ^ kNodeId_);
 }
 
+void ClientRoutingTable::InsertNode(const NodeInfo& node) {
+  connection_index_.insert(std::make_pair(node.connection_id, nodes_.size()));
+  node_index_.insert(std::make_pair(node.node_id, nodes_.size()));
+  nodes_.push_back(node);
+}
+
+// Moves the last entry into the erased one's slot, so only that entry's index positions change.
+NodeInfo ClientRoutingTable::EraseNode(size_t index) {
+  assert(index < nodes_.size());
+  NodeInfo node_info(nodes_.at(index));
+  size_t last(nodes_.size() - 1);
+  connection_index_.erase(node_info.connection_id);
+  auto range(node_index_.equal_range(node_info.node_id));
+  for (auto itr(range.first); itr != range.second; ++itr) {
+    if (itr->second == index) {
+      node_index_.erase(itr);
+      break;
+    }
+  }
+
+  if (index != last) {
+    nodes_.at(index) = std::move(nodes_.at(last));
+    connection_index_[nodes_.at(index).connection_id] = index;
+    range = node_index_.equal_range(nodes_.at(index).node_id);
+    for (auto itr(range.first); itr != range.second; ++itr) {
+      if (itr->second == last) {
+        itr->second = index;
+        break;
+      }
+    }
+  }
+  nodes_.pop_back();
+  return node_info;
+}
+
 std::string ClientRoutingTable::PrintClientRoutingTable() {
   auto rt(nodes_);
   std::string s =
@@ -22,6 +22,7 @@
 #include <cstdint>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "boost/asio/ip/udp.hpp"
@@ -30,6 +31,7 @@
 #include "maidsafe/common/rsa.h"
 
 #include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/node_id_hash.h"
 
 namespace maidsafe {
 
@@ -74,6 +76,8 @@ class ClientRoutingTable {
   bool CheckRangeForNodeToBeAdded(NodeInfo& node, const NodeId& furthest_close_node_id,
                                   bool add) const;
   bool IsThisNodeInRange(const NodeId& node_id, const NodeId& furthest_close_node_id) const;
+  void InsertNode(const NodeInfo& node);
+  NodeInfo EraseNode(size_t index);
   std::string PrintClientRoutingTable();
 
   friend class test::BasicClientRoutingTableTest;
@@ -81,6 +85,10 @@ class ClientRoutingTable {
 
   const NodeId kNodeId_;
   std::vector<NodeInfo> nodes_;
+  // Positions in nodes_, kept in step by InsertNode and EraseNode.  A client may be connected via
+  // several connections, so a node id can map to more than one entry.
+  NodeIdIndex connection_index_;
+  std::unordered_multimap<NodeId, size_t, NodeIdHash> node_index_;
   mutable std::mutex mutex_;
 };
 
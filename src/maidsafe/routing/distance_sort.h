@@ -0,0 +1,109 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_DISTANCE_SORT_H_
+#define MAIDSAFE_ROUTING_DISTANCE_SORT_H_
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+
+#include "maidsafe/routing/node_info.h"
+#include "maidsafe/routing/uint512.h"
+
+// Orderings by XOR distance from a target.  Rather than calling NodeId::CloserToTarget from within
+// the sort (which compares the ids a byte at a time, once per comparison), each element's distance
+// is computed once up front and the sort runs over those cached keys.  Ties keep their original
+// relative order.
+
+namespace maidsafe {
+
+namespace routing {
+
+// Default id accessor for ranges of NodeId or NodeInfo.
+struct IdOf {
+  const NodeId& operator()(const NodeId& node_id) const { return node_id; }
+  const NodeId& operator()(const NodeInfo& node_info) const { return node_info.node_id; }
+};
+
+namespace detail {
+
+typedef std::vector<std::pair<Uint512, size_t>> DistanceKeys;
+
+template <typename RandomIt, typename GetId>
+DistanceKeys MakeDistanceKeys(RandomIt first, RandomIt last, const NodeId& target, GetId get_id) {
+  const Uint512 target_value(target);
+  DistanceKeys keys;
+  keys.reserve(last - first);
+  for (size_t index(0); first != last; ++first, ++index)
+    keys.push_back(std::make_pair(Uint512(get_id(*first)) ^ target_value, index));
+  return keys;
+}
+
+// Rearranges [first, first + keys.size()) into the order given by the keys' indices.
+template <typename RandomIt>
+void ApplyOrder(RandomIt first, const DistanceKeys& keys) {
+  typedef typename std::iterator_traits<RandomIt>::value_type ValueType;
+  std::vector<ValueType> ordered;
+  ordered.reserve(keys.size());
+  for (const auto& key : keys)
+    ordered.push_back(std::move(*(first + key.second)));
+  std::move(ordered.begin(), ordered.end(), first);
+}
+
+}  // namespace detail
+
+template <typename RandomIt, typename GetId = IdOf>
+void SortByDistance(RandomIt first, RandomIt last, const NodeId& target, GetId get_id = GetId()) {
+  auto keys(detail::MakeDistanceKeys(first, last, target, get_id));
+  std::sort(keys.begin(), keys.end());
+  detail::ApplyOrder(first, keys);
+}
+
+// Places the elements closest to 'target' in [first, middle), closest first.  The order of the rest
+// is unspecified.
+template <typename RandomIt, typename GetId = IdOf>
+void PartialSortByDistance(RandomIt first, RandomIt middle, RandomIt last, const NodeId& target,
+                           GetId get_id = GetId()) {
+  auto keys(detail::MakeDistanceKeys(first, last, target, get_id));
+  std::partial_sort(keys.begin(), keys.begin() + (middle - first), keys.end());
+  detail::ApplyOrder(first, keys);
+}
+
+// Copies up to 'result_last - result_first' elements of [first, last) closest to 'target' into the
+// result range, closest first.  Returns the end of the copied elements.
+template <typename RandomIt, typename OutputIt, typename GetId = IdOf>
+OutputIt PartialSortCopyByDistance(RandomIt first, RandomIt last, OutputIt result_first,
+                                   OutputIt result_last, const NodeId& target,
+                                   GetId get_id = GetId()) {
+  auto keys(detail::MakeDistanceKeys(first, last, target, get_id));
+  auto middle(keys.begin() + std::min(keys.size(), static_cast<size_t>(result_last - result_first)));
+  std::partial_sort(keys.begin(), middle, keys.end());
+  for (auto itr(keys.begin()); itr != middle; ++itr, ++result_first)
+    *result_first = *(first + itr->second);
+  return result_first;
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_DISTANCE_SORT_H_
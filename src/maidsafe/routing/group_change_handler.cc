@@ -21,12 +21,14 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <iterator>
 
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/node_id.h"
 #include "maidsafe/common/utils.h"
 
 #include "maidsafe/routing/client_routing_table.h"
+#include "maidsafe/routing/distance_sort.h"
 #include "maidsafe/routing/message_handler.h"
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/routing_table.h"
@@ -42,7 +44,13 @@ GroupChangeHandler::GroupChangeHandler(RoutingTable& routing_table,
                                        NetworkUtils& network)
     : routing_table_(routing_table),
       client_routing_table_(client_routing_table),
-      network_(network) {}
+      network_(network),
+      update_mutex_(),
+      update_sequence_(RandomUint32()),
+      sent_closest_nodes_(),
+      delta_recipients_(),
+      delta_capable_peers_(),
+      received_updates_() {}
 
 GroupChangeHandler::~GroupChangeHandler() {}
 
@@ -66,22 +74,141 @@ std::pair<NodeId, std::vector<NodeInfo>> GroupChangeHandler::ClosestNodesUpdate(
     return matrix_update_pair;
   }
 
+  NodeId sender(closest_node_update.node());
+  if (closest_node_update.has_sequence() || closest_node_update.resend_requested())
+    AddDeltaCapablePeer(sender);
+  if (closest_node_update.resend_requested()) {
+    ResendClosestNodes(sender);
+    message.Clear();
+    return matrix_update_pair;
+  }
+
   std::vector<NodeInfo> closest_nodes;
-  NodeInfo node_info;
-  for (const auto& basic_info : closest_node_update.nodes_info()) {
-    if (CheckId(basic_info.node_id())) {
-      node_info.node_id = NodeId(basic_info.node_id());
-      node_info.rank = basic_info.rank();
-      closest_nodes.push_back(node_info);
+  if (closest_node_update.delta()) {
+    if (!ApplyDelta(sender, closest_node_update, closest_nodes)) {
+      LOG(kWarning) << DebugId(routing_table_.kNodeId()) << " missed an update from "
+                    << DebugId(sender) << ", requesting its full list.";
+      // The sender goes on sending deltas until it is asked for the full list, so the request
+      // must go out even if the sender has since left the routing table.
+      protobuf::Message resend_request(
+          rpcs::ClosestNodesUpdateResendRequest(sender, routing_table_.kNodeId()));
+      NodeInfo sender_info;
+      if (routing_table_.GetNodeInfo(sender, sender_info))
+        network_.SendToDirect(resend_request, sender, sender_info.connection_id);
+      else
+        network_.SendToClosestNode(resend_request);
+      message.Clear();
+      return matrix_update_pair;
     }
+  } else {
+    NodeInfo node_info;
+    for (const auto& basic_info : closest_node_update.nodes_info()) {
+      if (CheckId(basic_info.node_id())) {
+        node_info.node_id = NodeId(basic_info.node_id());
+        node_info.rank = basic_info.rank();
+        closest_nodes.push_back(node_info);
+      }
+    }
+    SortByDistance(std::begin(closest_nodes), std::end(closest_nodes), sender);
+    if (closest_node_update.has_sequence())
+      StoreReceivedUpdate(sender, closest_node_update.sequence(), closest_nodes);
   }
   assert(!closest_nodes.empty());
   if (!routing_table_.client_mode())
     message.Clear();
-  if (!UpdateGroupChange(NodeId(closest_node_update.node()), closest_nodes))
+  if (!UpdateGroupChange(sender, closest_nodes))
     return matrix_update_pair;
-  return std::pair<NodeId, std::vector<NodeInfo>>(NodeId(closest_node_update.node()),
-                                                  closest_nodes);
+  return std::pair<NodeId, std::vector<NodeInfo>>(sender, closest_nodes);
+}
+
+bool GroupChangeHandler::ApplyDelta(const NodeId& sender,
+                                    const protobuf::ClosestNodesUpdate& closest_node_update,
+                                    std::vector<NodeInfo>& closest_nodes) {
+  std::lock_guard<std::mutex> lock(update_mutex_);
+  auto found(received_updates_.find(sender));
+  if (found == received_updates_.end() ||
+      found->second.sequence + 1 != closest_node_update.sequence()) {
+    if (found != received_updates_.end())
+      received_updates_.erase(found);
+    return false;
+  }
+
+  std::vector<NodeInfo>& stored_nodes(found->second.closest_nodes);
+  for (const auto& removed_node : closest_node_update.removed_nodes()) {
+    stored_nodes.erase(std::remove_if(std::begin(stored_nodes), std::end(stored_nodes),
+                                      [&removed_node](const NodeInfo& node_info) {
+                                        return node_info.node_id.string() == removed_node;
+                                      }),
+                       std::end(stored_nodes));
+  }
+  for (const auto& basic_info : closest_node_update.nodes_info()) {
+    if (!CheckId(basic_info.node_id()))
+      continue;
+    NodeId node_id(basic_info.node_id());
+    auto existing(std::find_if(std::begin(stored_nodes), std::end(stored_nodes),
+                               [&node_id](const NodeInfo& node_info) {
+                                 return node_info.node_id == node_id;
+                               }));
+    if (existing == std::end(stored_nodes)) {
+      NodeInfo node_info;
+      node_info.node_id = node_id;
+      stored_nodes.push_back(node_info);
+      existing = std::prev(std::end(stored_nodes));
+    }
+    existing->rank = basic_info.rank();
+  }
+  // Kept closest to the sender first, as a full update's list is.
+  SortByDistance(std::begin(stored_nodes), std::end(stored_nodes), sender);
+  found->second.sequence = closest_node_update.sequence();
+  closest_nodes = stored_nodes;
+  return true;
+}
+
+void GroupChangeHandler::StoreReceivedUpdate(const NodeId& sender, uint32_t sequence,
+                                             const std::vector<NodeInfo>& closest_nodes) {
+  std::lock_guard<std::mutex> lock(update_mutex_);
+  // Deltas are only sent between close peers, so lists from other nodes needn't be kept.
+  for (auto itr(received_updates_.begin()); itr != received_updates_.end();) {
+    if (itr->first != sender && !routing_table_.Contains(itr->first))
+      itr = received_updates_.erase(itr);
+    else
+      ++itr;
+  }
+  delta_capable_peers_.erase(
+      std::remove_if(std::begin(delta_capable_peers_), std::end(delta_capable_peers_),
+                     [&](const NodeId& peer) {
+                       return peer != sender && !routing_table_.Contains(peer);
+                     }),
+      std::end(delta_capable_peers_));
+  ReceivedUpdate& received_update(received_updates_[sender]);
+  received_update.sequence = sequence;
+  received_update.closest_nodes = closest_nodes;
+}
+
+void GroupChangeHandler::AddDeltaCapablePeer(const NodeId& peer) {
+  std::lock_guard<std::mutex> lock(update_mutex_);
+  auto position(std::lower_bound(std::begin(delta_capable_peers_), std::end(delta_capable_peers_),
+                                 peer));
+  if (position == std::end(delta_capable_peers_) || *position != peer)
+    delta_capable_peers_.insert(position, peer);
+}
+
+void GroupChangeHandler::ResendClosestNodes(const NodeId& requester) {
+  NodeInfo requester_info;
+  if (!routing_table_.GetNodeInfo(requester, requester_info))
+    return;
+  std::lock_guard<std::mutex> lock(update_mutex_);
+  if (sent_closest_nodes_.empty())
+    return;
+  LOG(kVerbose) << "[" << DebugId(routing_table_.kNodeId())
+                << "] Resending update to: " << DebugId(requester);
+  network_.SendToDirect(rpcs::ClosestNodesUpdate(requester, routing_table_.kNodeId(),
+                                                 sent_closest_nodes_, update_sequence_),
+                        requester, requester_info.connection_id);
+  auto position(std::lower_bound(std::begin(delta_recipients_), std::end(delta_recipients_),
+                                 requester));
+  if (position == std::end(delta_recipients_) || *position != requester)
+    delta_recipients_.insert(position, requester);
 }
 
 bool GroupChangeHandler::UpdateGroupChange(const NodeId& node_id,
@@ -123,27 +250,73 @@ void GroupChangeHandler::SendClosestNodesUpdateRpcs(
 
   LOG(kVerbose) << "[" << DebugId(routing_table_.kNodeId())
                 << "] SendClosestNodesUpdateRpcs: " << closest_nodes.size();
-  std::vector<NodeInfo> update_subscribers(closest_nodes);
+  std::lock_guard<std::mutex> lock(update_mutex_);
+  // The changes since the last update: nodes which are new or re-ranked, and ids which have gone.
+  std::vector<NodeInfo> added_nodes;
+  std::vector<NodeId> removed_nodes;
+  for (const auto& node_info : closest_nodes) {
+    if (std::find_if(std::begin(sent_closest_nodes_), std::end(sent_closest_nodes_),
+                     [&node_info](const NodeInfo& sent_node) {
+                       return sent_node.node_id == node_info.node_id &&
+                              sent_node.rank == node_info.rank;
+                     }) == std::end(sent_closest_nodes_))
+      added_nodes.push_back(node_info);
+  }
+  for (const auto& sent_node : sent_closest_nodes_) {
+    if (std::find_if(std::begin(closest_nodes), std::end(closest_nodes),
+                     [&sent_node](const NodeInfo& node_info) {
+                       return node_info.node_id == sent_node.node_id;
+                     }) == std::end(closest_nodes))
+      removed_nodes.push_back(sent_node.node_id);
+  }
+  ++update_sequence_;
+
+  // Close peers which were sent the previous update, and which are known to understand deltas, are
+  // only sent the changes.  Any others, and clients (which don't keep the list), are sent it in
+  // full; a node from before deltas were introduced would take a delta for a full, shorter list.
+  std::vector<NodeInfo> delta_update_recipients, full_update_recipients;
+  std::vector<NodeId> delta_recipients;
+  for (const auto& closest_node : closest_nodes) {
+    LOG(kVerbose) << "[" << DebugId(routing_table_.kNodeId())
+                  << "] Sending update to: " << DebugId(closest_node.node_id);
+    if (std::binary_search(std::begin(delta_recipients_), std::end(delta_recipients_),
+                           closest_node.node_id) &&
+        std::binary_search(std::begin(delta_capable_peers_), std::end(delta_capable_peers_),
+                           closest_node.node_id))
+      delta_update_recipients.push_back(closest_node);
+    else
+      full_update_recipients.push_back(closest_node);
+    delta_recipients.push_back(closest_node.node_id);
+  }
+  std::sort(std::begin(delta_recipients), std::end(delta_recipients));
+  delta_recipients_.swap(delta_recipients);
+  sent_closest_nodes_ = closest_nodes;
+
   // clients are also notified of changes in connected close nodes
-  for (const auto& client : client_routing_table_.nodes_)
-    update_subscribers.push_back(client);
+  std::vector<NodeInfo> update_subscribers(client_routing_table_.nodes_);
+  update_subscribers.insert(std::end(update_subscribers), std::begin(old_closest_nodes),
+                            std::end(old_closest_nodes));
   for (const auto& update_subscriber : update_subscribers) {
     LOG(kVerbose) << "[" << DebugId(routing_table_.kNodeId())
                   << "] Sending update to: " << DebugId(update_subscriber.node_id);
-    protobuf::Message closest_nodes_update_rpc(rpcs::ClosestNodesUpdate(
-        update_subscriber.node_id, routing_table_.kNodeId(), closest_nodes));
-    network_.SendToDirect(closest_nodes_update_rpc, update_subscriber.node_id,
-                          update_subscriber.connection_id);
+    full_update_recipients.push_back(update_subscriber);
   }
-  for (const auto& old_closest_node : old_closest_nodes) {
-    LOG(kVerbose) << "[" << DebugId(routing_table_.kNodeId())
-                  << "] Sending update to: " << DebugId(old_closest_node.node_id);
-    protobuf::Message closest_nodes_update_rpc(rpcs::ClosestNodesUpdate(
-        old_closest_node.node_id, routing_table_.kNodeId(), closest_nodes));
-    network_.SendToDirect(closest_nodes_update_rpc, old_closest_node.node_id,
-                          old_closest_node.connection_id);
+
+  // Each form of the update is built and serialised once and addressed to each of its recipients.
+  if (!delta_update_recipients.empty()) {
+    protobuf::Message closest_nodes_update_rpc(rpcs::ClosestNodesUpdateDelta(
+        delta_update_recipients.front().node_id, routing_table_.kNodeId(), added_nodes,
+        removed_nodes, update_sequence_));
+    network_.SendToDirect(closest_nodes_update_rpc, delta_update_recipients);
+  }
+  if (!full_update_recipients.empty()) {
+    protobuf::Message closest_nodes_update_rpc(
+        rpcs::ClosestNodesUpdate(full_update_recipients.front().node_id, routing_table_.kNodeId(),
+                                 closest_nodes, update_sequence_));
+    network_.SendToDirect(closest_nodes_update_rpc, full_update_recipients);
   }
 }
+
 bool GroupChangeHandler::GetNodeInfo(const NodeId& node_id, const NodeId& connection_id,
                                      NodeInfo& out_node_info) {
   if (routing_table_.GetNodeInfo(node_id, out_node_info))
@@ -19,6 +19,9 @@
 #ifndef MAIDSAFE_ROUTING_GROUP_CHANGE_HANDLER_H_
 #define MAIDSAFE_ROUTING_GROUP_CHANGE_HANDLER_H_
 
+#include <cstdint>
+#include <map>
+#include <mutex>
 #include <vector>
 #include <utility>
 
@@ -57,15 +60,40 @@ class GroupChangeHandler {
   friend class test::GenericNode;
 
  private:
+  // The last closest nodes list received from a peer, patched by each delta which follows it.
+  struct ReceivedUpdate {
+    ReceivedUpdate() : sequence(0), closest_nodes() {}
+    uint32_t sequence;
+    std::vector<NodeInfo> closest_nodes;
+  };
+
   GroupChangeHandler(const GroupChangeHandler&);
   GroupChangeHandler& operator=(const GroupChangeHandler&);
 
   void Subscribe(const NodeId& node_id, const NodeId& connection_id);
   bool GetNodeInfo(const NodeId& node_id, const NodeId& connection_id, NodeInfo& out_node_info);
+  // Applies a delta to the sender's stored list, setting 'closest_nodes' to the result.  Returns
+  // false if an update from the sender was missed, in which case the full list must be resent.
+  bool ApplyDelta(const NodeId& sender, const protobuf::ClosestNodesUpdate& closest_node_update,
+                  std::vector<NodeInfo>& closest_nodes);
+  void StoreReceivedUpdate(const NodeId& sender, uint32_t sequence,
+                           const std::vector<NodeInfo>& closest_nodes);
+  // Records that 'peer' numbers its updates, and so understands deltas.
+  void AddDeltaCapablePeer(const NodeId& peer);
+  void ResendClosestNodes(const NodeId& requester);
 
   RoutingTable& routing_table_;
   ClientRoutingTable& client_routing_table_;
   NetworkUtils& network_;
+  std::mutex update_mutex_;
+  // This node's update numbering, the list last sent, and the close peers sent that update (sorted)
+  // which can therefore be sent only the changes next time.
+  uint32_t update_sequence_;
+  std::vector<NodeInfo> sent_closest_nodes_;
+  std::vector<NodeId> delta_recipients_;
+  // Peers (sorted) which have sent a numbered update or a resend request, so understand deltas.
+  std::vector<NodeId> delta_capable_peers_;
+  std::map<NodeId, ReceivedUpdate> received_updates_;
 };
 
 }  // namespace routing
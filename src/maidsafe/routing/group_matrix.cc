@@ -21,185 +21,167 @@
 #include <algorithm>
 #include <bitset>
 #include <cstdint>
-#include <set>
+#include <functional>
+#include <iterator>
 
 #include "maidsafe/common/log.h"
 
+#include "maidsafe/routing/distance_sort.h"
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/node_info.h"
 #include "maidsafe/routing/return_codes.h"
+#include "maidsafe/routing/sorted_id_lookup.h"
+#include "maidsafe/routing/trace.h"
 #include "maidsafe/routing/utils.h"
 
 namespace maidsafe {
 
 namespace routing {
 
+namespace {
+
+// Room for group_size + 1 holders without allocating, for any sensible group size.
+const size_t kHolderBufferSize(16);
+
+}  // unnamed namespace
+
 GroupMatrix::GroupMatrix(const NodeId& this_node_id, bool client_mode)
     : kNodeId_(this_node_id),
+      kNodeIdValue_(kNodeId_),
       unique_nodes_(),
-      radius_(crypto::BigInt::Zero()),
+      radius_(),
       client_mode_(client_mode),
-      matrix_() {
-  UpdateUniqueNodeList();
+      connected_peers_(),
+      cells_(),
+      row_offsets_(1, 0),
+      hop_index_() {
+  if (!client_mode_) {
+    NodeInfo this_node;
+    this_node.node_id = kNodeId_;
+    AddUniqueNode(this_node);
+  }
+  UpdateRadius();
 }
 
+GroupMatrix::GroupMatrix(const GroupMatrix& other)
+    : kNodeId_(other.kNodeId_),
+      kNodeIdValue_(other.kNodeIdValue_),
+      unique_nodes_(other.unique_nodes_),
+      radius_(other.radius_),
+      client_mode_(other.client_mode_),
+      connected_peers_(other.connected_peers_),
+      cells_(other.cells_),
+      row_offsets_(other.row_offsets_),
+      hop_index_(other.hop_index_) {}
+
 std::shared_ptr<MatrixChange> GroupMatrix::AddConnectedPeer(
     const NodeInfo& node_info, const std::vector<NodeInfo>& matrix_update) {
   std::vector<NodeId> old_unique_ids(GetUniqueNodeIds());
   LOG(kVerbose) << DebugId(kNodeId_) << " AddConnectedPeer : " << DebugId(node_info.node_id);
-  auto node_id(node_info.node_id);
-  auto found(std::find_if(std::begin(matrix_), std::end(matrix_),
-                          [node_id](const std::vector<NodeInfo>& info) {
-                            return info.begin()->node_id == node_id;
-                          }));
-  if (found != std::end(matrix_)) {
+  if (FindRow(node_info.node_id) != connected_peers_.size()) {
     LOG(kWarning) << "Already Added in matrix";
     return std::make_shared<MatrixChange>(MatrixChange(kNodeId_, old_unique_ids, old_unique_ids));
   }
 
-  std::vector<NodeInfo> nodes_info(std::vector<NodeInfo>(1, node_info));
-  std::copy(std::begin(matrix_update), std::end(matrix_update), std::back_inserter(nodes_info));
-  matrix_.push_back(nodes_info);
+  AppendRow(node_info, matrix_update);
   Prune();
-  UpdateUniqueNodeList();
+  UpdateRadius();
+  RebuildHopIndex();
   return std::make_shared<MatrixChange>(MatrixChange(kNodeId_, old_unique_ids, GetUniqueNodeIds()));
 }
 
 std::shared_ptr<MatrixChange> GroupMatrix::RemoveConnectedPeer(const NodeInfo& node_info) {
   std::vector<NodeId> old_unique_ids(GetUniqueNodeIds());
-  matrix_.erase(std::remove_if(std::begin(matrix_), std::end(matrix_),
-                               [node_info](const std::vector<NodeInfo>& nodes) {
-                                 return (node_info.node_id == nodes.begin()->node_id);
-                               }),
-                std::end(matrix_));
+  size_t row(FindRow(node_info.node_id));
+  if (row != connected_peers_.size())
+    EraseRow(row);
   Prune();
-  UpdateUniqueNodeList();
+  UpdateRadius();
+  RebuildHopIndex();
   return std::make_shared<MatrixChange>(MatrixChange(kNodeId_, old_unique_ids, GetUniqueNodeIds()));
 }
 
 std::vector<NodeInfo> GroupMatrix::GetConnectedPeers() const {
   std::vector<NodeInfo> connected_peers;
-  for (const auto& nodes : matrix_) {
-    if (nodes.begin()->node_id != kNodeId_)
-      connected_peers.push_back(nodes.at(0));
+  for (const auto& peer : connected_peers_) {
+    if (peer.node_id != kNodeId_)
+      connected_peers.push_back(peer);
   }
+  // Rows stay in the order they were added, so are sorted here for callers comparing or sending
+  // the list.
+  SortByDistance(connected_peers.begin(), connected_peers.end(), kNodeId_);
   return connected_peers;
 }
 
-NodeInfo GroupMatrix::GetConnectedPeerFor(const NodeId& target_node_id) {
-  /*
-    for (const auto& nodes : matrix_) {
-      if (nodes.at(0).node_id == target_node_id) {
-        assert(false && "Shouldn't request connected peer for node in first column of group
-    matrix.");
-        return NodeInfo();
-      }
-    }*/
-  for (const auto& nodes : matrix_) {
-    if (std::find_if(std::begin(nodes), std::end(nodes),
-                     [target_node_id](const NodeInfo& node_info) {
-                       return (node_info.node_id == target_node_id);
-                     }) != std::end(nodes)) {
-      return nodes.at(0);
-    }
+NodeInfo GroupMatrix::GetConnectedPeerFor(const NodeId& target_node_id) const {
+  for (size_t row(0); row != connected_peers_.size(); ++row) {
+    if (connected_peers_[row].node_id == target_node_id || RowContains(row, target_node_id))
+      return connected_peers_[row];
   }
   return NodeInfo();
 }
 
 void GroupMatrix::GetBetterNodeForSendingMessage(const NodeId& target_node_id,
-                                                 const std::vector<std::string>& exclude,
+                                                 const NodeIdSet& exclude,
                                                  bool ignore_exact_match,
-                                                 NodeInfo& current_closest_peer) {
+                                                 NodeInfo& current_closest_peer) const {
   NodeId closest_id(current_closest_peer.node_id);
-
-  for (const auto& row : matrix_) {
-    if (ignore_exact_match && row.at(0).node_id == target_node_id)
-      continue;
-    if (std::find(exclude.begin(), exclude.end(), row.at(0).node_id.string()) != exclude.end())
-      continue;
-
-    for (const auto& node : row) {
-      if (node.node_id == kNodeId_)
-        continue;
-      if (ignore_exact_match && node.node_id == target_node_id)
-        continue;
-      if (std::find(exclude.begin(), exclude.end(), node.node_id.string()) != exclude.end())
-        continue;
-      if (NodeId::CloserToTarget(node.node_id, closest_id, target_node_id)) {
-        PrintGroupMatrix();
-        LOG(kVerbose) << DebugId(closest_id) << ", peer to send: "
-                      << DebugId(current_closest_peer.node_id) << ", "
-                      << DebugId(row.at(0).node_id);
-        closest_id = node.node_id;
-        current_closest_peer = row.at(0);
-        LOG(kVerbose) << DebugId(closest_id) << ", peer to send: "
-                      << DebugId(current_closest_peer.node_id);
-      }
-    }
+  size_t row(BestHop(target_node_id, &exclude, ignore_exact_match, closest_id));
+  if (row != connected_peers_.size()) {
+    TRACE(kVerbose) << *this;
+    current_closest_peer = connected_peers_[row];
   }
-  LOG(kVerbose) << "[" << DebugId(kNodeId_) << "]\ttarget: " << DebugId(target_node_id)
-                << "\tfound node in matrix: " << DebugId(closest_id)
-                << "\treccommend sending to: " << DebugId(current_closest_peer.node_id);
+  TRACE(kVerbose) << "[" << DebugId(kNodeId_) << "]\ttarget: " << DebugId(target_node_id)
+                  << "\tfound node in matrix: " << DebugId(closest_id)
+                  << "\treccommend sending to: " << DebugId(current_closest_peer.node_id);
 }
 
 void GroupMatrix::GetBetterNodeForSendingMessage(const NodeId& target_node_id,
                                                  bool ignore_exact_match,
-                                                 NodeId& current_closest_peer_id) {
+                                                 NodeId& current_closest_peer_id) const {
   NodeId closest_id(current_closest_peer_id);
-
-  for (const auto& row : matrix_) {
-    if (ignore_exact_match && row.at(0).node_id == target_node_id)
-      continue;
-
-    for (const auto& node : row) {
-      if (ignore_exact_match && node.node_id == target_node_id)
-        continue;
-      if (NodeId::CloserToTarget(node.node_id, closest_id, target_node_id)) {
-        closest_id = node.node_id;
-        current_closest_peer_id = row.at(0).node_id;
-      }
-    }
-  }
-  LOG(kVerbose) << "[" << DebugId(kNodeId_) << "]\ttarget: " << DebugId(target_node_id)
-                << "\tfound node in matrix: " << DebugId(closest_id)
-                << "\treccommend sending to: " << DebugId(current_closest_peer_id);
+  size_t row(BestHop(target_node_id, nullptr, ignore_exact_match, closest_id));
+  if (row != connected_peers_.size())
+    current_closest_peer_id = connected_peers_[row].node_id;
+  TRACE(kVerbose) << "[" << DebugId(kNodeId_) << "]\ttarget: " << DebugId(target_node_id)
+                  << "\tfound node in matrix: " << DebugId(closest_id)
+                  << "\treccommend sending to: " << DebugId(current_closest_peer_id);
 }
 
-std::vector<NodeInfo> GroupMatrix::GetAllConnectedPeersFor(const NodeId& target_id) {
+std::vector<NodeInfo> GroupMatrix::GetAllConnectedPeersFor(const NodeId& target_id) const {
   std::vector<NodeInfo> connected_nodes;
-  for (const auto& row : matrix_) {
-    if (std::find_if(row.begin(), row.end(), [&target_id](const NodeInfo & node_info) {
-          return target_id == node_info.node_id;
-        }) != row.end()) {
-      connected_nodes.push_back(row.at(0));
-    }
+  for (size_t row(0); row != connected_peers_.size(); ++row) {
+    if (connected_peers_[row].node_id == target_id || RowContains(row, target_id))
+      connected_nodes.push_back(connected_peers_[row]);
   }
   return connected_nodes;
 }
 
-bool GroupMatrix::IsThisNodeGroupLeader(const NodeId& target_id, NodeId& connected_peer) {
+bool GroupMatrix::IsThisNodeGroupLeader(const NodeId& target_id, NodeId& connected_peer) const {
   assert(!client_mode_ && "Client should not call IsThisNodeGroupLeader.");
   if (client_mode_)
     return false;
 
-  LOG(kVerbose) << " Destination " << DebugId(target_id) << " kNodeId " << DebugId(kNodeId_);
+  TRACE(kVerbose) << " Destination " << DebugId(target_id) << " kNodeId " << DebugId(kNodeId_);
   bool is_group_leader = true;
   if (unique_nodes_.empty()) {
     is_group_leader = true;
     return true;
   }
 
-  std::string log("unique_nodes_ for " + DebugId(kNodeId_) + " are ");
-  for (const auto& node : unique_nodes_) {
-    log += DebugId(node.node_id) + ", ";
+  if (TraceEnabled(kVerbose)) {
+    std::string log("unique_nodes_ for " + DebugId(kNodeId_) + " are ");
+    for (const auto& unique_node : unique_nodes_)
+      log += DebugId(unique_node.second.node_info.node_id) + ", ";
+    LOG(kVerbose) << log;
   }
-  LOG(kVerbose) << log;
 
-  for (const auto& node : unique_nodes_) {
+  for (const auto& unique_node : unique_nodes_) {
+    const NodeInfo& node(unique_node.second.node_info);
     if (node.node_id == target_id)
       continue;
     if (NodeId::CloserToTarget(node.node_id, kNodeId_, target_id)) {
-      LOG(kVerbose) << DebugId(node.node_id) << " could be leader";
+      TRACE(kVerbose) << DebugId(node.node_id) << " could be leader";
       is_group_leader = false;
       break;
     }
@@ -213,22 +195,25 @@ bool GroupMatrix::IsThisNodeGroupLeader(const NodeId& target_id, NodeId& connect
   return is_group_leader;
 }
 
-bool GroupMatrix::ClosestToId(const NodeId& target_id) {
+bool GroupMatrix::ClosestToId(const NodeId& target_id) const {
   if (unique_nodes_.size() == 0)
     return true;
 
-  PartialSortFromTarget(target_id, 2, unique_nodes_);
-  if (unique_nodes_.at(0).node_id == kNodeId_)
+  std::vector<NodeId> closest(GetUniqueNodeIds());
+  PartialSortByDistance(closest.begin(),
+                        closest.begin() + std::min(closest.size(), static_cast<size_t>(2)),
+                        closest.end(), target_id);
+  if (closest.at(0) == kNodeId_)
     return true;
 
-  if (unique_nodes_.at(0).node_id == target_id) {
-    if (unique_nodes_.at(1).node_id == kNodeId_)
+  if (closest.at(0) == target_id) {
+    if (closest.at(1) == kNodeId_)
       return true;
     else
-      return NodeId::CloserToTarget(kNodeId_, unique_nodes_.at(1).node_id, target_id);
+      return NodeId::CloserToTarget(kNodeId_, closest.at(1), target_id);
   }
 
-  return NodeId::CloserToTarget(kNodeId_, unique_nodes_.at(0).node_id, target_id);
+  return NodeId::CloserToTarget(kNodeId_, closest.at(0), target_id);
 }
 
 // bool GroupMatrix::IsNodeIdInGroupRange(const NodeId& group_id, const NodeId& node_id) {
@@ -252,27 +237,52 @@ bool GroupMatrix::ClosestToId(const NodeId& target_id) {
 
 GroupRangeStatus GroupMatrix::IsNodeIdInGroupRange(const NodeId& group_id,
                                                    const NodeId& node_id) const {
-  size_t group_size_adjust(Parameters::group_size + 1U);
-  size_t new_holders_size = std::min(unique_nodes_.size(), group_size_adjust);
-  std::vector<NodeInfo> new_holders_info(new_holders_size);
-  std::partial_sort_copy(unique_nodes_.begin(), unique_nodes_.end(), new_holders_info.begin(),
-                         new_holders_info.end(),
-                         [group_id](const NodeInfo & lhs, const NodeInfo & rhs) {
-    return NodeId::CloserToTarget(lhs.node_id, rhs.node_id, group_id);
-  });
+  // Works on distances from group_id throughout.  A unique node's key is its distance from this
+  // node, so XORing it with 'offset' gives its distance from group_id without converting its id.
+  const Uint512 group_id_value(group_id);
+  const Uint512 offset(kNodeIdValue_ ^ group_id_value);
+
+  // Gather the group_size + 1 smallest distances, smallest first.  The buffer is on the stack
+  // unless group_size has been set unusually high.
+  const size_t capacity(Parameters::group_size + 1U);
+  Uint512 stack_buffer[kHolderBufferSize];
+  std::vector<Uint512> heap_buffer;
+  Uint512* closest(stack_buffer);
+  if (capacity > kHolderBufferSize) {
+    heap_buffer.resize(capacity);
+    closest = &heap_buffer[0];
+  }
+  size_t count(0);
+  for (const auto& unique_node : unique_nodes_) {
+    const Uint512 distance(unique_node.first ^ offset);
+    if (count == capacity && !(distance < closest[count - 1]))
+      continue;
+    size_t position(count == capacity ? count - 1 : count++);
+    for (; position != 0 && distance < closest[position - 1]; --position)
+      closest[position] = closest[position - 1];
+    closest[position] = distance;
+  }
 
-  std::vector<NodeId> new_holders;
-  for (auto i : new_holders_info)
-    new_holders.push_back(i.node_id);
+  // The holders exclude group_id itself (at distance zero), leaving at most group_size.
+  const Uint512* holders_begin(closest);
+  const Uint512* const closest_end(closest + count);
+  if (count != 0 && closest[0].IsZero())
+    ++holders_begin;
+  const Uint512* holders_end(std::min(closest_end, holders_begin + Parameters::group_size));
+
+  // As GetProximalRange, but given the node's distance from group_id.
+  const bool group_is_this_node(offset.IsZero());
+  auto proximal_range([&](const Uint512& distance)->GroupRangeStatus {
+    if (group_is_this_node || distance.IsZero())
+      return GroupRangeStatus::kOutwithRange;
+    if (std::find(holders_begin, holders_end, distance) != holders_end)
+      return GroupRangeStatus::kInRange;
+    return (distance < radius_) ? GroupRangeStatus::kInProximalRange
+                                : GroupRangeStatus::kOutwithRange;
+  });
 
-  new_holders.erase(std::remove(new_holders.begin(), new_holders.end(), group_id),
-                    new_holders.end());
-  if (new_holders.size() > Parameters::group_size) {
-    new_holders.resize(Parameters::group_size);
-    assert(new_holders.size() == Parameters::group_size);
-  }
   if (!client_mode_) {
-    auto this_node_range(GetProximalRange(group_id, kNodeId_, kNodeId_, radius_, new_holders));
+    auto this_node_range(proximal_range(offset));
     if (node_id == kNodeId_)
       return this_node_range;
     else if (this_node_range != GroupRangeStatus::kInRange)
@@ -281,7 +291,7 @@ GroupRangeStatus GroupMatrix::IsNodeIdInGroupRange(const NodeId& group_id,
     if (node_id == kNodeId_)
       return GroupRangeStatus::kInProximalRange;
   }
-  return GetProximalRange(group_id, node_id, kNodeId_, radius_, new_holders);
+  return proximal_range(Uint512(node_id) ^ group_id_value);
 }
 
 std::shared_ptr<MatrixChange> GroupMatrix::UpdateFromConnectedPeer(
@@ -293,190 +303,273 @@ std::shared_ptr<MatrixChange> GroupMatrix::UpdateFromConnectedPeer(
     return std::make_shared<MatrixChange>(MatrixChange(kNodeId_, old_unique_ids, old_unique_ids));
   }
   // If peer is in my group
-  auto group_itr(std::begin(matrix_));
-  for (; group_itr != std::end(matrix_); ++group_itr) {
-    if (group_itr->begin()->node_id == peer)
-      break;
-  }
-
-  if (group_itr == std::end(matrix_)) {
+  size_t row(FindRow(peer));
+  if (row == connected_peers_.size()) {
     LOG(kWarning) << "Peer Node : " << DebugId(peer) << " is not in closest group of this node.";
     return std::make_shared<MatrixChange>(MatrixChange(kNodeId_, old_unique_ids, old_unique_ids));
   }
 
-  // Update peer's row
-  if (group_itr->size() > 1) {
-    group_itr->erase(group_itr->begin() + 1, group_itr->end());
-  }
-  for (const auto& i : nodes)
-    group_itr->push_back(i);
-
-  // Update unique node vector
+  ReplaceRowCells(row, nodes);
   Prune();
-  UpdateUniqueNodeList();
+  UpdateRadius();
+  RebuildHopIndex();
   return std::make_shared<MatrixChange>(MatrixChange(kNodeId_, old_unique_ids, GetUniqueNodeIds()));
 }
 
-bool GroupMatrix::GetRow(const NodeId& row_id, std::vector<NodeInfo>& row_entries) {
+bool GroupMatrix::GetRow(const NodeId& row_id, std::vector<NodeInfo>& row_entries) const {
   if (row_id.IsZero()) {
     assert(false && "Invalid node id.");
     return false;
   }
-  auto group_itr(std::begin(matrix_));
-  for (group_itr = std::begin(matrix_); group_itr != std::end(matrix_); ++group_itr) {
-    if ((*group_itr).at(0).node_id == row_id)
-      break;
-  }
-
-  if (group_itr == std::end(matrix_))
+  size_t row(FindRow(row_id));
+  if (row == connected_peers_.size())
     return false;
 
   row_entries.clear();
-  for (uint32_t i(0); i < (*group_itr).size(); ++i) {
-    if (i != 0) {
-      row_entries.push_back((*group_itr).at(i));
-    }
-  }
+  row_entries.reserve(RowCellCount(row));
+  for (auto itr(RowBegin(row)); itr != RowEnd(row); ++itr)
+    row_entries.push_back(itr->ToNodeInfo());
   return true;
 }
 
-std::vector<NodeInfo> GroupMatrix::GetUniqueNodes() const { return unique_nodes_; }
+std::vector<NodeInfo> GroupMatrix::GetUniqueNodes() const {
+  std::vector<NodeInfo> unique_nodes;
+  unique_nodes.reserve(unique_nodes_.size());
+  for (const auto& unique_node : unique_nodes_)
+    unique_nodes.push_back(unique_node.second.node_info);
+  return unique_nodes;
+}
 
 std::vector<NodeId> GroupMatrix::GetUniqueNodeIds() const {
   std::vector<NodeId> unique_node_ids;
-  for (auto& node_info : unique_nodes_)
-    unique_node_ids.push_back(node_info.node_id);
+  unique_node_ids.reserve(unique_nodes_.size());
+  for (const auto& unique_node : unique_nodes_)
+    unique_node_ids.push_back(unique_node.second.node_info.node_id);
   return unique_node_ids;
 }
 
-bool GroupMatrix::IsRowEmpty(const NodeInfo& node_info) {
-  auto group_itr(std::begin(matrix_));
-  for (; group_itr != std::end(matrix_); ++group_itr) {
-    if ((*group_itr).at(0).node_id == node_info.node_id)
-      break;
-  }
-  assert(group_itr != std::end(matrix_));
-  if (group_itr == std::end(matrix_))
+bool GroupMatrix::IsRowEmpty(const NodeInfo& node_info) const {
+  size_t row(FindRow(node_info.node_id));
+  assert(row != connected_peers_.size());
+  if (row == connected_peers_.size())
     return false;
 
-  return (group_itr->size() < 2);
+  return RowCellCount(row) == 0;
+}
+
+// unique_nodes_ is keyed by distance from kNodeId_.
+std::vector<NodeInfo> GroupMatrix::GetClosestNodes(uint16_t size) const {
+  std::vector<NodeInfo> closest_nodes;
+  for (auto itr(unique_nodes_.begin()); itr != unique_nodes_.end() && closest_nodes.size() < size;
+       ++itr) {
+    closest_nodes.push_back(itr->second.node_info);
+  }
+  return closest_nodes;
+}
+
+bool GroupMatrix::Contains(const NodeId& node_id) const {
+  return unique_nodes_.count(Uint512(node_id) ^ kNodeIdValue_) != 0;
+}
+
+NodeInfo GroupMatrix::MatrixCell::ToNodeInfo() const {
+  NodeInfo node_info;
+  node_info.node_id = node_id;
+  node_info.rank = rank;
+  return node_info;
+}
+
+size_t GroupMatrix::FindRow(const NodeId& peer_id) const {
+  size_t row(0);
+  while (row != connected_peers_.size() && connected_peers_[row].node_id != peer_id)
+    ++row;
+  return row;
+}
+
+bool GroupMatrix::RowContains(size_t row, const NodeId& node_id) const {
+  return std::find_if(RowBegin(row), RowEnd(row), [&node_id](const MatrixCell& cell) {
+           return cell.node_id == node_id;
+         }) != RowEnd(row);
+}
+
+void GroupMatrix::AppendRow(const NodeInfo& peer, const std::vector<NodeInfo>& entries) {
+  connected_peers_.push_back(peer);
+  AddUniqueNode(peer);
+  for (const auto& entry : entries) {
+    cells_.push_back(MatrixCell(entry));
+    AddUniqueNode(entry);
+  }
+  row_offsets_.push_back(cells_.size());
+}
+
+void GroupMatrix::EraseRow(size_t row) {
+  RemoveUniqueNode(connected_peers_[row].node_id);
+  for (auto itr(RowBegin(row)); itr != RowEnd(row); ++itr)
+    RemoveUniqueNode(itr->node_id);
+  size_t erased_count(RowCellCount(row));
+  cells_.erase(cells_.begin() + row_offsets_[row], cells_.begin() + row_offsets_[row + 1]);
+  row_offsets_.erase(row_offsets_.begin() + row + 1);
+  for (size_t i(row + 1); i < row_offsets_.size(); ++i)
+    row_offsets_[i] -= erased_count;
+  connected_peers_.erase(connected_peers_.begin() + row);
 }
 
-std::vector<NodeInfo> GroupMatrix::GetClosestNodes(uint16_t size) {
-  uint16_t size_to_sort(std::min(size, static_cast<uint16_t>(unique_nodes_.size())));
-  PartialSortFromTarget(kNodeId_, size_to_sort, unique_nodes_);
-  return std::vector<NodeInfo>(unique_nodes_.begin(), unique_nodes_.begin() + size_to_sort);
+void GroupMatrix::ReplaceRowCells(size_t row, const std::vector<NodeInfo>& entries) {
+  // The new entries are counted in before the old ones are counted out, so nodes in both stay in
+  // unique_nodes_ throughout.
+  for (const auto& entry : entries)
+    AddUniqueNode(entry);
+  for (auto itr(RowBegin(row)); itr != RowEnd(row); ++itr)
+    RemoveUniqueNode(itr->node_id);
+
+  size_t old_count(RowCellCount(row));
+  auto row_begin(cells_.erase(cells_.begin() + row_offsets_[row],
+                              cells_.begin() + row_offsets_[row + 1]));
+  std::vector<MatrixCell> new_cells;
+  new_cells.reserve(entries.size());
+  for (const auto& entry : entries)
+    new_cells.push_back(MatrixCell(entry));
+  cells_.insert(row_begin, new_cells.begin(), new_cells.end());
+  for (size_t i(row + 1); i < row_offsets_.size(); ++i)
+    row_offsets_[i] = row_offsets_[i] - old_count + entries.size();
 }
 
-bool GroupMatrix::Contains(const NodeId& node_id) {
-  return std::find_if(unique_nodes_.begin(), unique_nodes_.end(),
-                      [&node_id](const NodeInfo & node_info) {
-           return node_info.node_id == node_id;
-         }) != unique_nodes_.end();
+void GroupMatrix::AddUniqueNode(const NodeInfo& node_info) {
+  Uint512 key(Uint512(node_info.node_id) ^ kNodeIdValue_);
+  auto itr(unique_nodes_.lower_bound(key));
+  if (itr != unique_nodes_.end() && itr->first == key)
+    ++itr->second.occurrences;
+  else
+    unique_nodes_.insert(itr, std::make_pair(key, UniqueNode(node_info)));
 }
 
-void GroupMatrix::UpdateUniqueNodeList() {
-  std::set<NodeInfo, std::function<bool(const NodeInfo&, const NodeInfo&)>> sorted_to_owner([&](
-      const NodeInfo & lhs,
-      const NodeInfo & rhs) { return NodeId::CloserToTarget(lhs.node_id, rhs.node_id, kNodeId_); });
+void GroupMatrix::RemoveUniqueNode(const NodeId& node_id) {
+  auto found(unique_nodes_.find(Uint512(node_id) ^ kNodeIdValue_));
+  assert(found != unique_nodes_.end() && found->second.occurrences != 0);
+  if (found != unique_nodes_.end() && --found->second.occurrences == 0)
+    unique_nodes_.erase(found);
+}
+
+void GroupMatrix::UpdateRadius() {
   auto closest_nodes_size_adjust = Parameters::closest_nodes_size;
-  if (!client_mode_) {
-    NodeInfo node_info;
-    node_info.node_id = kNodeId_;
-    sorted_to_owner.insert(node_info);
+  if (!client_mode_)
     ++closest_nodes_size_adjust;
-  }
-  for (const auto& node_ids : matrix_) {
-    for (const auto& node_id : node_ids)
-      sorted_to_owner.insert(node_id);
-  }
-  unique_nodes_.assign(std::begin(sorted_to_owner), std::end(sorted_to_owner));
 
-  // Updating radius
-  NodeId fcn_distance;
   if (unique_nodes_.size() >= closest_nodes_size_adjust) {
-    fcn_distance = kNodeId_ ^ unique_nodes_[closest_nodes_size_adjust - 1].node_id;
-
-    radius_ =
-        (crypto::BigInt((fcn_distance.ToStringEncoded(NodeId::EncodingType::kHex) + 'h').c_str()) *
-         Parameters::proximity_factor);
+    // The key is the furthest close node's distance from this node.
+    auto furthest_close_node(std::next(unique_nodes_.begin(), closest_nodes_size_adjust - 1));
+    radius_ = MultiplySaturating(furthest_close_node->first, Parameters::proximity_factor);
   } else {
-    fcn_distance = NodeId(NodeId::kMaxId);  // FIXME Prakash
-    radius_ =
-        (crypto::BigInt((fcn_distance.ToStringEncoded(NodeId::EncodingType::kHex) + 'h').c_str()));
+    radius_ = Uint512::Max();  // FIXME Prakash
   }
 }
 
-void GroupMatrix::PartialSortFromTarget(const NodeId& target, uint16_t number,
-                                        std::vector<NodeInfo>& nodes) {
-  uint16_t count = std::min(number, static_cast<uint16_t>(nodes.size()));
-  std::partial_sort(nodes.begin(), nodes.begin() + count, nodes.end(),
-                    [target](const NodeInfo & lhs, const NodeInfo & rhs) {
-    return NodeId::CloserToTarget(lhs.node_id, rhs.node_id, target);
+void GroupMatrix::RebuildHopIndex() {
+  hop_index_.clear();
+  hop_index_.reserve(connected_peers_.size() + cells_.size());
+  for (size_t row(0); row != connected_peers_.size(); ++row) {
+    hop_index_.push_back(HopEntry(connected_peers_[row].node_id, row));
+    for (auto itr(RowBegin(row)); itr != RowEnd(row); ++itr)
+      hop_index_.push_back(HopEntry(itr->node_id, row));
+  }
+  std::sort(hop_index_.begin(), hop_index_.end(), [](const HopEntry& lhs, const HopEntry& rhs) {
+    return lhs.node_id < rhs.node_id || (lhs.node_id == rhs.node_id && lhs.row < rhs.row);
   });
 }
 
+size_t GroupMatrix::BestHop(const NodeId& target_id, const NodeIdSet* exclude,
+                            bool ignore_exact_match, NodeId& closest_id) const {
+  auto is_usable([&](const NodeId& node_id) {
+    return !(ignore_exact_match && node_id == target_id) &&
+           (exclude == nullptr || exclude->count(node_id) == 0);
+  });
+  auto get_id([](const HopEntry& entry)->const NodeId & { return entry.node_id; });
+
+  // Entries are visited closest to target_id first, so the first usable one answers the query.
+  // Most queries are settled within the first few entries; the search only widens when those are
+  // all passed over.
+  size_t count(std::min(hop_index_.size(),
+                        (exclude == nullptr ? 0 : exclude->size()) + Parameters::group_size));
+  size_t visited(0);
+  while (visited != hop_index_.size()) {
+    auto candidates(ClosestInSortedRange(hop_index_.begin(), hop_index_.end(), target_id, count,
+                                         get_id));
+    for (; visited != candidates.size(); ++visited) {
+      const NodeId& node_id(candidates[visited]->node_id);
+      if (!NodeId::CloserToTarget(node_id, closest_id, target_id))
+        return connected_peers_.size();
+      if (node_id == kNodeId_ || !is_usable(node_id))
+        continue;
+      // Entries for the same node are contiguous and ordered by row, so take the lowest usable row.
+      auto itr(candidates[visited]);
+      while (itr != hop_index_.begin() && std::prev(itr)->node_id == node_id)
+        --itr;
+      for (; itr != hop_index_.end() && itr->node_id == node_id; ++itr) {
+        if (is_usable(connected_peers_[itr->row].node_id)) {
+          closest_id = node_id;
+          return itr->row;
+        }
+      }
+    }
+    count = std::min(hop_index_.size(), count * 2);
+  }
+  return connected_peers_.size();
+}
+
 void GroupMatrix::Prune() {
-  if (matrix_.size() <= Parameters::closest_nodes_size)
+  if (connected_peers_.size() <= Parameters::closest_nodes_size)
     return;
-  NodeId node_id;
-  std::partial_sort(std::begin(matrix_), std::begin(matrix_) + Parameters::closest_nodes_size,
-                    std::end(matrix_), [this](const std::vector<NodeInfo>& lhs,
-                                              const std::vector<NodeInfo>& rhs) {
-                                         return NodeId::CloserToTarget(lhs.begin()->node_id,
-                                                                       rhs.begin()->node_id,
-                                                                       kNodeId_);
-                                       });
-  auto itr(std::begin(matrix_));
-  std::advance(itr, Parameters::closest_nodes_size);
-  while (itr != std::end(matrix_)) {
+  // Rows are ordered by their connected peer's distance from this node without being moved; the
+  // closest closest_nodes_size rows are always kept.
+  std::vector<size_t> rows(connected_peers_.size());
+  for (size_t row(0); row != rows.size(); ++row)
+    rows[row] = row;
+  PartialSortByDistance(rows.begin(), rows.begin() + Parameters::closest_nodes_size, rows.end(),
+                        kNodeId_, [this](size_t row)->const NodeId & {
+    return connected_peers_[row].node_id;
+  });
+
+  std::vector<size_t> rows_to_erase;
+  for (auto itr(rows.begin() + Parameters::closest_nodes_size); itr != rows.end(); ++itr) {
+    const size_t row(*itr);
+    const NodeId& node_id(connected_peers_[row].node_id);
     if (client_mode_) {
-      LOG(kInfo) << DebugId(kNodeId_) << " matrix conected removes "
-                 << DebugId(itr->begin()->node_id);
-      itr = matrix_.erase(itr);
+      LOG(kInfo) << DebugId(kNodeId_) << " matrix conected removes " << DebugId(node_id);
+      rows_to_erase.push_back(row);
       continue;
     }
-    node_id = itr->begin()->node_id;
-    if (itr->size() <= Parameters::closest_nodes_size) {
-      if (itr->size() > 1) {  // avoids removing the recently added node
+    // The row holds the connected peer plus its cells.
+    if (RowCellCount(row) < Parameters::closest_nodes_size) {
+      if (RowCellCount(row) != 0) {  // avoids removing the recently added node
         LOG(kInfo) << DebugId(kNodeId_) << " matrix conected removes " << DebugId(node_id);
-        itr = matrix_.erase(itr);
-      } else {
-        itr++;
+        rows_to_erase.push_back(row);
       }
       continue;
     }
-    std::sort(itr->begin() + 1, itr->end(), [node_id](const NodeInfo& lhs, const NodeInfo& rhs) {
-                                              return NodeId::CloserToTarget(lhs.node_id,
-                                                                            rhs.node_id, node_id);
-                                            });
-    if (NodeId::CloserToTarget(itr->at(Parameters::closest_nodes_size).node_id, kNodeId_,
+    auto row_begin(cells_.begin() + row_offsets_[row]);
+    SortByDistance(row_begin, cells_.begin() + row_offsets_[row + 1], node_id,
+                   [](const MatrixCell& cell)->const NodeId & { return cell.node_id; });
+    if (NodeId::CloserToTarget((row_begin + Parameters::closest_nodes_size - 1)->node_id, kNodeId_,
                                node_id) ||
-        (std::find_if(std::begin(*itr), std::end(*itr), [&](const NodeInfo& node_info) {
-                                                          return node_info.node_id == kNodeId_;
-                                                        }) == std::end(*itr))) {
-      LOG(kInfo) << DebugId(kNodeId_) << " matrix conected removes "
-                 << DebugId(itr->begin()->node_id);
-      itr = matrix_.erase(itr);
-    } else {
-      itr++;
+        !RowContains(row, kNodeId_)) {
+      LOG(kInfo) << DebugId(kNodeId_) << " matrix conected removes " << DebugId(node_id);
+      rows_to_erase.push_back(row);
     }
   }
-  PrintGroupMatrix();
+  // Erase from the last row back so the indices still to be erased stay valid.
+  std::sort(rows_to_erase.begin(), rows_to_erase.end(), std::greater<size_t>());
+  for (auto row : rows_to_erase)
+    EraseRow(row);
+  TRACE(kVerbose) << *this;
 }
 
-void GroupMatrix::PrintGroupMatrix() {
-  auto group_itr(std::begin(matrix_));
-  std::string tab("\t");
-  std::string output("Group matrix of node with NodeID: " + DebugId(kNodeId_));
-  for (group_itr = std::begin(matrix_); group_itr != std::end(matrix_); ++group_itr) {
-    output.append("\nGroup matrix row:");
-    for (const auto& elem : (*group_itr)) {
-      output.append(tab);
-      output.append(DebugId(elem.node_id));
-    }
+std::ostream& operator<<(std::ostream& stream, const GroupMatrix& group_matrix) {
+  stream << "Group matrix of node with NodeID: " << DebugId(group_matrix.kNodeId_);
+  for (size_t row(0); row != group_matrix.connected_peers_.size(); ++row) {
+    stream << "\nGroup matrix row:\t" << DebugId(group_matrix.connected_peers_[row].node_id);
+    for (auto itr(group_matrix.RowBegin(row)); itr != group_matrix.RowEnd(row); ++itr)
+      stream << '\t' << DebugId(itr->node_id);
   }
-  LOG(kVerbose) << output;
+  return stream;
 }
 
 }  // namespace routing
@@ -20,7 +20,9 @@
 #define MAIDSAFE_ROUTING_GROUP_MATRIX_H_
 
 #include <cstdint>
+#include <map>
 #include <mutex>
+#include <ostream>
 #include <vector>
 #include <string>
 
@@ -28,6 +30,8 @@
 #include "maidsafe/common/node_id.h"
 #include "maidsafe/routing/node_info.h"
 #include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/node_id_hash.h"
+#include "maidsafe/routing/uint512.h"
 
 namespace maidsafe {
 
@@ -46,6 +50,8 @@ struct NodeInfo;
 class GroupMatrix {
  public:
   explicit GroupMatrix(const NodeId& this_node_id, bool client_mode);
+  // Copies are taken for RoutingTable snapshots.
+  GroupMatrix(const GroupMatrix& other);
 
   std::shared_ptr<MatrixChange> AddConnectedPeer(
       const NodeInfo& node_info,
@@ -53,22 +59,23 @@ class GroupMatrix {
 
   std::shared_ptr<MatrixChange> RemoveConnectedPeer(const NodeInfo& node_info);
 
-  // Returns the connected peers sorted to node ids from kNodeId_
+  // Returns the connected peers, closest to kNodeId_ first.
   std::vector<NodeInfo> GetConnectedPeers() const;
 
   // Returns the peer which has target_info in its row (1st occurrence).
-  NodeInfo GetConnectedPeerFor(const NodeId& target_node_id);
+  NodeInfo GetConnectedPeerFor(const NodeId& target_node_id) const;
 
-  // Returns the peer which has node closest to target_id in its row (1st occurrence).
-  void GetBetterNodeForSendingMessage(const NodeId& target_node_id,
-                                      const std::vector<std::string>& exclude,
-                                      bool ignore_exact_match, NodeInfo& current_closest_peer);
+  // Returns the peer which has node closest to target_id in its row (1st occurrence).  Found via
+  // hop_index_ in O(log n) rather than by scanning every row.
+  void GetBetterNodeForSendingMessage(const NodeId& target_node_id, const NodeIdSet& exclude,
+                                      bool ignore_exact_match,
+                                      NodeInfo& current_closest_peer) const;
   void GetBetterNodeForSendingMessage(const NodeId& target_node_id, bool ignore_exact_match,
-                                      NodeId& current_closest_peer_id);
-  std::vector<NodeInfo> GetAllConnectedPeersFor(const NodeId& target_id);
-  bool IsThisNodeGroupLeader(const NodeId& target_id, NodeId& connected_peer);
+                                      NodeId& current_closest_peer_id) const;
+  std::vector<NodeInfo> GetAllConnectedPeersFor(const NodeId& target_id) const;
+  bool IsThisNodeGroupLeader(const NodeId& target_id, NodeId& connected_peer) const;
 
-  bool ClosestToId(const NodeId& target_id);
+  bool ClosestToId(const NodeId& target_id) const;
   //  bool IsNodeIdInGroupRange(const NodeId& group_id, const NodeId& node_id);
   GroupRangeStatus IsNodeIdInGroupRange(const NodeId& group_id, const NodeId& node_id) const;
   // Updates group matrix if peer is present in 1st column of matrix
@@ -77,32 +84,86 @@ class GroupMatrix {
                                                         const std::vector<NodeId>& old_unique_ids);
   void UpdateFromUnvalidatedPeer(const NodeId& peer, const std::vector<NodeInfo>& nodes);
 
-  bool IsRowEmpty(const NodeInfo& node_info);
-  bool GetRow(const NodeId& row_id, std::vector<NodeInfo>& row_entries);
+  bool IsRowEmpty(const NodeInfo& node_info) const;
+  bool GetRow(const NodeId& row_id, std::vector<NodeInfo>& row_entries) const;
   std::vector<NodeInfo> GetUniqueNodes() const;
   std::vector<NodeId> GetUniqueNodeIds() const;
-  std::vector<NodeInfo> GetClosestNodes(uint16_t size);
-  bool Contains(const NodeId& node_id);
+  std::vector<NodeInfo> GetClosestNodes(uint16_t size) const;
+  bool Contains(const NodeId& node_id) const;
   void Prune();
 
+  // Writes one line per row, for diagnostics.  LOG does the formatting even for a level the filter
+  // drops; only behind TRACE is it skipped.
+  friend std::ostream& operator<<(std::ostream& stream, const GroupMatrix& group_matrix);
   friend class RoutingTable;
   friend class test::GenericNode;
   friend class test::NetworkStatisticsTest_BEH_IsIdInGroupRange_Test;
   friend class test::GroupMatrixTest_BEH_Prune_Test;
 
  private:
-  GroupMatrix(const GroupMatrix&);
+  struct UniqueNode {
+    explicit UniqueNode(const NodeInfo& node_info_in) : node_info(node_info_in), occurrences(1) {}
+    NodeInfo node_info;
+    size_t occurrences;
+  };
+  // Keyed by distance from kNodeId_, so ordered closest first and holding each id once.
+  typedef std::map<Uint512, UniqueNode> UniqueNodes;
+  // An entry reported in a connected peer's row.  ClosestNodesUpdate only carries ids and ranks, so
+  // only those are kept; full NodeInfos are held for the connected peers alone.
+  struct MatrixCell {
+    explicit MatrixCell(const NodeInfo& node_info) : node_id(node_info.node_id),
+                                                     rank(node_info.rank) {}
+    NodeInfo ToNodeInfo() const;
+    NodeId node_id;
+    int32_t rank;
+  };
+  typedef std::vector<MatrixCell>::const_iterator CellIterator;
+  // An occurrence of a node in a row, including the row's connected peer in its own row.
+  struct HopEntry {
+    HopEntry(const NodeId& node_id_in, size_t row_in) : node_id(node_id_in), row(row_in) {}
+    NodeId node_id;
+    size_t row;
+  };
+
   GroupMatrix& operator=(const GroupMatrix&);
-  void UpdateUniqueNodeList();
-  void PartialSortFromTarget(const NodeId& target, uint16_t number,
-                             std::vector<NodeInfo>& nodes);
-  void PrintGroupMatrix();
-
-  const NodeId& kNodeId_;
-  std::vector<NodeInfo> unique_nodes_;
-  crypto::BigInt radius_;
+  // Returns the index of the row whose connected peer is 'peer_id', or the number of rows if none.
+  size_t FindRow(const NodeId& peer_id) const;
+  CellIterator RowBegin(size_t row) const { return cells_.begin() + row_offsets_[row]; }
+  CellIterator RowEnd(size_t row) const { return cells_.begin() + row_offsets_[row + 1]; }
+  size_t RowCellCount(size_t row) const { return row_offsets_[row + 1] - row_offsets_[row]; }
+  bool RowContains(size_t row, const NodeId& node_id) const;
+  void AppendRow(const NodeInfo& peer, const std::vector<NodeInfo>& entries);
+  void EraseRow(size_t row);
+  void ReplaceRowCells(size_t row, const std::vector<NodeInfo>& entries);
+  // Count a node in or out as it joins or leaves the matrix.  A node stays in unique_nodes_ until its
+  // last occurrence leaves.
+  void AddUniqueNode(const NodeInfo& node_info);
+  void RemoveUniqueNode(const NodeId& node_id);
+  void UpdateRadius();
+  void RebuildHopIndex();
+  // Returns the lowest row holding the node closest to target_id which is strictly closer than
+  // closest_id, updating closest_id to that node, or the number of rows if there is no such node.
+  // This node, excluded nodes and rows whose peer is excluded are passed over, as is target_id if
+  // ignore_exact_match is set.
+  size_t BestHop(const NodeId& target_id, const NodeIdSet* exclude, bool ignore_exact_match,
+                 NodeId& closest_id) const;
+
+  const NodeId kNodeId_;
+  const Uint512 kNodeIdValue_;
+  // Every node in the matrix, plus this node unless in client mode, kept in step with the rows by
+  // their modifiers rather than being rebuilt from all rows after each change.
+  UniqueNodes unique_nodes_;
+  Uint512 radius_;
   bool client_mode_;
-  std::vector<std::vector<NodeInfo>> matrix_;
+  // Row i is connected_peers_[i] followed by cells_[row_offsets_[i]] up to (but excluding)
+  // cells_[row_offsets_[i + 1]].  Rows are stored back to back so a scan of the whole matrix runs
+  // over one contiguous array.
+  std::vector<NodeInfo> connected_peers_;
+  std::vector<MatrixCell> cells_;
+  std::vector<size_t> row_offsets_;
+  // Every HopEntry of the matrix sorted by node id, then row.  Rebuilt whenever the rows change,
+  // which is far less often than messages are routed through them.
+  std::vector<HopEntry> hop_index_;
 };
 
 }  // namespace routing
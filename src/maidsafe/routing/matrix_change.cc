@@ -18,39 +18,63 @@
 
 #include "maidsafe/routing/matrix_change.h"
 
+#include <algorithm>
+#include <future>
+#include <iterator>
 #include <limits>
 #include <utility>
 
+#include "maidsafe/routing/distance_sort.h"
 #include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/sorted_id_lookup.h"
 #include "maidsafe/routing/utils.h"
 
 namespace maidsafe {
 
 namespace routing {
 
+namespace {
+
+Uint512 XorOfIds(const std::vector<NodeId>& ids) {
+  Uint512 result;
+  for (const auto& id : ids)
+    result ^= Uint512(id);
+  return result;
+}
+
+// Returns up to group_size of the ids closest to 'target', excluding 'target' itself.
+std::vector<NodeId> Holders(const std::vector<NodeId>& sorted_ids, const NodeId& target) {
+  auto closest(ClosestInSortedRange(sorted_ids.begin(), sorted_ids.end(), target,
+                                    Parameters::group_size + 1U, IdOf()));
+  std::vector<NodeId> holders;
+  holders.reserve(closest.size());
+  for (const auto& itr : closest) {
+    if (*itr != target)
+      holders.push_back(*itr);
+  }
+  if (holders.size() > Parameters::group_size)
+    holders.resize(Parameters::group_size);
+  return holders;
+}
+
+}  // unnamed namespace
+
 MatrixChange::MatrixChange()
-    : node_id_(),
-      old_matrix_(),
-      new_matrix_(),
-      lost_nodes_(),
-      new_nodes_(),
-      radius_() {}
+    : node_id_(), old_ids_(), new_ids_(), may_be_equal_(true), derived_() {}
 
 MatrixChange::MatrixChange(const MatrixChange& other)
     : node_id_(other.node_id_),
-      old_matrix_(other.old_matrix_),
-      new_matrix_(other.new_matrix_),
-      lost_nodes_(other.lost_nodes_),
-      new_nodes_(other.new_nodes_),
-      radius_(other.radius_) {}
+      old_ids_(other.old_ids_),
+      new_ids_(other.new_ids_),
+      may_be_equal_(other.may_be_equal_),
+      derived_(std::atomic_load(&other.derived_)) {}
 
 MatrixChange::MatrixChange(MatrixChange&& other)
     : node_id_(std::move(other.node_id_)),
-      old_matrix_(std::move(other.old_matrix_)),
-      new_matrix_(std::move(other.new_matrix_)),
-      lost_nodes_(std::move(other.lost_nodes_)),
-      new_nodes_(std::move(other.new_nodes_)),
-      radius_(std::move(other.radius_)) {}
+      old_ids_(std::move(other.old_ids_)),
+      new_ids_(std::move(other.new_ids_)),
+      may_be_equal_(other.may_be_equal_),
+      derived_(std::move(other.derived_)) {}
 
 MatrixChange& MatrixChange::operator=(MatrixChange other) {
   swap(*this, other);
@@ -60,106 +84,144 @@ MatrixChange& MatrixChange::operator=(MatrixChange other) {
 MatrixChange::MatrixChange(NodeId this_node_id, const std::vector<NodeId>& old_matrix,
                            const std::vector<NodeId>& new_matrix)
     : node_id_(std::move(this_node_id)),
-      old_matrix_([this](std::vector<NodeId> old_matrix_in)->std::vector<NodeId> {
-        std::sort(std::begin(old_matrix_in), std::end(old_matrix_in),
-                  [this](const NodeId & lhs, const NodeId & rhs) {
-          return NodeId::CloserToTarget(lhs, rhs, node_id_);
-        });
-        return old_matrix_in;
-      }(old_matrix)),
-      new_matrix_([this](std::vector<NodeId> new_matrix_in)->std::vector<NodeId> {
-        std::sort(std::begin(new_matrix_in), std::end(new_matrix_in),
-                  [this](const NodeId & lhs, const NodeId & rhs) {
-          return NodeId::CloserToTarget(lhs, rhs, node_id_);
-        });
-        return new_matrix_in;
-      }(new_matrix)),
-      lost_nodes_([this]()->std::vector<NodeId> {
-        std::vector<NodeId> lost_nodes;
-        std::set_difference(std::begin(old_matrix_), std::end(old_matrix_), std::begin(new_matrix_),
-                            std::end(new_matrix_), std::back_inserter(lost_nodes),
-                            [this](const NodeId & lhs, const NodeId & rhs) {
-          return NodeId::CloserToTarget(lhs, rhs, node_id_);
-        });
-        return lost_nodes;
-      }()),
-      new_nodes_([this]()->std::vector<NodeId> {
-        std::vector<NodeId> new_nodes;
-        std::set_difference(std::begin(new_matrix_), std::end(new_matrix_), std::begin(old_matrix_),
-                            std::end(old_matrix_), std::back_inserter(new_nodes),
-                            [this](const NodeId & lhs, const NodeId & rhs) {
-          return NodeId::CloserToTarget(lhs, rhs, node_id_);
-        });
-        return new_nodes;
-      }()),
-      radius_([this]()->crypto::BigInt {
-        NodeId fcn_distance;
-        if (new_matrix_.size() >= Parameters::closest_nodes_size)
-          fcn_distance = node_id_ ^ new_matrix_[Parameters::closest_nodes_size - 1];
-        else
-          fcn_distance = node_id_ ^ (NodeId(NodeId::kMaxId));  // FIXME
-        return (crypto::BigInt(
-                    (fcn_distance.ToStringEncoded(NodeId::EncodingType::kHex) + 'h').c_str()) *
-                Parameters::proximity_factor);
-      }()) {}
+      old_ids_(old_matrix),
+      new_ids_(new_matrix),
+      may_be_equal_(old_ids_.size() == new_ids_.size() &&
+                    XorOfIds(old_ids_) == XorOfIds(new_ids_)),
+      derived_() {}
+
+std::shared_ptr<const MatrixChange::Derived> MatrixChange::Derive() const {
+  std::shared_ptr<const Derived> derived(std::atomic_load(&derived_));
+  if (derived)
+    return derived;
+
+  // Concurrent first callers may each build this; the results are identical, so whichever is
+  // stored last is kept.
+  std::shared_ptr<Derived> built(std::make_shared<Derived>());
+  built->old_matrix = old_ids_;
+  built->new_matrix = new_ids_;
+  std::sort(std::begin(built->old_matrix), std::end(built->old_matrix));
+  std::sort(std::begin(built->new_matrix), std::end(built->new_matrix));
+  std::set_difference(std::begin(built->old_matrix), std::end(built->old_matrix),
+                      std::begin(built->new_matrix), std::end(built->new_matrix),
+                      std::back_inserter(built->lost_nodes));
+  std::set_difference(std::begin(built->new_matrix), std::end(built->new_matrix),
+                      std::begin(built->old_matrix), std::end(built->old_matrix),
+                      std::back_inserter(built->new_nodes));
+  SortByDistance(std::begin(built->lost_nodes), std::end(built->lost_nodes), node_id_);
+  SortByDistance(std::begin(built->new_nodes), std::end(built->new_nodes), node_id_);
+
+  std::vector<NodeId> all_ids;
+  std::set_union(std::begin(built->old_matrix), std::end(built->old_matrix),
+                 std::begin(built->new_matrix), std::end(built->new_matrix),
+                 std::back_inserter(all_ids));
+  for (size_t i(1); i < all_ids.size(); ++i) {
+    built->distinguishing_bits = std::max(
+        built->distinguishing_bits,
+        detail::FirstDifferingBit(all_ids[i - 1].string(), all_ids[i].string()) + 1);
+  }
+
+  auto closest(ClosestInSortedRange(std::begin(built->new_matrix), std::end(built->new_matrix),
+                                    node_id_, Parameters::closest_nodes_size, IdOf()));
+  NodeId fcn_distance;
+  if (closest.size() == Parameters::closest_nodes_size)
+    fcn_distance = node_id_ ^ *closest.back();
+  else
+    fcn_distance = node_id_ ^ (NodeId(NodeId::kMaxId));  // FIXME
+  built->radius = MultiplySaturating(Uint512(fcn_distance), Parameters::proximity_factor);
+
+  derived = built;
+  std::atomic_store(&derived_, derived);
+  return derived;
+}
 
 CheckHoldersResult MatrixChange::CheckHolders(const NodeId& target) const {
-  // Handle cases of lower number of group matrix nodes
-  size_t group_size_adjust(Parameters::group_size + 1U);
-  size_t old_holders_size = std::min(old_matrix_.size(), group_size_adjust);
-  size_t new_holders_size = std::min(new_matrix_.size(), group_size_adjust);
-
-  std::vector<NodeId> old_holders(old_holders_size), new_holders(new_holders_size),
-      lost_nodes(lost_nodes_);
-  std::partial_sort_copy(std::begin(old_matrix_), std::end(old_matrix_), std::begin(old_holders),
-                         std::end(old_holders), [target](const NodeId & lhs, const NodeId & rhs) {
-    return NodeId::CloserToTarget(lhs, rhs, target);
-  });
-  std::partial_sort_copy(std::begin(new_matrix_), std::end(new_matrix_), std::begin(new_holders),
-                         std::end(new_holders), [target](const NodeId & lhs, const NodeId & rhs) {
-    return NodeId::CloserToTarget(lhs, rhs, target);
-  });
-  std::sort(std::begin(lost_nodes), std::end(lost_nodes),
-            [target](const NodeId & lhs, const NodeId & rhs) {
-    return NodeId::CloserToTarget(lhs, rhs, target);
+  return CheckHolders(*Derive(), target);
+}
+
+std::vector<CheckHoldersResult> MatrixChange::CheckHolders(const std::vector<NodeId>& targets,
+                                                           unsigned worker_count) const {
+  Derive();
+  std::vector<CheckHoldersResult> results(targets.size());
+  auto check_part([&](size_t begin, size_t end) {
+    CheckHoldersCursor cursor(*this);
+    for (size_t i(begin); i != end; ++i)
+      results[i] = cursor.CheckHolders(targets[i]);
   });
 
-  // Remove target == node ids and adjust holder size
-  old_holders.erase(std::remove(std::begin(old_holders), std::end(old_holders), target),
-                    std::end(old_holders));
-  if (old_holders.size() > Parameters::group_size) {
-    old_holders.resize(Parameters::group_size);
-    assert(old_holders.size() == Parameters::group_size);
+  worker_count = std::max(1U, std::min(worker_count, static_cast<unsigned>(targets.size())));
+  const size_t part_size(targets.size() / worker_count);
+  std::vector<std::future<void>> parts;
+  for (unsigned worker(1); worker < worker_count; ++worker) {
+    parts.push_back(std::async(std::launch::async, check_part, worker * part_size,
+                               worker + 1 == worker_count ? targets.size()
+                                                          : (worker + 1) * part_size));
   }
-  new_holders.erase(std::remove(std::begin(new_holders), std::end(new_holders), target),
-                    std::end(new_holders));
-  if (new_holders.size() > Parameters::group_size) {
-    new_holders.resize(Parameters::group_size);
-    assert(new_holders.size() == Parameters::group_size);
-  }
-  lost_nodes.erase(std::remove(std::begin(lost_nodes), std::end(lost_nodes), target),
-                   std::end(lost_nodes));
+  check_part(0, worker_count == 1 ? targets.size() : part_size);
+  for (auto& part : parts)
+    part.get();
+  return results;
+}
+
+CheckHoldersResult MatrixChange::CheckHolders(const Derived& derived,
+                                              const NodeId& target) const {
+  // Handle cases of lower number of group matrix nodes.  Both are ordered closest to target first.
+  std::vector<NodeId> old_holders(Holders(derived.old_matrix, target)),
+      new_holders(Holders(derived.new_matrix, target));
 
   CheckHoldersResult holders_result;
   holders_result.proximity_status =
-      GetProximalRange(target, node_id_, node_id_, radius_, new_holders);
+      GetProximalRange(target, node_id_, node_id_, derived.radius, new_holders);
   // Only return holders if this node is part of target group
   if (GroupRangeStatus::kInRange != holders_result.proximity_status)
     return holders_result;
 
-  // Old holders = Old holder ∩ Lost nodes
-  std::set_intersection(std::begin(old_holders), std::end(old_holders), std::begin(lost_nodes),
-                        std::end(lost_nodes), std::back_inserter(holders_result.old_holders),
-                        [target](const NodeId & lhs, const NodeId & rhs) {
-    return NodeId::CloserToTarget(lhs, rhs, target);
-  });
+  // Old holders = Old holder ∩ Lost nodes, i.e. the old holders missing from the new matrix
+  for (const auto& holder : old_holders) {
+    if (!std::binary_search(std::begin(derived.new_matrix), std::end(derived.new_matrix), holder))
+      holders_result.old_holders.push_back(holder);
+  }
 
   // New holders = All new holders - Old holders
-  std::set_difference(std::begin(new_holders), std::end(new_holders), std::begin(old_holders),
-                      std::end(old_holders), std::back_inserter(holders_result.new_holders),
-                      [target](const NodeId & lhs, const NodeId & rhs) {
-    return NodeId::CloserToTarget(lhs, rhs, target);
-  });
+  for (const auto& holder : new_holders) {
+    if (std::find(std::begin(old_holders), std::end(old_holders), holder) == std::end(old_holders))
+      holders_result.new_holders.push_back(holder);
+  }
+  return holders_result;
+}
+
+CheckHoldersCursor::CheckHoldersCursor(const MatrixChange& matrix_change)
+    : kMatrixChange_(matrix_change),
+      kDerived_(matrix_change.Derive()),
+      kNodeIdValue_(matrix_change.node_id_),
+      region_target_(),
+      region_result_() {}
+
+CheckHoldersResult CheckHoldersCursor::CheckHolders(const NodeId& target) {
+  const MatrixChange::Derived& derived(*kDerived_);
+  // Holders exclude the target itself, so targets in either matrix are always looked up in full.
+  if (target == kMatrixChange_.node_id_ ||
+      std::binary_search(std::begin(derived.old_matrix), std::end(derived.old_matrix), target) ||
+      std::binary_search(std::begin(derived.new_matrix), std::end(derived.new_matrix), target)) {
+    return kMatrixChange_.CheckHolders(derived, target);
+  }
+
+  std::string raw_target(target.string());
+  if (region_target_.empty() ||
+      detail::FirstDifferingBit(raw_target, region_target_) < derived.distinguishing_bits) {
+    region_result_ = kMatrixChange_.CheckHolders(derived, target);
+    region_target_.swap(raw_target);
+    return region_result_;
+  }
+
+  // Same holders as the region's last full lookup.  Only if this node is not one of them does the
+  // result depend on the target, as for GetProximalRange.
+  if (region_result_.proximity_status == GroupRangeStatus::kInRange)
+    return region_result_;
+  CheckHoldersResult holders_result;
+  holders_result.proximity_status = ((kNodeIdValue_ ^ Uint512(target)) < derived.radius)
+                                        ? GroupRangeStatus::kInProximalRange
+                                        : GroupRangeStatus::kOutwithRange;
   return holders_result;
 }
 
@@ -169,7 +231,7 @@ NodeId MatrixChange::ChoosePmidNode(const std::set<NodeId>& online_pmids,
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
 
   LOG(kInfo) << "MatrixChange::ChoosePmidNode having following new_matrix_ : ";
-  for (auto id : new_matrix_)
+  for (auto id : new_ids_)
     LOG(kInfo) << "       new_matrix_ ids     ---  " << HexSubstr(id.string());
   LOG(kInfo) << "MatrixChange::ChoosePmidNode having target : "
                 << HexSubstr(target.string()) << " and following online_pmids : ";
@@ -179,10 +241,8 @@ NodeId MatrixChange::ChoosePmidNode(const std::set<NodeId>& online_pmids,
   // In case storing to PublicPmid, the data shall not be stored on the Vault itself
   // However, the vault will appear in DM's routing table and affect result
   std::vector<NodeId> temp(Parameters::group_size + 1);
-  std::partial_sort_copy(std::begin(new_matrix_), std::end(new_matrix_), std::begin(temp),
-                         std::end(temp), [&target](const NodeId& lhs, const NodeId& rhs) {
-    return NodeId::CloserToTarget(lhs, rhs, target);
-  });
+  PartialSortCopyByDistance(std::begin(new_ids_), std::end(new_ids_), std::begin(temp),
+                            std::end(temp), target);
 
   LOG(kInfo) << "MatrixChange::ChoosePmidNode own id : "
                 << HexSubstr(node_id_.string()) << " and closest+1 to the target are : ";
@@ -202,34 +262,40 @@ NodeId MatrixChange::ChoosePmidNode(const std::set<NodeId>& online_pmids,
 }
 
 bool MatrixChange::OldEqualsToNew() const {
-  return old_matrix_ == new_matrix_;
+  if (!may_be_equal_)
+    return false;
+  if (old_ids_ == new_ids_)
+    return true;
+  auto derived(Derive());
+  return derived->old_matrix == derived->new_matrix;
 }
 
 void swap(MatrixChange& lhs, MatrixChange& rhs) MAIDSAFE_NOEXCEPT {
   using std::swap;
   swap(lhs.node_id_, rhs.node_id_);
-  swap(lhs.old_matrix_, rhs.old_matrix_);
-  swap(lhs.new_matrix_, rhs.new_matrix_);
-  swap(lhs.lost_nodes_, rhs.lost_nodes_);
-  swap(lhs.radius_, rhs.radius_);
+  swap(lhs.old_ids_, rhs.old_ids_);
+  swap(lhs.new_ids_, rhs.new_ids_);
+  swap(lhs.may_be_equal_, rhs.may_be_equal_);
+  swap(lhs.derived_, rhs.derived_);
 }
 
 void MatrixChange::Print() {
+  auto derived(Derive());
   std::string tab("\t"), output("\nMatrix of Node " + DebugId(node_id_) +
                                 " having following entries in old_matrix_ :");
-  for (auto entry : old_matrix_)
+  for (auto entry : derived->old_matrix)
     output.append("\n" + tab + tab+ "entry in old_matrix" + tab + "------" + tab + DebugId(entry));
   output.append("\nMatrix of Node " + DebugId(node_id_) +
                 " having following entries in new_matrix_ :");
-  for (auto entry : new_matrix_)
+  for (auto entry : derived->new_matrix)
     output.append("\n" + tab + tab+ "entry in new_matrix" + tab + "------" + tab + DebugId(entry));
   output.append("\nMatrix of Node " + DebugId(node_id_) +
                 " having following entries in lost_nodes_ :");
-  for (auto entry : lost_nodes_)
+  for (auto entry : derived->lost_nodes)
     output.append("\n" + tab + tab+ "entry in lost_nodes" + tab + "------" + tab + DebugId(entry));
   output.append("\nMatrix of Node " + DebugId(node_id_) +
                 " having following entries in new_nodes_ :");
-  for (auto entry : new_nodes_)
+  for (auto entry : derived->new_nodes)
     output.append("\n" + tab + tab+ "entry in new_nodes" + tab + "------" + tab + DebugId(entry));
   LOG(kInfo) << output;
 }
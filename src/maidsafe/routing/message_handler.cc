@@ -26,11 +26,13 @@
 #include "maidsafe/routing/client_routing_table.h"
 #include "maidsafe/routing/group_change_handler.h"
 #include "maidsafe/routing/message.h"
+#include "maidsafe/routing/message_header.h"
 #include "maidsafe/routing/network_utils.h"
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/routing_table.h"
 #include "maidsafe/routing/service.h"
 #include "maidsafe/routing/remove_furthest_node.h"
+#include "maidsafe/routing/trace.h"
 #include "maidsafe/routing/utils.h"
 
 namespace maidsafe {
@@ -173,7 +175,7 @@ void MessageHandler::HandleNodeLevelMessageForThisNode(protobuf::Message& messag
                   << ")  --NodeLevel--";
     ReplyFunctor response_functor = [=](const std::string & reply_message) {
       if (reply_message.empty()) {
-        LOG(kInfo) << "Empty response for message id :" << message.id();
+        TRACE(kInfo) << "Empty response for message id :" << message.id();
         return;
       }
       LOG(kSuccess) << " [" << DebugId(routing_table_.kNodeId())
@@ -195,7 +197,7 @@ void MessageHandler::HandleNodeLevelMessageForThisNode(protobuf::Message& messag
       if (message.has_id())
         message_out.set_id(message.id());
       else
-        LOG(kInfo) << "Message to be sent back had no ID.";
+        TRACE(kInfo) << "Message to be sent back had no ID.";
 
       if (message.has_relay_id())
         message_out.set_relay_id(message.relay_id());
@@ -211,8 +213,8 @@ void MessageHandler::HandleNodeLevelMessageForThisNode(protobuf::Message& messag
       if (routing_table_.kNodeId().string() != message_out.destination_id()) {
         network_.SendToClosestNode(message_out);
       } else {
-        LOG(kInfo) << "Sending response to self."
-                   << " id: " << message.id();
+        TRACE(kInfo) << "Sending response to self."
+                     << " id: " << message.id();
         HandleMessage(message_out);
       }
     };
@@ -221,10 +223,10 @@ void MessageHandler::HandleNodeLevelMessageForThisNode(protobuf::Message& messag
     else
       InvokeTypedMessageReceivedFunctor(message);  // typed message received
   } else if (IsResponse(message)) {                // response
-    LOG(kInfo) << "[" << DebugId(routing_table_.kNodeId())
-               << "] rcvd : " << MessageTypeString(message) << " from "
-               << HexSubstr(message.source_id()) << "   (id: " << message.id()
-               << ")  --NodeLevel--";
+    TRACE(kInfo) << "[" << DebugId(routing_table_.kNodeId())
+                 << "] rcvd : " << MessageTypeString(message) << " from "
+                 << HexSubstr(message.source_id()) << "   (id: " << message.id()
+                 << ")  --NodeLevel--";
     try {
       if (!message.has_id() || message.data_size() != 1)
         BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
@@ -248,37 +250,39 @@ void MessageHandler::HandleMessageForThisNode(protobuf::Message& message) {
   if (RelayDirectMessageIfNeeded(message))
     return;
 
-  LOG(kVerbose) << "Message for this node."
-                << " id: " << message.id();
+  TRACE(kVerbose) << "Message for this node."
+                  << " id: " << message.id();
   if (IsRoutingMessage(message))
     HandleRoutingMessage(message);
   else
     HandleNodeLevelMessageForThisNode(message);
 }
 
-void MessageHandler::HandleMessageAsClosestNode(protobuf::Message& message) {
-  LOG(kVerbose) << "This node is in closest proximity to this message destination ID [ "
-                << HexSubstr(message.destination_id()) << " ]."
-                << " id: " << message.id();
+void MessageHandler::HandleMessageAsClosestNode(protobuf::Message& message,
+                                                const RouteDecision& route) {
+  TRACE(kVerbose) << "This node is in closest proximity to this message destination ID [ "
+                  << HexSubstr(message.destination_id()) << " ]."
+                  << " id: " << message.id();
   if (IsDirect(message)) {
-    return HandleDirectMessageAsClosestNode(message);
+    return HandleDirectMessageAsClosestNode(message, route);
   } else {
-    return HandleGroupMessageAsClosestNode(message);
+    return HandleGroupMessageAsClosestNode(message, route);
   }
 }
 
-void MessageHandler::HandleDirectMessageAsClosestNode(protobuf::Message& message) {
+void MessageHandler::HandleDirectMessageAsClosestNode(protobuf::Message& message,
+                                                      const RouteDecision& route) {
   assert(message.direct());
   // Dropping direct messages if this node is closest and destination node is not in routing_table_
   // or client_routing_table_.
-  NodeId destination_node_id(message.destination_id());
-  if (routing_table_.IsThisNodeClosestToIncludingMatrix(destination_node_id)) {
-    if (routing_table_.Contains(destination_node_id) ||
-        client_routing_table_.Contains(destination_node_id)) {
+  if (route.snapshot->IsThisNodeClosestToIncludingMatrix(route)) {
+    if (route.destination_in_table) {
+      return network_.SendToClosestNode(message, route);
+    } else if (client_routing_table_.Contains(route.destination_id)) {
       return network_.SendToClosestNode(message);
     } else if (!message.has_visited() || !message.visited()) {
       message.set_visited(true);
-      return network_.SendToClosestNode(message);
+      return network_.SendToClosestNode(message, route);
     } else {
       LOG(kWarning) << "Dropping message. This node [" << DebugId(routing_table_.kNodeId())
                     << "] is the closest but is not connected to destination node ["
@@ -294,31 +298,29 @@ void MessageHandler::HandleDirectMessageAsClosestNode(protobuf::Message& message
     // else if (IsCacheableResponse(message))
     //   StoreCacheCopy(message);  //  Upper layer should take this on seperate thread
 
-    return network_.SendToClosestNode(message);
+    return network_.SendToClosestNode(message, route);
   }
 }
 
-void MessageHandler::HandleGroupMessageAsClosestNode(protobuf::Message& message) {
+void MessageHandler::HandleGroupMessageAsClosestNode(protobuf::Message& message,
+                                                     const RouteDecision& route) {
   assert(!message.direct());
-  bool have_node_with_group_id(routing_table_.Contains(NodeId(message.destination_id())));
   // This node is not closest to the destination node for non-direct message.
-  if (!routing_table_.IsThisNodeClosestTo(NodeId(message.destination_id()), !IsDirect(message)) &&
-      !have_node_with_group_id) {
-    LOG(kInfo) << "This node is not closest, passing it on."
-               << " id: " << message.id();
+  if (!route.this_node_closest && !route.destination_in_table) {
+    TRACE(kInfo) << "This node is not closest, passing it on."
+                 << " id: " << message.id();
     // if (IsCacheableRequest(message))
     //   return HandleCacheLookup(message);  // forwarding message is done by cache manager
     // else if (IsCacheableResponse(message))
     //   StoreCacheCopy(message);  // Upper layer should take this on seperate thread
-    return network_.SendToClosestNode(message);
+    return network_.SendToClosestNode(message, route);
   }
 
   if (message.has_visited() && !message.visited() &&
-      (routing_table_.size() > Parameters::closest_nodes_size) &&
-      (!routing_table_.IsThisNodeInRange(NodeId(message.destination_id()),
-                                         Parameters::closest_nodes_size))) {
+      (route.snapshot->size() > Parameters::closest_nodes_size) &&
+      !route.this_node_in_close_range) {
     message.set_visited(true);
-    return network_.SendToClosestNode(message);
+    return network_.SendToClosestNode(message, route);
   }
 
   std::vector<std::string> route_history;
@@ -332,9 +334,9 @@ void MessageHandler::HandleGroupMessageAsClosestNode(protobuf::Message& message)
   // Confirming from group matrix. If this node is closest to the target id or else passing on to
   // the connected peer which has the closer node.
   NodeInfo closest_to_group_leader_node;
-  if (!routing_table_.IsThisNodeGroupLeader(NodeId(message.destination_id()),
-                                            closest_to_group_leader_node, route_history)) {
-    assert(NodeId(message.destination_id()) != closest_to_group_leader_node.node_id);
+  if (!route.snapshot->IsThisNodeGroupLeader(route.destination_id, closest_to_group_leader_node,
+                                             route_history)) {
+    assert(route.destination_id != closest_to_group_leader_node.node_id);
     return network_.SendToDirectAdjustedRoute(message, closest_to_group_leader_node.node_id,
                                               closest_to_group_leader_node.connection_id);
   }
@@ -350,7 +352,7 @@ void MessageHandler::HandleGroupMessageAsClosestNode(protobuf::Message& message)
   --replication;  // Will send to self as well
   message.set_direct(true);
   message.clear_route_history();
-  NodeId destination_id(message.destination_id());
+  const NodeId& destination_id(route.destination_id);
   NodeId own_node_id(routing_table_.kNodeId());
   auto close_from_matrix(routing_table_.GetClosestMatrixNodes(destination_id, replication + 2));
   close_from_matrix.erase(std::remove_if(close_from_matrix.begin(), close_from_matrix.end(),
@@ -367,52 +369,54 @@ void MessageHandler::HandleGroupMessageAsClosestNode(protobuf::Message& message)
     close_from_matrix.pop_back();
 
   std::string group_id(message.destination_id());
-  std::string group_members("[" + DebugId(routing_table_.kNodeId()) + "]");
-
-  for (const auto& i : close_from_matrix)
-    group_members += std::string("[" + DebugId(i.node_id) + "]");
-  LOG(kInfo) << "Group nodes for group_id " << HexSubstr(group_id) << " : " << group_members;
+  if (TraceEnabled(kInfo)) {
+    std::string group_members("[" + DebugId(routing_table_.kNodeId()) + "]");
+    for (const auto& i : close_from_matrix)
+      group_members += std::string("[" + DebugId(i.node_id) + "]");
+    TRACE(kInfo) << "Group nodes for group_id " << HexSubstr(group_id) << " : " << group_members;
+  }
 
+  std::vector<NodeInfo> connected_replicants;
   for (const auto& i : close_from_matrix) {
-    LOG(kInfo) << "[" << DebugId(own_node_id) << "] - "
-               << "Replicating message to : " << HexSubstr(i.node_id.string())
-               << " [ group_id : " << HexSubstr(group_id) << "]"
-               << " id: " << message.id();
-    message.set_destination_id(i.node_id.string());
+    TRACE(kInfo) << "[" << DebugId(own_node_id) << "] - "
+                 << "Replicating message to : " << HexSubstr(i.node_id.string())
+                 << " [ group_id : " << HexSubstr(group_id) << "]"
+                 << " id: " << message.id();
     NodeInfo node;
     if (routing_table_.GetNodeInfo(i.node_id, node)) {
-      network_.SendToDirect(message, node.node_id, node.connection_id);
+      connected_replicants.push_back(node);
     } else {
+      message.set_destination_id(i.node_id.string());
       network_.SendToClosestNode(message);
     }
   }
+  network_.SendToDirect(message, connected_replicants);
 
   message.set_destination_id(routing_table_.kNodeId().string());
 
   if (IsRoutingMessage(message)) {
-    LOG(kVerbose) << "HandleGroupMessageAsClosestNode if, msg id: " << message.id();
+    TRACE(kVerbose) << "HandleGroupMessageAsClosestNode if, msg id: " << message.id();
     HandleRoutingMessage(message);
   } else {
-    LOG(kVerbose) << "HandleGroupMessageAsClosestNode else, msg id: " << message.id();
+    TRACE(kVerbose) << "HandleGroupMessageAsClosestNode else, msg id: " << message.id();
     HandleNodeLevelMessageForThisNode(message);
   }
 }
 
-void MessageHandler::HandleMessageAsFarNode(protobuf::Message& message) {
-  if (message.has_visited() &&
-      routing_table_.IsThisNodeClosestTo(NodeId(message.destination_id()), !message.direct()) &&
-      !message.direct() && !message.visited())
+void MessageHandler::HandleMessageAsFarNode(protobuf::Message& message, const RouteDecision& route,
+                                            const SharedBuffer& payload) {
+  if (message.has_visited() && route.this_node_closest && !message.direct() && !message.visited())
     message.set_visited(true);
-  LOG(kVerbose) << "[" << DebugId(routing_table_.kNodeId())
-                << "] is not in closest proximity to this message destination ID [ "
-                << HexSubstr(message.destination_id()) << " ]; sending on."
-                << " id: " << message.id();
-  network_.SendToClosestNode(message);
+  TRACE(kVerbose) << "[" << DebugId(routing_table_.kNodeId())
+                  << "] is not in closest proximity to this message destination ID [ "
+                  << HexSubstr(message.destination_id()) << " ]; sending on."
+                  << " id: " << message.id();
+  network_.SendToClosestNode(message, route, payload);
 }
 
 void MessageHandler::HandleMessage(protobuf::Message& message) {
-  LOG(kVerbose) << "[" << DebugId(routing_table_.kNodeId()) << "]"
-                << " MessageHandler::HandleMessage handle message with id: " << message.id();
+  TRACE(kVerbose) << "[" << DebugId(routing_table_.kNodeId()) << "]"
+                  << " MessageHandler::HandleMessage handle message with id: " << message.id();
   if (!ValidateMessage(message)) {
     LOG(kWarning) << "Validate message failed， id: " << message.id();
     assert((message.hops_to_live() > 0) && "Message has traversed maximum number of hops allowed");
@@ -422,68 +426,119 @@ void MessageHandler::HandleMessage(protobuf::Message& message) {
   // Decrement hops_to_live
   message.set_hops_to_live(message.hops_to_live() - 1);
 
-  if (IsValidCacheableGet(message)) {
-    LOG(kInfo) << "MessageHandler::HandleMessage " << message.id() << " with cache manager";
-    return HandleCacheLookup(message);  // forwarding message is done by cache manager
-  }
   if (IsValidCacheablePut(message)) {
-    LOG(kInfo) << "MessageHandler::HandleMessage " << message.id() << " StoreCacheCopy";
+    TRACE(kInfo) << "MessageHandler::HandleMessage " << message.id() << " StoreCacheCopy";
     StoreCacheCopy(message);  //  Upper layer should take this on separate thread
   }
 
-  // If group message request to self id
-  if (IsGroupMessageRequestToSelfId(message)) {
-    LOG(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleGroupMessageToSelfId";
-    return HandleGroupMessageToSelfId(message);
-  }
-
-  // If this node is a client
-  if (routing_table_.client_mode()) {
-    LOG(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleClientMessage";
-    return HandleClientMessage(message);
-  }
-
-  // Relay mode message
-  if (message.source_id().empty()) {
-    LOG(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleRelayRequest";
-    return HandleRelayRequest(message);
+  switch (GetPreRouteHandling(message)) {
+    case PreRouteHandling::kCacheLookup:
+      TRACE(kInfo) << "MessageHandler::HandleMessage " << message.id() << " with cache manager";
+      return HandleCacheLookup(message);  // forwarding message is done by cache manager
+    case PreRouteHandling::kGroupMessageToSelfId:
+      TRACE(kInfo) << "MessageHandler::HandleMessage " << message.id()
+                   << " HandleGroupMessageToSelfId";
+      return HandleGroupMessageToSelfId(message);
+    case PreRouteHandling::kClientMessage:
+      TRACE(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleClientMessage";
+      return HandleClientMessage(message);
+    case PreRouteHandling::kRelayRequest:
+      TRACE(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleRelayRequest";
+      return HandleRelayRequest(message);
+    case PreRouteHandling::kStray:
+      LOG(kWarning) << "Stray message dropped, need valid source ID for processing."
+                    << " id: " << message.id();
+      return;
+    case PreRouteHandling::kForThisNode:
+      TRACE(kInfo) << "MessageHandler::HandleMessage " << message.id()
+                   << " HandleMessageForThisNode";
+      return HandleMessageForThisNode(message);
+    case PreRouteHandling::kRelayResponse:
+      TRACE(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleRoutingMessage";
+      return HandleRoutingMessage(message);
+    case PreRouteHandling::kForNonRoutingNode:
+      TRACE(kInfo) << "MessageHandler::HandleMessage " << message.id()
+                   << " HandleMessageForNonRoutingNodes";
+      return HandleMessageForNonRoutingNodes(message);
+    case PreRouteHandling::kRoute:
+      break;
   }
 
-  // Invalid source id, unknown message
-  if (NodeId(message.source_id()).IsZero()) {
-    LOG(kWarning) << "Stray message dropped, need valid source ID for processing."
-                  << " id: " << message.id();
-    return;
+  // The rest of the handling, including picking the next hop, uses this one look-up.
+  const RouteDecision route(routing_table_.Route(NodeId(message.destination_id()),
+                                                 !message.direct()));
+  // This node is in closest proximity to this message
+  if (route.this_node_in_group_range || (route.this_node_closest && message.visited())) {
+    TRACE(kInfo) << "MessageHandler::HandleMessage " << message.id()
+                 << " HandleMessageAsClosestNode";
+    return HandleMessageAsClosestNode(message, route);
+  } else {
+    TRACE(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleMessageAsFarNode";
+    return HandleMessageAsFarNode(message, route);
   }
+}
 
-  // Direct message
-  if (message.destination_id() == routing_table_.kNodeId().string()) {
-    LOG(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleMessageForThisNode";
-    return HandleMessageForThisNode(message);
+bool MessageHandler::HandleMessageHeader(protobuf::Message& header, const SharedBuffer& payload) {
+  if (!ValidateMessage(header)) {
+    LOG(kWarning) << "Validate message failed, id: " << header.id();
+    return true;
   }
-
-  if (IsRelayResponseForThisNode(message)) {
-    LOG(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleRoutingMessage";
-    return HandleRoutingMessage(message);
+  // Caching a copy needs the payload.
+  if (IsValidCacheablePut(header))
+    return false;
+  switch (GetPreRouteHandling(header)) {
+    case PreRouteHandling::kRoute:
+      break;
+    case PreRouteHandling::kStray:
+      LOG(kWarning) << "Stray message dropped, need valid source ID for processing."
+                    << " id: " << header.id();
+      return true;
+    default:
+      return false;
+  }
+
+  header.set_hops_to_live(header.hops_to_live() - 1);
+  const RouteDecision route(routing_table_.Route(NodeId(header.destination_id()),
+                                                 !header.direct()));
+  if (route.this_node_in_group_range || (route.this_node_closest && header.visited())) {
+    if (!MergePayload(payload, header)) {
+      LOG(kWarning) << "Message received, failed to parse payload.  id: " << header.id();
+      return true;
+    }
+    TRACE(kInfo) << "MessageHandler::HandleMessageHeader " << header.id()
+                 << " HandleMessageAsClosestNode";
+    HandleMessageAsClosestNode(header, route);
+    return true;
   }
 
-  if (client_routing_table_.Contains(NodeId(message.destination_id())) && IsDirect(message)) {
-    LOG(kInfo) << "MessageHandler::HandleMessage " << message.id()
-               << " HandleMessageForNonRoutingNodes";
-    return HandleMessageForNonRoutingNodes(message);
-  }
+  HandleMessageAsFarNode(header, route, payload);
+  return true;
+}
 
-  // This node is in closest proximity to this message
-  if (routing_table_.IsThisNodeInRange(NodeId(message.destination_id()),
-                                       Parameters::group_size) ||
-      (routing_table_.IsThisNodeClosestTo(NodeId(message.destination_id()), !message.direct()) &&
-       message.visited())) {
-    LOG(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleMessageAsClosestNode";
-    return HandleMessageAsClosestNode(message);
-  } else {
-    LOG(kInfo) << "MessageHandler::HandleMessage " << message.id() << " HandleMessageAsFarNode";
-    return HandleMessageAsFarNode(message);
-  }
+MessageHandler::PreRouteHandling MessageHandler::GetPreRouteHandling(
+    const protobuf::Message& message) {
+  if (IsValidCacheableGet(message))
+    return PreRouteHandling::kCacheLookup;
+  // If group message request to self id
+  if (IsGroupMessageRequestToSelfId(message))
+    return PreRouteHandling::kGroupMessageToSelfId;
+  // If this node is a client
+  if (routing_table_.client_mode())
+    return PreRouteHandling::kClientMessage;
+  // Relay mode message
+  if (message.source_id().empty())
+    return PreRouteHandling::kRelayRequest;
+  // Invalid source id, unknown message
+  if (NodeId(message.source_id()).IsZero())
+    return PreRouteHandling::kStray;
+  // Direct message
+  if (message.destination_id() == routing_table_.kNodeId().string())
+    return PreRouteHandling::kForThisNode;
+  if (IsRelayResponseForThisNode(message))
+    return PreRouteHandling::kRelayResponse;
+  if (client_routing_table_.Contains(NodeId(message.destination_id())) && IsDirect(message))
+    return PreRouteHandling::kForNonRoutingNode;
+  return PreRouteHandling::kRoute;
 }
 
 void MessageHandler::HandleMessageForNonRoutingNodes(protobuf::Message& message) {
@@ -498,16 +553,16 @@ void MessageHandler::HandleMessageForNonRoutingNodes(protobuf::Message& message)
                   << PrintMessage(message);
     return;
   }
-  LOG(kInfo) << "This node has message destination in its ClientRoutingTable. Dest id : "
-             << HexSubstr(message.destination_id()) << " message id: " << message.id();
+  TRACE(kInfo) << "This node has message destination in its ClientRoutingTable. Dest id : "
+               << HexSubstr(message.destination_id()) << " message id: " << message.id();
   return network_.SendToClosestNode(message);
 }
 
 void MessageHandler::HandleRelayRequest(protobuf::Message& message) {
   assert(!message.has_source_id());
   if ((message.destination_id() == routing_table_.kNodeId().string()) && IsRequest(message)) {
-    LOG(kVerbose) << "Relay request with this node's ID as destination ID"
-                  << " id: " << message.id();
+    TRACE(kVerbose) << "Relay request with this node's ID as destination ID"
+                    << " id: " << message.id();
     // If group message request to this node's id sent by relay requester node
     if ((message.destination_id() == routing_table_.kNodeId().string()) && message.request() &&
         !message.direct()) {
@@ -562,8 +617,8 @@ void MessageHandler::HandleGroupRelayRequestMessageAsClosestNode(protobuf::Messa
   // This node is not closest to the destination node for non-direct message.
   if (!routing_table_.IsThisNodeClosestTo(NodeId(message.destination_id()), !IsDirect(message)) &&
       !have_node_with_group_id) {
-    LOG(kInfo) << "This node is not closest, passing it on."
-               << " id: " << message.id();
+    TRACE(kInfo) << "This node is not closest, passing it on."
+                 << " id: " << message.id();
     message.set_source_id(routing_table_.kNodeId().string());
     return network_.SendToClosestNode(message);
   }
@@ -596,23 +651,25 @@ void MessageHandler::HandleGroupRelayRequestMessageAsClosestNode(protobuf::Messa
   if (have_node_with_group_id)
     close.erase(close.begin());
   std::string group_id(message.destination_id());
-  std::string group_members("[" + DebugId(routing_table_.kNodeId()) + "]");
-
-  for (const auto& i : close)
-    group_members += std::string("[" + DebugId(i) + "]");
-  LOG(kInfo) << "Group members for group_id " << HexSubstr(group_id) << " are: " << group_members;
+  if (TraceEnabled(kInfo)) {
+    std::string group_members("[" + DebugId(routing_table_.kNodeId()) + "]");
+    for (const auto& i : close)
+      group_members += std::string("[" + DebugId(i) + "]");
+    TRACE(kInfo) << "Group members for group_id " << HexSubstr(group_id)
+                 << " are: " << group_members;
+  }
   // This node relays back the responses
   message.set_source_id(routing_table_.kNodeId().string());
+  std::vector<NodeInfo> connected_replicants;
   for (const auto& i : close) {
-    LOG(kInfo) << "Replicating message to : " << HexSubstr(i.string())
-               << " [ group_id : " << HexSubstr(group_id) << "]"
-               << " id: " << message.id();
-    message.set_destination_id(i.string());
+    TRACE(kInfo) << "Replicating message to : " << HexSubstr(i.string())
+                 << " [ group_id : " << HexSubstr(group_id) << "]"
+                 << " id: " << message.id();
     NodeInfo node;
-    if (routing_table_.GetNodeInfo(i, node)) {
-      network_.SendToDirect(message, node.node_id, node.connection_id);
-    }
+    if (routing_table_.GetNodeInfo(i, node))
+      connected_replicants.push_back(node);
   }
+  network_.SendToDirect(message, connected_replicants);
 
   message.set_destination_id(routing_table_.kNodeId().string());
 //  message.clear_source_id();
@@ -623,10 +680,10 @@ void MessageHandler::HandleGroupRelayRequestMessageAsClosestNode(protobuf::Messa
 }
 
 // Special case when response of a relay comes through an alternative route.
-bool MessageHandler::IsRelayResponseForThisNode(protobuf::Message& message) {
+bool MessageHandler::IsRelayResponseForThisNode(const protobuf::Message& message) {
   if (IsRoutingMessage(message) && message.has_relay_id() &&
       (message.relay_id() == routing_table_.kNodeId().string())) {
-    LOG(kVerbose) << "Relay response through alternative route";
+    TRACE(kVerbose) << "Relay response through alternative route";
     return true;
   } else {
     return false;
@@ -644,8 +701,8 @@ bool MessageHandler::RelayDirectMessageIfNeeded(protobuf::Message& message) {
           (message.destination_id() != message.relay_id())) {
     message.clear_destination_id();
     message.clear_actual_destination_is_relay_id();  // so that it is picked currectly at recepient
-    LOG(kVerbose) << "Relaying request to " << HexSubstr(message.relay_id())
-                  << " id: " << message.id();
+    TRACE(kVerbose) << "Relaying request to " << HexSubstr(message.relay_id())
+                    << " id: " << message.id();
     network_.SendToClosestNode(message);
     return true;
   }
@@ -653,8 +710,8 @@ bool MessageHandler::RelayDirectMessageIfNeeded(protobuf::Message& message) {
   // Only direct responses need to be relayed
   if (IsResponse(message) && (message.destination_id() != message.relay_id())) {
     message.clear_destination_id();  // to allow network util to identify it as relay message
-    LOG(kVerbose) << "Relaying response to " << HexSubstr(message.relay_id())
-                  << " id: " << message.id();
+    TRACE(kVerbose) << "Relaying response to " << HexSubstr(message.relay_id())
+                    << " id: " << message.id();
     network_.SendToClosestNode(message);
     return true;
   }
@@ -672,12 +729,12 @@ void MessageHandler::HandleClientMessage(protobuf::Message& message) {
     return;
   }
   if (IsRoutingMessage(message)) {
-    LOG(kVerbose) << "Client Routing Response for " << DebugId(routing_table_.kNodeId())
-                  << " from " << HexSubstr(message.source_id()) << " id: " << message.id();
+    TRACE(kVerbose) << "Client Routing Response for " << DebugId(routing_table_.kNodeId())
+                    << " from " << HexSubstr(message.source_id()) << " id: " << message.id();
     HandleRoutingMessage(message);
   } else if ((message.destination_id() == routing_table_.kNodeId().string())) {
-    LOG(kVerbose) << "Client NodeLevel Response for " << DebugId(routing_table_.kNodeId())
-                  << " from " << HexSubstr(message.source_id()) << " id: " << message.id();
+    TRACE(kVerbose) << "Client NodeLevel Response for " << DebugId(routing_table_.kNodeId())
+                    << " from " << HexSubstr(message.source_id()) << " id: " << message.id();
     HandleNodeLevelMessageForThisNode(message);
   } else {
     LOG(kWarning) << DebugId(routing_table_.kNodeId()) << " silently drop message "
@@ -686,7 +743,7 @@ void MessageHandler::HandleClientMessage(protobuf::Message& message) {
 }
 
 // Special case : If group message request to self id
-bool MessageHandler::IsGroupMessageRequestToSelfId(protobuf::Message& message) {
+bool MessageHandler::IsGroupMessageRequestToSelfId(const protobuf::Message& message) {
   return ((message.source_id() == routing_table_.kNodeId().string()) &&
           (message.destination_id() == routing_table_.kNodeId().string()) && message.request() &&
           !message.direct());
@@ -697,7 +754,7 @@ void MessageHandler::HandleGroupMessageToSelfId(protobuf::Message& message) {
   assert(message.destination_id() == routing_table_.kNodeId().string());
   assert(message.request());
   assert(!message.direct());
-  LOG(kInfo) << "Sending group message to self id. Passing on to the closest peer to replicate";
+  TRACE(kInfo) << "Sending group message to self id. Passing on to the closest peer to replicate";
   network_.SendToClosestNode(message);
 }
 
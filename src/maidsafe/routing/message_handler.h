@@ -27,6 +27,7 @@
 #include "maidsafe/routing/cache_manager.h"
 #include "maidsafe/routing/response_handler.h"
 #include "maidsafe/routing/service.h"
+#include "maidsafe/routing/shared_buffer.h"
 #include "maidsafe/routing/timer.h"
 
 namespace maidsafe {
@@ -63,6 +64,7 @@ class RoutingTable;
 class RemoveFurthestNode;
 class GroupChangeHandler;
 class NetworkStatistics;
+struct RouteDecision;
 
 enum class MessageType : int32_t {
   kPing = 1,
@@ -83,11 +85,30 @@ class MessageHandler {
                  NetworkUtils& network, Timer<std::string>& timer, RemoveFurthestNode& remove_node,
                  GroupChangeHandler& group_change_handler, NetworkStatistics& network_statistics);
   void HandleMessage(protobuf::Message& message);
+  // Handles a message split by ParseMessageHeader if HandleMessage would do no more with it than
+  // pass it on or handle it as one of the closest nodes to its destination.  A message being passed
+  // on is sent with 'payload' as received, without parsing it.  An invalid or stray message is
+  // dropped.  Returns false without changing 'header' for any other message, which should then be
+  // parsed in full and given to HandleMessage.
+  bool HandleMessageHeader(protobuf::Message& header, const SharedBuffer& payload);
   void set_typed_message_and_caching_functor(TypedMessageAndCachingFunctor functors);
   void set_message_and_caching_functor(MessageAndCachingFunctors functors);
   void set_request_public_key_functor(RequestPublicKeyFunctor request_public_key_functor);
 
  private:
+  // What HandleMessage does with a valid message before the routing table is looked at.
+  enum class PreRouteHandling {
+    kCacheLookup,
+    kGroupMessageToSelfId,
+    kClientMessage,
+    kRelayRequest,
+    kStray,
+    kForThisNode,
+    kRelayResponse,
+    kForNonRoutingNode,
+    kRoute  // None of the above; the message is routed on, or handled as a closest node.
+  };
+
   MessageHandler(const MessageHandler&);
   MessageHandler(const MessageHandler&&);
   MessageHandler& operator=(const MessageHandler&);
@@ -95,14 +116,18 @@ class MessageHandler {
   void HandleRoutingMessage(protobuf::Message& message);
   void HandleNodeLevelMessageForThisNode(protobuf::Message& message);
   void HandleMessageForThisNode(protobuf::Message& message);
-  void HandleMessageAsClosestNode(protobuf::Message& message);
-  void HandleDirectMessageAsClosestNode(protobuf::Message& message);
-  void HandleGroupMessageAsClosestNode(protobuf::Message& message);
-  void HandleMessageAsFarNode(protobuf::Message& message);
+  void HandleMessageAsClosestNode(protobuf::Message& message, const RouteDecision& route);
+  void HandleDirectMessageAsClosestNode(protobuf::Message& message, const RouteDecision& route);
+  void HandleGroupMessageAsClosestNode(protobuf::Message& message, const RouteDecision& route);
+  // 'payload' is as for HandleMessageHeader, if 'message' was split.
+  void HandleMessageAsFarNode(protobuf::Message& message, const RouteDecision& route,
+                              const SharedBuffer& payload = SharedBuffer());
   void HandleRelayRequest(protobuf::Message& message);
   void HandleGroupMessageToSelfId(protobuf::Message& message);
-  bool IsRelayResponseForThisNode(protobuf::Message& message);
-  bool IsGroupMessageRequestToSelfId(protobuf::Message& message);
+  // Shared by HandleMessage and HandleMessageHeader, so both treat a message alike.
+  PreRouteHandling GetPreRouteHandling(const protobuf::Message& message);
+  bool IsRelayResponseForThisNode(const protobuf::Message& message);
+  bool IsGroupMessageRequestToSelfId(const protobuf::Message& message);
   bool RelayDirectMessageIfNeeded(protobuf::Message& message);
   void HandleClientMessage(protobuf::Message& message);
   void HandleMessageForNonRoutingNodes(protobuf::Message& message);
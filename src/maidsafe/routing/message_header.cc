@@ -0,0 +1,132 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/message_header.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/io/coded_stream.h"
+
+#include "maidsafe/routing/routing.pb.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace {
+
+enum WireType : uint32_t {
+  kVarint = 0,
+  kFixed64 = 1,
+  kLengthDelimited = 2,
+  kFixed32 = 5
+};
+
+bool IsPayloadField(uint32_t field_number) {
+  return field_number == protobuf::Message::kDataFieldNumber ||
+         field_number == protobuf::Message::kSignatureFieldNumber;
+}
+
+bool SkipField(google::protobuf::io::CodedInputStream& stream, uint32_t wire_type) {
+  switch (wire_type) {
+    case kVarint: {
+      uint64_t value(0);
+      return stream.ReadVarint64(&value);
+    }
+    case kFixed64:
+      return stream.Skip(8);
+    case kLengthDelimited: {
+      uint32_t length(0);
+      return stream.ReadVarint32(&length) && stream.Skip(static_cast<int>(length));
+    }
+    case kFixed32:
+      return stream.Skip(4);
+    default:  // Groups aren't used by routing.proto
+      return false;
+  }
+}
+
+void AddToRuns(std::vector<std::pair<int, int>>& runs, int field_begin, int field_end) {
+  if (!runs.empty() && runs.back().second == field_begin)
+    runs.back().second = field_end;
+  else
+    runs.push_back(std::make_pair(field_begin, field_end));
+}
+
+}  // unnamed namespace
+
+bool ParseMessageHeader(const SharedBuffer& serialised_message, protobuf::Message& header,
+                        SharedBuffer& payload) {
+  header.Clear();
+  payload = SharedBuffer();
+  const uint8_t* const kBegin(reinterpret_cast<const uint8_t*>(serialised_message.data()));
+  google::protobuf::io::CodedInputStream stream(kBegin,
+                                                static_cast<int>(serialised_message.size()));
+  // Runs of adjacent fields, as [begin, end) offsets into the message.  On the wire the payload
+  // fields normally lie between two runs of header fields.
+  std::vector<std::pair<int, int>> header_runs, payload_runs;
+  for (;;) {
+    const int kFieldStart(stream.CurrentPosition());
+    const uint32_t kTag(stream.ReadTag());
+    if (kTag == 0)
+      break;
+    const uint32_t kWireType(kTag & 7);
+    const bool kPayloadField(IsPayloadField(kTag >> 3));
+    if ((kPayloadField && kWireType != kLengthDelimited) || !SkipField(stream, kWireType))
+      return false;
+    AddToRuns(kPayloadField ? payload_runs : header_runs, kFieldStart, stream.CurrentPosition());
+  }
+  if (!stream.ConsumedEntireMessage())
+    return false;
+
+  for (const auto& run : header_runs) {
+    google::protobuf::io::CodedInputStream run_stream(kBegin + run.first, run.second - run.first);
+    if (!header.MergePartialFromCodedStream(&run_stream)) {
+      header.Clear();
+      return false;
+    }
+  }
+  if (!header.IsInitialized()) {
+    header.Clear();
+    return false;
+  }
+
+  if (payload_runs.size() == 1) {
+    payload = SharedBuffer(serialised_message, payload_runs.front().first,
+                           payload_runs.front().second - payload_runs.front().first);
+  } else if (!payload_runs.empty()) {
+    std::string scattered_payload;
+    for (const auto& run : payload_runs)
+      scattered_payload.append(serialised_message.data() + run.first, run.second - run.first);
+    payload = SharedBuffer(std::move(scattered_payload));
+  }
+  return true;
+}
+
+bool MergePayload(const SharedBuffer& payload, protobuf::Message& header) {
+  google::protobuf::io::CodedInputStream stream(
+      reinterpret_cast<const uint8_t*>(payload.data()), static_cast<int>(payload.size()));
+  return header.MergeFromCodedStream(&stream);
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,50 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_MESSAGE_HEADER_H_
+#define MAIDSAFE_ROUTING_MESSAGE_HEADER_H_
+
+#include "maidsafe/routing/shared_buffer.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace protobuf {
+class Message;
+}
+
+// Splits the serialised protobuf::Message 'serialised_message' into its routing header and its
+// payload without decoding the payload.  'header' is set to the message less its data and signature
+// fields, and 'payload' to the wire encoding of those fields exactly as received.  Since a parser
+// accepts fields in any order, the header serialised with 'payload' appended is again the whole
+// message, so a message being passed on can have its header changed and be sent with the payload
+// untouched.  'payload' shares the bytes of 'serialised_message' unless the payload fields are
+// split up by header fields on the wire.  Returns false, leaving both empty, if the message is
+// malformed.
+bool ParseMessageHeader(const SharedBuffer& serialised_message, protobuf::Message& header,
+                        SharedBuffer& payload);
+
+// Parses 'payload' from ParseMessageHeader into 'header', making it the whole message.
+bool MergePayload(const SharedBuffer& payload, protobuf::Message& header);
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_MESSAGE_HEADER_H_
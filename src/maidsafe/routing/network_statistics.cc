@@ -18,34 +18,43 @@
 
 #include "maidsafe/routing/network_statistics.h"
 
-#include <string>
 #include <algorithm>
+#include <limits>
+#include <string>
 
+#include "maidsafe/routing/distance_sort.h"
 #include "maidsafe/routing/parameters.h"
 
 namespace maidsafe {
 
 namespace routing {
 
+namespace {
+
+const size_t kAverageBytes(sizeof(uint64_t));
+
+uint64_t LeadingBits(const NodeId& distance) {
+  const std::string raw_distance(distance.string());
+  uint64_t leading_bits(0);
+  for (size_t i(0); i != kAverageBytes; ++i)
+    leading_bits = (leading_bits << 8) | static_cast<unsigned char>(raw_distance[i]);
+  return leading_bits;
+}
+
+}  // unnamed namespace
+
 NetworkStatistics::NetworkStatistics(NodeId node_id)
-    : mutex_(), kNodeId_(std::move(node_id)), distance_(), network_distance_data_() {}
+    : mutex_(),
+      kNodeId_(std::move(node_id)),
+      distance_(),
+      network_average_distance_(0),
+      network_contributors_count_(0) {}
 
 void NetworkStatistics::UpdateLocalAverageDistance(std::vector<NodeId>& unique_nodes) {
   if (unique_nodes.size() < Parameters::group_size)
     return;
-#ifndef __GNUC__
-  std::nth_element(unique_nodes.begin(), unique_nodes.begin() + Parameters::group_size,
-                   unique_nodes.end(), [&](const NodeId & lhs, const NodeId & rhs) {
-    return NodeId::CloserToTarget(lhs, rhs, kNodeId_);
-  });
-#else
-  // BEFORE_RELEASE use std::nth_element() for all platform when min required Gcc version is 4.8.3
-  // http://gcc.gnu.org/bugzilla/show_bug.cgi?id=58800 Bug fixed in gcc 4.8.3
-  std::partial_sort(unique_nodes.begin(), unique_nodes.begin() + Parameters::group_size,
-                    unique_nodes.end(), [&](const NodeId & lhs, const NodeId & rhs) {
-    return NodeId::CloserToTarget(lhs, rhs, kNodeId_);
-  });
-#endif
+  PartialSortByDistance(unique_nodes.begin(), unique_nodes.begin() + Parameters::group_size,
+                        unique_nodes.end(), kNodeId_);
   NodeId furthest_group_node(unique_nodes.at(
       std::min(Parameters::group_size - 1, static_cast<int>(unique_nodes.size()))));
   {
@@ -57,18 +66,20 @@ void NetworkStatistics::UpdateLocalAverageDistance(std::vector<NodeId>& unique_n
 void NetworkStatistics::UpdateNetworkAverageDistance(const NodeId& distance) {
   if (distance == NodeId())
     return;
-  crypto::BigInt distance_integer(
-      (distance.ToStringEncoded(NodeId::EncodingType::kHex) + 'h').c_str());
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    network_distance_data_.total_distance += distance_integer;
-    auto average(network_distance_data_.total_distance /
-                 ++network_distance_data_.contributors_count);
-    std::string average_str(NodeId::kSize, '\0');
-    for (auto index(NodeId::kSize - 1); index >= 0; --index)
-      average_str[NodeId::kSize - 1 - index] = average.GetByte(index);
-    network_distance_data_.average_distance = NodeId(average_str);
+  const uint64_t sample(LeadingBits(distance));
+  // Each distance is weighted 1/n while fewer than the window's worth have been seen (giving their
+  // plain mean), then 1/window, so older distances' weights decay exponentially.
+  const uint32_t window(std::max<uint32_t>(Parameters::average_distance_window, 1));
+  uint32_t count(network_contributors_count_.load());
+  while (count < window && !network_contributors_count_.compare_exchange_weak(count, count + 1)) {
   }
+  const uint64_t weight(std::min(count + 1, window));
+  uint64_t average(network_average_distance_.load());
+  uint64_t updated_average(0);
+  do {
+    updated_average = (sample >= average) ? average + (sample - average) / weight
+                                          : average - (average - sample) / weight;
+  } while (!network_average_distance_.compare_exchange_weak(average, updated_average));
 }
 
 // FIXME(Prakash) handle the case of sender_id == info_id
@@ -78,15 +89,21 @@ bool NetworkStatistics::EstimateInGroup(const NodeId& sender_id, const NodeId& i
     std::lock_guard<std::mutex> lock(mutex_);
     local_distance = distance_;
   }
-  return crypto::BigInt(
-             ((info_id ^ sender_id).ToStringEncoded(NodeId::EncodingType::kHex) + 'h').c_str()) <=
-         crypto::BigInt(
-             (local_distance.ToStringEncoded(NodeId::EncodingType::kHex) + 'h').c_str()) *
-             Parameters::accepted_distance_tolerance;
+  // Saturating is exact here: a product too large to hold exceeds every distance.
+  return (Uint512(info_id) ^ Uint512(sender_id)) <=
+         MultiplySaturating(Uint512(local_distance), Parameters::accepted_distance_tolerance);
 }
 
 NodeId NetworkStatistics::GetDistance() { return distance_; }
 
+NodeId NetworkStatistics::GetNetworkAverageDistance() const {
+  uint64_t average(network_average_distance_.load());
+  std::string raw_average(NodeId::kSize, 0);
+  for (size_t i(kAverageBytes); i != 0; --i, average >>= 8)
+    raw_average[i - 1] = static_cast<char>(average & 0xff);
+  return NodeId(raw_average);
+}
+
 }  // namespace routing
 
 }  // namespace maidsafe
@@ -19,19 +19,20 @@
 #ifndef MAIDSAFE_ROUTING_NETWORK_STATISTICS_H_
 #define MAIDSAFE_ROUTING_NETWORK_STATISTICS_H_
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <vector>
 
-#include "maidsafe/common/crypto.h"
-
 #include "maidsafe/common/node_id.h"
 #include "maidsafe/routing/node_info.h"
+#include "maidsafe/routing/uint512.h"
 
 namespace maidsafe {
 
 namespace routing {
 
 namespace test {
-class NetworkStatisticsTest_BEH_AverageDistance_Test;
 class NetworkStatisticsTest_BEH_IsIdInGroupRange_Test;
 }
 
@@ -42,22 +43,23 @@ class NetworkStatistics {
   void UpdateNetworkAverageDistance(const NodeId& distance);
   bool EstimateInGroup(const NodeId& sender_id, const NodeId& info_id);
   NodeId GetDistance();
+  // The moving average of the distances reported by other nodes, weighted towards the most recent
+  // Parameters::average_distance_window of them so that it follows the network as it grows.  Only
+  // the leading 64 bits are tracked; the rest are zero.
+  NodeId GetNetworkAverageDistance() const;
 
-  friend class test::NetworkStatisticsTest_BEH_AverageDistance_Test;
   friend class test::NetworkStatisticsTest_BEH_IsIdInGroupRange_Test;
 
  private:
   NetworkStatistics(const NetworkStatistics&);
   NetworkStatistics& operator=(const NetworkStatistics&);
-  struct NetworkDistanceData {
-    NetworkDistanceData() : contributors_count(), total_distance(), average_distance() {}
-    crypto::BigInt contributors_count, total_distance;
-    NodeId average_distance;
-  };
   std::mutex mutex_;
   const NodeId kNodeId_;
   NodeId distance_;
-  NetworkDistanceData network_distance_data_;
+  // Updated without locking: the leading 64 bits of the average, and the number of distances
+  // contributed to it (stopping at the window size).
+  std::atomic<uint64_t> network_average_distance_;
+  std::atomic<uint32_t> network_contributors_count_;
 };
 
 }  // namespace routing
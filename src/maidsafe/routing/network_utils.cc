@@ -26,10 +26,12 @@
 
 #include "maidsafe/routing/bootstrap_file_handler.h"
 #include "maidsafe/routing/client_routing_table.h"
+#include "maidsafe/routing/message_header.h"
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/return_codes.h"
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/routing_table.h"
+#include "maidsafe/routing/trace.h"
 #include "maidsafe/routing/utils.h"
 
 namespace bptime = boost::posix_time;
@@ -166,17 +168,20 @@ void NetworkUtils::Remove(const NodeId& peer_id) {
 }
 
 void NetworkUtils::RudpSend(const NodeId& peer_id, const protobuf::Message& message,
-                            const rudp::MessageSentFunctor& message_sent_functor) {
+                            const rudp::MessageSentFunctor& message_sent_functor,
+                            const SharedBuffer& payload) {
   {
     std::lock_guard<std::mutex> lock(running_mutex_);
     if (!running_)
       return;
   }
-  rudp_.Send(peer_id, message.SerializeAsString(), message_sent_functor);
-  LOG(kVerbose) << "  [" << DebugId(routing_table_.kNodeId())
-                << "] send : " << MessageTypeString(message) << " to   " << DebugId(peer_id)
-                << "   (id: " << message.id() << ")"
-                << " --To Rudp--";
+  std::string serialised_message(message.SerializeAsString());
+  serialised_message.append(payload.data(), payload.size());
+  rudp_.Send(peer_id, serialised_message, message_sent_functor);
+  TRACE(kVerbose) << "  [" << DebugId(routing_table_.kNodeId())
+                  << "] send : " << MessageTypeString(message) << " to   " << DebugId(peer_id)
+                  << "   (id: " << message.id() << ")"
+                  << " --To Rudp--";
 }
 
 void NetworkUtils::SendToDirect(const protobuf::Message& message, const NodeId& peer_connection_id,
@@ -189,6 +194,28 @@ void NetworkUtils::SendToDirect(const protobuf::Message& message, const NodeId&
   SendTo(message, peer_node_id, peer_connection_id);
 }
 
+void NetworkUtils::SendToDirect(protobuf::Message& message, const std::vector<NodeInfo>& peers) {
+  if (peers.empty())
+    return;
+  // The payload is moved out of 'message' rather than copied, and moved back afterwards.
+  protobuf::Message payload_message;
+  payload_message.mutable_data()->Swap(message.mutable_data());
+  if (message.has_signature()) {
+    payload_message.set_signature(message.signature());
+    message.clear_signature();
+  }
+  const SharedBuffer kPayload(payload_message.SerializePartialAsString());
+  const std::string kDestinationId(message.destination_id());
+  for (const auto& peer : peers) {
+    message.set_destination_id(peer.node_id.string());
+    SendTo(message, peer.node_id, peer.connection_id, kPayload);
+  }
+  message.set_destination_id(kDestinationId);
+  message.mutable_data()->Swap(payload_message.mutable_data());
+  if (payload_message.has_signature())
+    message.set_signature(payload_message.signature());
+}
+
 void NetworkUtils::SendToDirectAdjustedRoute(protobuf::Message& message, const NodeId& peer_node_id,
                                              const NodeId& peer_connection_id) {
   AdjustRouteHistory(message);
@@ -207,18 +234,18 @@ void NetworkUtils::SendToClosestNode(const protobuf::Message& message) {
                       << PrintMessage(message);
         return;
       }
-      LOG(kVerbose) << "This node [" << DebugId(routing_table_.kNodeId()) << "] has "
-                    << client_routing_nodes.size()
-                    << " destination node(s) in its non-routing table."
-                    << " id: " << message.id();
+      TRACE(kVerbose) << "This node [" << DebugId(routing_table_.kNodeId()) << "] has "
+                      << client_routing_nodes.size()
+                      << " destination node(s) in its non-routing table."
+                      << " id: " << message.id();
 
       for (const auto& i : client_routing_nodes) {
-        LOG(kVerbose) << "Sending message to NRT node with ID " << message.id() << " node_id "
-                      << DebugId(i.node_id) << " connection id " << DebugId(i.connection_id);
+        TRACE(kVerbose) << "Sending message to NRT node with ID " << message.id() << " node_id "
+                        << DebugId(i.node_id) << " connection id " << DebugId(i.connection_id);
         SendTo(message, i.node_id, i.connection_id);
       }
     } else if (routing_table_.size() > 0) {  // getting closer nodes from routing table
-      RecursiveSendOn(message);
+      RecursiveSendOn(std::make_shared<protobuf::Message>(message));
     } else {
       LOG(kError) << " No endpoint to send to; aborting send.  Attempt to send a type "
                   << MessageTypeString(message) << " message to " << HexSubstr(message.source_id())
@@ -242,25 +269,55 @@ void NetworkUtils::SendToClosestNode(const protobuf::Message& message) {
   }
 }
 
+void NetworkUtils::SendToClosestNode(const protobuf::Message& message,
+                                     const RouteDecision& route) {
+  if (!message.has_destination_id() || message.destination_id() != route.destination_id.string() ||
+      route.ignore_exact_match == IsDirect(message) || route.snapshot->size() == 0)
+    return SendToClosestNode(message);
+  RecursiveSendOn(std::make_shared<protobuf::Message>(message), NodeInfo(), 0, &route);
+}
+
+void NetworkUtils::SendToClosestNode(const protobuf::Message& header, const RouteDecision& route,
+                                     const SharedBuffer& payload) {
+  if (payload.empty())
+    return SendToClosestNode(header, route);
+  if (!header.has_destination_id() || header.destination_id() != route.destination_id.string() ||
+      route.ignore_exact_match == IsDirect(header) || route.snapshot->size() == 0) {
+    protobuf::Message message(header);
+    if (!MergePayload(payload, message)) {
+      LOG(kWarning) << "Failed to parse payload; aborting send.  id: " << header.id();
+      return;
+    }
+    return SendToClosestNode(message);
+  }
+  RecursiveSendOn(std::make_shared<protobuf::Message>(header), NodeInfo(), 0, &route, payload);
+}
+
 void NetworkUtils::SendTo(const protobuf::Message& message, const NodeId& peer_node_id,
-                          const NodeId& peer_connection_id) {
+                          const NodeId& peer_connection_id, const SharedBuffer& payload) {
   const std::string kThisId(routing_table_.kNodeId().string());
+  // Only what's logged is kept for the callback, rather than a copy of the whole message.
+  const int32_t kMessageType(message.type()), kMessageId(message.id());
+  const bool kRequest(message.request());
   rudp::MessageSentFunctor message_sent_functor = [=](int message_sent) {
     if (rudp::kSuccess == message_sent) {
-      LOG(kVerbose) << "  [" << HexSubstr(kThisId) << "] sent : " << MessageTypeString(message)
-                    << " to   " << DebugId(peer_node_id) << "   (id: " << message.id() << ")";
+      TRACE(kVerbose) << "  [" << HexSubstr(kThisId)
+                      << "] sent : " << MessageTypeString(kMessageType, kRequest) << " to   "
+                      << DebugId(peer_node_id) << "   (id: " << kMessageId << ")";
     } else {
-      LOG(kError) << "Sending type " << MessageTypeString(message) << " message from "
-                  << HexSubstr(kThisId) << " to " << DebugId(peer_node_id) << " failed with code "
-                  << message_sent << " id: " << message.id();
+      LOG(kError) << "Sending type " << MessageTypeString(kMessageType, kRequest)
+                  << " message from " << HexSubstr(kThisId) << " to " << DebugId(peer_node_id)
+                  << " failed with code " << message_sent << " id: " << kMessageId;
     }
   };
-  LOG(kVerbose) << " >>>>>>>>> rudp send message to connection id " << DebugId(peer_connection_id);
-  RudpSend(peer_connection_id, message, message_sent_functor);
+  TRACE(kVerbose) << " >>>>>>>>> rudp send message to connection id "
+                  << DebugId(peer_connection_id);
+  RudpSend(peer_connection_id, message, message_sent_functor, payload);
 }
 
-void NetworkUtils::RecursiveSendOn(protobuf::Message message, NodeInfo last_node_attempted,
-                                   int attempt_count) {
+void NetworkUtils::RecursiveSendOn(std::shared_ptr<protobuf::Message> message,
+                                   NodeInfo last_node_attempted, int attempt_count,
+                                   const RouteDecision* route, const SharedBuffer& payload) {
   {
     std::lock_guard<std::mutex> lock(running_mutex_);
     if (!running_)
@@ -270,7 +327,7 @@ void NetworkUtils::RecursiveSendOn(protobuf::Message message, NodeInfo last_node
     LOG(kWarning) << " Retry attempts failed to send to ["
                   << HexSubstr(last_node_attempted.node_id.string())
                   << "] will drop this node now and try with another node."
-                  << " id: " << message.id();
+                  << " id: " << message->id();
     attempt_count = 0;
     {
       std::lock_guard<std::mutex> lock(running_mutex_);
@@ -288,33 +345,41 @@ void NetworkUtils::RecursiveSendOn(protobuf::Message message, NodeInfo last_node
     Sleep(std::chrono::milliseconds(50));
 
   const std::string kThisId(routing_table_.kNodeId().string());
-  bool ignore_exact_match(!IsDirect(message));
+  bool ignore_exact_match(!IsDirect(*message));
   std::vector<std::string> route_history;
   NodeInfo peer;
   {
     std::lock_guard<std::mutex> lock(running_mutex_);
     if (!running_)
       return;
-    if (message.route_history().size() > 1)
+    if (message->route_history().size() > 1)
       route_history = std::vector<std::string>(
-          message.route_history().begin(),
-          message.route_history().end() -
-              static_cast<size_t>(!(message.has_visited() && message.visited())));
-    else if ((message.route_history().size() == 1) &&
-             (message.route_history(0) != routing_table_.kNodeId().string()))
-      route_history.push_back(message.route_history(0));
-
-    peer = routing_table_.GetNodeForSendingMessage(NodeId(message.destination_id()), route_history,
-                                                   ignore_exact_match);
-    if (peer.node_id == NodeId() && routing_table_.size() != 0) {
-      peer = routing_table_.GetNodeForSendingMessage(
-          NodeId(message.destination_id()), std::vector<std::string>(), ignore_exact_match);
+          message->route_history().begin(),
+          message->route_history().end() -
+              static_cast<size_t>(!(message->has_visited() && message->visited())));
+    else if ((message->route_history().size() == 1) &&
+             (message->route_history(0) != routing_table_.kNodeId().string()))
+      route_history.push_back(message->route_history(0));
+
+    if (route) {
+      // Only the first attempt uses the route; retries look again at the table as it is then.
+      peer = route->snapshot->GetNodeForSendingMessage(*route, route_history);
+      if (peer.node_id == NodeId())
+        peer = route->snapshot->GetNodeForSendingMessage(*route, std::vector<std::string>());
+    } else {
+      auto routing_table_snapshot(routing_table_.Snapshot());
+      peer = routing_table_snapshot->GetNodeForSendingMessage(NodeId(message->destination_id()),
+                                                              route_history, ignore_exact_match);
+      if (peer.node_id == NodeId() && routing_table_snapshot->size() != 0) {
+        peer = routing_table_snapshot->GetNodeForSendingMessage(
+            NodeId(message->destination_id()), std::vector<std::string>(), ignore_exact_match);
+      }
     }
     if (peer.node_id == NodeId()) {
       LOG(kError) << "This node's routing table is empty now.  Need to re-bootstrap.";
       return;
     }
-    AdjustRouteHistory(message);
+    AdjustRouteHistory(*message);
   }
 
   rudp::MessageSentFunctor message_sent_functor = [=](int message_sent) {
@@ -324,24 +389,24 @@ void NetworkUtils::RecursiveSendOn(protobuf::Message message, NodeInfo last_node
         return;
     }
     if (rudp::kSuccess == message_sent) {
-      LOG(kVerbose) << "  [" << HexSubstr(kThisId) << "] sent : " << MessageTypeString(message)
-                    << " to   " << HexSubstr(peer.node_id.string()) << "   (id: " << message.id()
-                    << ")"
-                    << " dst : " << HexSubstr(message.destination_id());
+      TRACE(kVerbose) << "  [" << HexSubstr(kThisId) << "] sent : " << MessageTypeString(*message)
+                      << " to   " << HexSubstr(peer.node_id.string()) << "   (id: " << message->id()
+                      << ")"
+                      << " dst : " << HexSubstr(message->destination_id());
     } else if (rudp::kSendFailure == message_sent) {
-      LOG(kError) << "Sending type " << MessageTypeString(message) << " message from "
+      LOG(kError) << "Sending type " << MessageTypeString(*message) << " message from "
                   << HexSubstr(routing_table_.kNodeId().string()) << " to "
                   << HexSubstr(peer.node_id.string()) << " with destination ID "
-                  << HexSubstr(message.destination_id()) << " failed with code " << message_sent
+                  << HexSubstr(message->destination_id()) << " failed with code " << message_sent
                   << ".  Will retry to Send.  Attempt count = " << attempt_count + 1
-                  << " id: " << message.id();
-      RecursiveSendOn(message, peer, attempt_count + 1);
+                  << " id: " << message->id();
+      RecursiveSendOn(message, peer, attempt_count + 1, nullptr, payload);
     } else {
-      LOG(kError) << "Sending type " << MessageTypeString(message) << " message from "
+      LOG(kError) << "Sending type " << MessageTypeString(*message) << " message from "
                   << HexSubstr(kThisId) << " to " << HexSubstr(peer.node_id.string())
-                  << " with destination ID " << HexSubstr(message.destination_id())
+                  << " with destination ID " << HexSubstr(message->destination_id())
                   << " failed with code " << message_sent << "  Will remove node."
-                  << " message id: " << message.id();
+                  << " message id: " << message->id();
       {
         std::lock_guard<std::mutex> lock(running_mutex_);
         if (!running_)
@@ -351,11 +416,11 @@ void NetworkUtils::RecursiveSendOn(protobuf::Message message, NodeInfo last_node
       LOG(kWarning) << " Routing-> removing connection " << DebugId(peer.connection_id);
       routing_table_.DropNode(peer.node_id, false);
       client_routing_table_.DropConnection(peer.connection_id);
-      RecursiveSendOn(message);
+      RecursiveSendOn(message, NodeInfo(), 0, nullptr, payload);
     }
   };
-  LOG(kVerbose) << "Rudp recursive send message to " << DebugId(peer.connection_id);
-  RudpSend(peer.connection_id, message, message_sent_functor);
+  TRACE(kVerbose) << "Rudp recursive send message to " << DebugId(peer.connection_id);
+  RudpSend(peer.connection_id, *message, message_sent_functor, payload);
 }
 
 void NetworkUtils::AdjustRouteHistory(protobuf::Message& message) {
@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_ROUTING_NETWORK_UTILS_H_
 #define MAIDSAFE_ROUTING_NETWORK_UTILS_H_
 
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -30,6 +31,7 @@
 
 #include "maidsafe/routing/api_config.h"
 #include "maidsafe/routing/node_info.h"
+#include "maidsafe/routing/shared_buffer.h"
 #include "maidsafe/routing/timer.h"
 
 namespace maidsafe {
@@ -42,6 +44,7 @@ class Message;
 
 class ClientRoutingTable;
 class RoutingTable;
+struct RouteDecision;
 
 namespace test {
 class GenericNode;
@@ -70,11 +73,22 @@ class NetworkUtils {
                     const rudp::MessageSentFunctor& message_sent_functor);
   virtual void SendToDirect(const protobuf::Message& message, const NodeId& peer_node_id,
                             const NodeId& peer_connection_id);
+  // Sends 'message' directly to each of 'peers', addressed to each in turn.  The payload (data and
+  // signature) is serialised once and shared by all of the sends; only the header is serialised
+  // for each peer.  'message' is left as it was.
+  virtual void SendToDirect(protobuf::Message& message, const std::vector<NodeInfo>& peers);
   void SendToDirectAdjustedRoute(protobuf::Message& message, const NodeId& peer_node_id,
                                  const NodeId& peer_connection_id);
   // Handles relay response messages.  Also leave destination ID empty if needs to send as a relay
   // response message
   virtual void SendToClosestNode(const protobuf::Message& message);
+  // As above, for a message whose destination 'route' was worked out for and which the caller has
+  // found isn't one of this node's clients.  The first hop is picked from the route's closest nodes
+  // rather than by searching the routing table again.
+  virtual void SendToClosestNode(const protobuf::Message& message, const RouteDecision& route);
+  // As above, for a message split by ParseMessageHeader.  'payload' is sent on as received.
+  virtual void SendToClosestNode(const protobuf::Message& header, const RouteDecision& route,
+                                 const SharedBuffer& payload);
   void AddToBootstrapFile(const boost::asio::ip::udp::endpoint& endpoint);
   void clear_bootstrap_connection_info();
   void set_new_bootstrap_endpoint_functor(NewBootstrapEndpointFunctor new_bootstrap_endpoint);
@@ -90,12 +104,18 @@ class NetworkUtils {
   NetworkUtils(const NetworkUtils&&);
   NetworkUtils& operator=(const NetworkUtils&);
 
-  void RudpSend(const NodeId& peer_id, const protobuf::Message& message,
-                const rudp::MessageSentFunctor& message_sent_functor);
+  // 'payload', if given, is appended to the serialised message as it stands; see
+  // ParseMessageHeader.  Virtual so that tests can see the bytes which would be sent.
+  virtual void RudpSend(const NodeId& peer_id, const protobuf::Message& message,
+                        const rudp::MessageSentFunctor& message_sent_functor,
+                        const SharedBuffer& payload = SharedBuffer());
   void SendTo(const protobuf::Message& message, const NodeId& peer_node_id,
-              const NodeId& peer_connection_id);
-  void RecursiveSendOn(protobuf::Message message, NodeInfo last_node_attempted = NodeInfo(),
-                       int attempt_count = 0);
+              const NodeId& peer_connection_id, const SharedBuffer& payload = SharedBuffer());
+  // 'message' is shared by every attempt to send it.
+  void RecursiveSendOn(std::shared_ptr<protobuf::Message> message,
+                       NodeInfo last_node_attempted = NodeInfo(), int attempt_count = 0,
+                       const RouteDecision* route = nullptr,
+                       const SharedBuffer& payload = SharedBuffer());
   void AdjustRouteHistory(protobuf::Message& message);
 
   bool running_;
@@ -18,6 +18,7 @@
 
 #include "maidsafe/routing/parameters.h"
 
+#include "maidsafe/common/log.h"
 #include "maidsafe/rudp/parameters.h"
 #include "maidsafe/rudp/managed_connections.h"
 
@@ -42,11 +43,13 @@ std::chrono::seconds Parameters::find_node_interval(10);
 std::chrono::seconds Parameters::recovery_time_lag(5);
 std::chrono::seconds Parameters::re_bootstrap_time_lag(10);
 std::chrono::seconds Parameters::find_close_node_interval(3);
+std::chrono::milliseconds Parameters::matrix_change_coalescing_window(100);
 uint16_t Parameters::find_node_repeats_per_num_requested(3);
 uint16_t Parameters::maximum_find_close_node_failures(10);
 uint16_t Parameters::max_route_history(5);
 uint16_t Parameters::hops_to_live(50);
 uint16_t Parameters::accepted_distance_tolerance(1);
+uint16_t Parameters::average_distance_window(256);
 uint16_t Parameters::greedy_fraction(Parameters::max_routing_table_size * 3 / 4);
 uint16_t Parameters::split_avoidance(4);
 uint16_t Parameters::routing_table_ready_to_response(Parameters::greedy_fraction * 9 / 10);
@@ -67,6 +70,7 @@ bool Parameters::append_maidsafe_local_endpoints(false);
 bool Parameters::append_local_live_port_endpoint(false);
 // TODO(Prakash): BEFORE_RELEASE enable caching after persona tests are passing
 bool Parameters::caching(false);
+int Parameters::trace_level(kVerbose);
 }  // namespace routing
 
 }  // namespace maidsafe
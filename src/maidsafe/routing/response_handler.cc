@@ -58,7 +58,7 @@ ResponseHandler::ResponseHandler(RoutingTable& routing_table,
                                  GroupChangeHandler& group_change_handler)
     : mutex_(), routing_table_(routing_table), client_routing_table_(client_routing_table),
       network_(network), group_change_handler_(group_change_handler), request_public_key_functor_(),
-      unvalidated_matrix_updates() {}
+      unvalidated_matrix_updates(), validated_peers_(), adding_validated_peers_(false) {}
 
 ResponseHandler::~ResponseHandler() {}
 
@@ -183,10 +183,13 @@ void ResponseHandler::FindNodes(const protobuf::Message& message) {
 
   LOG(kVerbose) << find_node_result;
 
+  std::vector<NodeId> found_nodes;
   for (int i = 0; i < find_nodes_response.nodes_size(); ++i) {
     if (!find_nodes_response.nodes(i).empty())
-      CheckAndSendConnectRequest(NodeId(find_nodes_response.nodes(i)));
+      found_nodes.push_back(NodeId(find_nodes_response.nodes(i)));
   }
+  for (const auto& node_id : routing_table_.CheckNodes(found_nodes))
+    CheckAndSendConnectRequest(node_id);
 }
 
 void ResponseHandler::SendConnectRequest(const NodeId peer_node_id) {
@@ -320,22 +323,61 @@ void ResponseHandler::ValidateAndCompleteConnectionToNonClient(
             unvalidated_matrix_updates.erase(matrix_update_itr);
           }
         }
-        if (ValidateAndAddToRoutingTable(response_handler->network_,
-                                         response_handler->routing_table_,
-                                         response_handler->client_routing_table_, peer.node_id,
-                                         peer.connection_id, key, false, matrix_update)) {
-          if (from_requestor) {
-            response_handler->HandleSuccessAcknowledgementAsReponder(peer, false);
-          } else {
-            response_handler->HandleSuccessAcknowledgementAsRequestor(close_ids);
-          }
-        }
+        ValidatedPeer validated_peer;
+        validated_peer.peer = peer;
+        validated_peer.peer.public_key = key;
+        validated_peer.from_requestor = from_requestor;
+        validated_peer.close_ids = close_ids;
+        validated_peer.matrix_update = matrix_update;
+        response_handler->AddValidatedPeer(validated_peer);
       }
     });
     request_public_key_functor_(peer.node_id, validate_node);
   }
 }
 
+void ResponseHandler::AddValidatedPeer(const ValidatedPeer& validated_peer) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    validated_peers_.push_back(validated_peer);
+    if (adding_validated_peers_)
+      return;  // The thread already adding will pick this peer up.
+    adding_validated_peers_ = true;
+  }
+  for (;;) {
+    std::vector<ValidatedPeer> batch;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (validated_peers_.empty()) {
+        adding_validated_peers_ = false;
+        return;
+      }
+      batch.swap(validated_peers_);
+    }
+    std::vector<NodeInfo> peers;
+    std::vector<std::vector<NodeInfo>> matrix_updates;
+    for (const auto& entry : batch) {
+      peers.push_back(entry.peer);
+      matrix_updates.push_back(entry.matrix_update);
+    }
+    std::vector<NodeInfo> added(
+        ValidateAndAddToRoutingTable(network_, routing_table_, peers, matrix_updates));
+    for (const auto& entry : batch) {
+      // A peer queued twice is only completed once, as it would be if added on its own each time.
+      auto itr(std::find_if(added.begin(), added.end(), [&entry](const NodeInfo& node_info) {
+        return node_info.node_id == entry.peer.node_id;
+      }));
+      if (itr == added.end())
+        continue;
+      added.erase(itr);
+      if (entry.from_requestor)
+        HandleSuccessAcknowledgementAsReponder(entry.peer, false);
+      else
+        HandleSuccessAcknowledgementAsRequestor(entry.close_ids);
+    }
+  }
+}
+
 void ResponseHandler::HandleSuccessAcknowledgementAsReponder(NodeInfo peer, bool client) {
   auto count =
       (client ? Parameters::max_routing_table_size_for_client : Parameters::max_routing_table_size);
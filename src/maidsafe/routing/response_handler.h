@@ -32,6 +32,7 @@
 #include "maidsafe/rudp/managed_connections.h"
 
 #include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/node_info.h"
 #include "maidsafe/routing/timer.h"
 
 namespace maidsafe {
@@ -78,6 +79,18 @@ class ResponseHandler : public std::enable_shared_from_this<ResponseHandler> {
                                              const std::vector<NodeId>& close_ids);
   void ValidateAndCompleteConnectionToNonClient(const NodeInfo& peer, bool from_requestor,
                                                 const std::vector<NodeId>& close_ids);
+  // A non-client peer whose public key has arrived, waiting to be added to the routing table.
+  struct ValidatedPeer {
+    NodeInfo peer;
+    bool from_requestor;
+    std::vector<NodeId> close_ids;
+    std::vector<NodeInfo> matrix_update;
+  };
+  // Adds 'validated_peer' to the routing table and completes its connection.  Peers whose keys
+  // arrive while another thread is adding are queued, and that thread adds them all as one batch
+  // once it's done, so a burst of keys (as follows a FindNodes response) costs a few batches rather
+  // than a routing table update each.
+  void AddValidatedPeer(const ValidatedPeer& validated_peer);
 
   mutable std::mutex mutex_;
   RoutingTable& routing_table_;
@@ -86,6 +99,8 @@ class ResponseHandler : public std::enable_shared_from_this<ResponseHandler> {
   GroupChangeHandler& group_change_handler_;
   RequestPublicKeyFunctor request_public_key_functor_;
   std::deque<std::pair<NodeId, std::vector<NodeInfo>>> unvalidated_matrix_updates;
+  std::vector<ValidatedPeer> validated_peers_;
+  bool adding_validated_peers_;
 };
 
 }  // namespace routing
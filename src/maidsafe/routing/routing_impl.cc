@@ -31,10 +31,12 @@
 #include "maidsafe/routing/bootstrap_file_handler.h"
 #include "maidsafe/routing/message.h"
 #include "maidsafe/routing/message_handler.h"
+#include "maidsafe/routing/message_header.h"
 #include "maidsafe/routing/node_info.h"
 #include "maidsafe/routing/return_codes.h"
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/rpcs.h"
+#include "maidsafe/routing/trace.h"
 #include "maidsafe/routing/utils.h"
 #include "maidsafe/routing/network_statistics.h"
 
@@ -109,10 +111,13 @@ Routing::Impl::Impl(bool client_mode, const NodeId& node_id, const asymm::Keys&
       timer_(asio_service_),
       re_bootstrap_timer_(asio_service_.service()),
       recovery_timer_(asio_service_.service()),
-      setup_timer_(asio_service_.service()) {
+      setup_timer_(asio_service_.service()),
+      change_coalescer_(asio_service_.service(), Parameters::matrix_change_coalescing_window) {
   message_handler_.reset(new MessageHandler(routing_table_, client_routing_table_, network_, timer_,
                                             remove_furthest_node_, group_change_handler_,
                                             network_statistics_));
+  // Picks up a logging filter set since the last Routing object was created.
+  RefreshLogFilterLevel();
   LOG(kInfo) << (client_mode ? "client " : "non-client ") << "node. Id : " << DebugId(kNodeId_);
   assert((client_mode || !node_id.IsZero()) && "Server Nodes cannot be created without valid keys");
 }
@@ -120,6 +125,9 @@ Routing::Impl::Impl(bool client_mode, const NodeId& node_id, const asymm::Keys&
 Routing::Impl::~Impl() {
   LOG(kVerbose) << "~Impl " << DebugId(kNodeId_) << ", connection id "
                 << DebugId(routing_table_.kConnectionId());
+  // Stopped first, while everything its functors use is still alive.  Not under running_mutex_,
+  // since a flush under way may be waiting for that.
+  change_coalescer_.Stop();
   std::lock_guard<std::mutex> lock(running_mutex_);
   running_ = false;
 }
@@ -136,6 +144,15 @@ void Routing::Impl::Join(const Functors& functors, const std::vector<Endpoint>&
 
 void Routing::Impl::ConnectFunctors(const Functors& functors) {
   functors_ = functors;
+  // Bursts of changes from the routing table are merged before being passed on; see
+  // ChangeCoalescer.
+  change_coalescer_.InitialiseFunctors([this](const std::vector<NodeInfo> new_nodes,
+                                              const std::vector<NodeInfo> old_nodes) {
+                                         std::lock_guard<std::mutex> lock(running_mutex_);
+                                         if (running_)
+                                           group_change_handler_.SendClosestNodesUpdateRpcs(
+                                               new_nodes, old_nodes);
+                                       }, functors.matrix_changed);
   routing_table_.InitialiseFunctors([this](int network_status_in) {
                                       {
                                         std::lock_guard<std::mutex> lock(network_status_mutex_);
@@ -149,11 +166,15 @@ void Routing::Impl::ConnectFunctors(const Functors& functors) {
                                     [this]() { remove_furthest_node_.RemoveNodeRequest(); },
                                     [this](const std::vector<NodeInfo> new_nodes,
                                            const std::vector<NodeInfo> old_nodes) {
-                                      std::lock_guard<std::mutex> lock(running_mutex_);
-                                      if (running_)
-                                        group_change_handler_.SendClosestNodesUpdateRpcs(new_nodes,
-                                                                                         old_nodes);
-                                    }, functors.matrix_changed);
+                                      change_coalescer_.AddConnectedGroupChange(new_nodes,
+                                                                                old_nodes);
+                                    },
+                                    functors.matrix_changed
+                                        ? MatrixChangedFunctor(
+                                              [this](std::shared_ptr<MatrixChange> matrix_change) {
+                                                change_coalescer_.AddMatrixChange(matrix_change);
+                                              })
+                                        : MatrixChangedFunctor());
   // only one of MessageAndCachingFunctors or TypedMessageAndCachingFunctor should be provided
   assert(!functors.message_and_caching.message_received !=
          !functors.typed_message_and_caching.single_to_single.message_received);
@@ -522,34 +543,45 @@ std::future<std::vector<NodeId>> Routing::Impl::GetGroup(const NodeId& group_id)
 
 void Routing::Impl::OnMessageReceived(const std::string& message) {
   std::lock_guard<std::mutex> lock(running_mutex_);
-  if (running_)
-    asio_service_.service().post([=]() { DoOnMessageReceived(message); });  // NOLINT (Fraser)
+  if (running_) {
+    // The one copy of the received bytes; everything from here on shares them.
+    const SharedBuffer kMessage(message);
+    asio_service_.service().post([=]() { DoOnMessageReceived(kMessage); });  // NOLINT (Fraser)
+  }
 }
 
-void Routing::Impl::DoOnMessageReceived(const std::string& message) {
+void Routing::Impl::DoOnMessageReceived(const SharedBuffer& message) {
+  // Only the header is parsed up front; the payload isn't parsed if the message is just passed on.
   protobuf::Message pb_message;
-  if (pb_message.ParseFromString(message)) {
-    bool relay_message(!pb_message.has_source_id());
-    LOG(kVerbose) << "   [" << DebugId(kNodeId_) << "] rcvd : " << MessageTypeString(pb_message)
+  SharedBuffer payload;
+  if (!ParseMessageHeader(message, pb_message, payload)) {
+    LOG(kWarning) << "Message received, failed to parse";
+    return;
+  }
+  bool relay_message(!pb_message.has_source_id());
+  TRACE(kVerbose) << "   [" << DebugId(kNodeId_) << "] rcvd : " << MessageTypeString(pb_message)
                   << " from " << (relay_message ? HexSubstr(pb_message.relay_id())
                                                 : HexSubstr(pb_message.source_id())) << " to "
                   << HexSubstr(pb_message.destination_id()) << "   (id: " << pb_message.id() << ")"
                   << (relay_message ? " --Relay--" : "");
-    if ((!pb_message.client_node() && pb_message.has_source_id()) ||
-        (!pb_message.direct() && !pb_message.request())) {
-      NodeId source_id(pb_message.source_id());
-      if (!source_id.IsZero())
-        random_node_helper_.Add(source_id);
-    }
-    {
-      std::lock_guard<std::mutex> lock(running_mutex_);
-      if (!running_)
-        return;
-    }
-    message_handler_->HandleMessage(pb_message);
-  } else {
-    LOG(kWarning) << "Message received, failed to parse";
+  if ((!pb_message.client_node() && pb_message.has_source_id()) ||
+      (!pb_message.direct() && !pb_message.request())) {
+    NodeId source_id(pb_message.source_id());
+    if (!source_id.IsZero())
+      random_node_helper_.Add(source_id);
+  }
+  {
+    std::lock_guard<std::mutex> lock(running_mutex_);
+    if (!running_)
+      return;
+  }
+  if (message_handler_->HandleMessageHeader(pb_message, payload))
+    return;
+  if (!MergePayload(payload, pb_message)) {
+    LOG(kWarning) << "Message received, failed to parse payload";
+    return;
   }
+  message_handler_->HandleMessage(pb_message);
 }
 
 void Routing::Impl::OnConnectionLost(const NodeId& lost_connection_id) {
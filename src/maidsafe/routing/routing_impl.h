@@ -34,6 +34,7 @@
 #include "maidsafe/common/rsa.h"
 
 #include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/change_coalescer.h"
 #include "maidsafe/routing/client_routing_table.h"
 #include "maidsafe/routing/group_change_handler.h"
 #include "maidsafe/routing/message_handler.h"
@@ -43,6 +44,7 @@
 #include "maidsafe/routing/routing_api.h"
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/routing_table.h"
+#include "maidsafe/routing/shared_buffer.h"
 #include "maidsafe/routing/timer.h"
 
 namespace maidsafe {
@@ -156,7 +158,7 @@ class Routing::Impl {
   void FindClosestNode(const boost::system::error_code& error_code, int attempts);
   void ReSendFindNodeRequest(const boost::system::error_code& error_code, bool ignore_size);
   void OnMessageReceived(const std::string& message);
-  void DoOnMessageReceived(const std::string& message);
+  void DoOnMessageReceived(const SharedBuffer& message);
   void OnConnectionLost(const NodeId& lost_connection_id);
   void DoOnConnectionLost(const NodeId& lost_connection_id);
   void RemoveNode(const NodeInfo& node, bool internal_rudp_only);
@@ -197,13 +199,15 @@ class Routing::Impl {
   RemoveFurthestNode remove_furthest_node_;
   GroupChangeHandler group_change_handler_;
   // The following variables' declarations should remain the last ones in this class and should stay
-  // in the order: message_handler_, asio_service_, network_, all timers.  This is important for the
-  // proper destruction of the routing library, i.e. to avoid segmentation faults.
+  // in the order: message_handler_, asio_service_, network_, all timers, change_coalescer_.  This is
+  // important for the proper destruction of the routing library, i.e. to avoid segmentation faults.
+  // change_coalescer_ is stopped by ~Impl before any member is destroyed.
   std::unique_ptr<MessageHandler> message_handler_;
   AsioService asio_service_;
   NetworkUtils network_;
   Timer<std::string> timer_;
   boost::asio::steady_timer re_bootstrap_timer_, recovery_timer_, setup_timer_;
+  ChangeCoalescer change_coalescer_;
 };
 
 template <>
@@ -19,27 +19,47 @@
 #include "maidsafe/routing/routing_table.h"
 
 #include <algorithm>
-#include <bitset>
+#include <functional>
 #include <limits>
-#include <map>
+#include <sstream>
 
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/tools/network_viewer.h"
 
+#include "maidsafe/routing/distance_sort.h"
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/node_info.h"
 #include "maidsafe/routing/return_codes.h"
 #include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/sorted_id_lookup.h"
+#include "maidsafe/routing/trace.h"
 
 namespace maidsafe {
 
 namespace routing {
 
+namespace {
+
+const int32_t kBucketCount(NodeId::kSize * 8);
+
+const NodeId& NodeIdOf(const NodeInfo& node_info) { return node_info.node_id; }
+
+bool NodeIdLess(const NodeInfo& lhs, const NodeInfo& rhs) { return lhs.node_id < rhs.node_id; }
+
+// Hash of the DER-encoded key; matching keys always have matching fingerprints.
+size_t PublicKeyFingerprint(const asymm::PublicKey& public_key) {
+  NonEmptyString encoded_key(asymm::EncodeKey(public_key));
+  return std::hash<std::string>()(encoded_key.string());
+}
+
+}  // unnamed namespace
+
 RoutingTable::RoutingTable(bool client_mode, const NodeId& node_id, const asymm::Keys& keys,
                            NetworkStatistics& network_statistics)
     : kClientMode_(client_mode),
       kNodeId_(node_id),
+      kNodeIdValue_(kNodeId_),
       kConnectionId_(kClientMode_ ? NodeId(NodeId::kRandomId) : kNodeId_),
       kKeys_(keys),
       kMaxSize_(kClientMode_ ? Parameters::max_routing_table_size_for_client
@@ -47,15 +67,19 @@ RoutingTable::RoutingTable(bool client_mode, const NodeId& node_id, const asymm:
       kThresholdSize_(kClientMode_ ? Parameters::max_routing_table_size_for_client
                                    : Parameters::routing_table_size_threshold),
       mutex_(),
-      furthest_closest_node_id_((NodeId(NodeId::kMaxId) ^ node_id)),
       remove_node_functor_(),
       network_status_functor_(),
       remove_furthest_node_(),
       connected_group_change_functor_(),
       nodes_(),
+      bucket_counts_(),
+      public_key_index_(),
       group_matrix_(kNodeId_, client_mode),
       ipc_message_queue_(),
-      network_statistics_(network_statistics) {
+      network_statistics_(network_statistics),
+      snapshot_version_(0),
+      snapshot_(std::make_shared<RoutingTableSnapshot>(kNodeId_, snapshot_version_, nodes_,
+                                                        group_matrix_)) {
 #ifdef TESTING
   try {
     ipc_message_queue_.reset(new boost::interprocess::message_queue(
@@ -108,8 +132,129 @@ bool RoutingTable::AddNode(const NodeInfo& peer,
   return AddOrCheckNode(peer, true, matrix_update);
 }
 
+std::vector<NodeInfo> RoutingTable::AddNodes(
+    std::vector<NodeInfo> peers, const std::vector<std::vector<NodeInfo>>& matrix_updates) {
+  assert((matrix_updates.empty() || matrix_updates.size() == peers.size()) &&
+         "One matrix update is needed for each peer");
+  const std::vector<NodeInfo> kNoMatrixUpdate;
+  std::vector<size_t> candidates;
+  for (size_t i(0); i != peers.size(); ++i) {
+    if (peers[i].node_id.IsZero() || peers[i].node_id == kNodeId_) {
+      LOG(kError) << "Attempt to add an invalid node " << DebugId(peers[i].node_id);
+      continue;
+    }
+    if (!asymm::ValidateKey(peers[i].public_key)) {
+      LOG(kInfo) << "Invalid public key for node " << DebugId(peers[i].node_id);
+      continue;
+    }
+    SetBucketIndex(peers[i]);
+    candidates.push_back(i);
+  }
+
+  std::vector<size_t> added;
+  std::vector<NodeInfo> removed_nodes, new_connected_close_nodes, old_connected_close_nodes;
+  std::shared_ptr<MatrixChange> matrix_change;
+  std::vector<NodeId> unique_nodes;
+  uint16_t routing_table_size(0);
+  {
+    UniqueLock lock(mutex_);
+    for (auto i : candidates) {
+      NodeInfo removed_node;
+      if (Find(peers[i].node_id, lock).first ||
+          !MakeSpaceForNodeToBeAdded(peers[i], true, removed_node, lock)) {
+        continue;
+      }
+      InsertNode(peers[i], lock);
+      added.push_back(i);
+      if (removed_node.node_id.IsZero())
+        continue;
+      auto evicted(std::find_if(added.begin(), added.end(), [&](size_t j) {
+        return peers[j].node_id == removed_node.node_id;
+      }));
+      if (evicted != added.end())
+        added.erase(evicted);
+      else
+        removed_nodes.push_back(removed_node);
+    }
+    if (added.empty())
+      return std::vector<NodeInfo>();
+
+    // The group matrix gains those of the batch which are close nodes once it has all been added.
+    old_connected_close_nodes = group_matrix_.GetConnectedPeers();
+    std::vector<NodeId> old_unique_nodes(group_matrix_.GetUniqueNodeIds());
+    const bool kCloseNodesFull(nodes_.size() >= Parameters::closest_nodes_size);
+    NodeId furthest_close_node_id;
+    if (kCloseNodesFull)
+      furthest_close_node_id = ClosestFromTarget(kNodeId_, Parameters::closest_nodes_size).back()
+                                   ->node_id;
+    for (auto i : added) {
+      if (kCloseNodesFull &&
+          NodeId::CloserToTarget(furthest_close_node_id, peers[i].node_id, kNodeId_)) {
+        continue;
+      }
+      group_matrix_.AddConnectedPeer(
+          peers[i], matrix_updates.empty() ? kNoMatrixUpdate : matrix_updates[i]);
+    }
+    new_connected_close_nodes = group_matrix_.GetConnectedPeers();
+    unique_nodes = group_matrix_.GetUniqueNodeIds();
+    matrix_change = std::make_shared<MatrixChange>(
+        MatrixChange(kNodeId_, old_unique_nodes, unique_nodes));
+    routing_table_size = static_cast<uint16_t>(nodes_.size());
+    PublishSnapshot(lock);
+  }
+
+  UpdateNetworkStatus(routing_table_size);
+
+  for (const auto& removed_node : removed_nodes) {
+    LOG(kVerbose) << "Routing table removed node id : " << DebugId(removed_node.node_id)
+                  << ", connection id : " << DebugId(removed_node.connection_id);
+    if (remove_node_functor_)
+      remove_node_functor_(removed_node, false);
+  }
+
+  NotifyCloseNodeChange(new_connected_close_nodes, old_connected_close_nodes, matrix_change,
+                        unique_nodes);
+
+  if (routing_table_size > Parameters::greedy_fraction) {
+    LOG(kVerbose) << "[" << DebugId(kNodeId_) << "] Removing furthest node....";
+    if (remove_furthest_node_)
+      remove_furthest_node_();
+  }
+  TRACE(kInfo) << *Snapshot();
+
+  std::vector<NodeInfo> added_peers;
+  added_peers.reserve(added.size());
+  for (auto i : added)
+    added_peers.push_back(peers[i]);
+  return added_peers;
+}
+
 bool RoutingTable::CheckNode(const NodeInfo& peer) { return AddOrCheckNode(peer, false); }
 
+std::vector<NodeId> RoutingTable::CheckNodes(const std::vector<NodeId>& node_ids) {
+  std::vector<NodeInfo> peers;
+  peers.reserve(node_ids.size());
+  for (const auto& node_id : node_ids) {
+    if (node_id.IsZero() || node_id == kNodeId_)
+      continue;
+    NodeInfo peer;
+    peer.node_id = node_id;
+    peers.push_back(peer);
+  }
+  SetBucketIndices(peers);
+
+  std::vector<NodeId> accepted;
+  UniqueLock lock(mutex_);
+  NodeInfo removed_node;
+  for (const auto& peer : peers) {
+    if (!Find(peer.node_id, lock).first &&
+        MakeSpaceForNodeToBeAdded(peer, false, removed_node, lock)) {
+      accepted.push_back(peer.node_id);
+    }
+  }
+  return accepted;
+}
+
 bool RoutingTable::AddOrCheckNode(NodeInfo peer, bool remove,
                                   const std::vector<NodeInfo>& matrix_update) {
   if (peer.node_id.IsZero() || peer.node_id == kNodeId_) {
@@ -127,11 +272,10 @@ bool RoutingTable::AddOrCheckNode(NodeInfo peer, bool remove,
   uint16_t routing_table_size(0);
   std::shared_ptr<MatrixChange> matrix_change;
 
-  if (remove)
-    SetBucketIndex(peer);
+  SetBucketIndex(peer);
   std::vector<NodeId> unique_nodes;
   {
-    std::unique_lock<std::mutex> lock(mutex_);
+    UniqueLock lock(mutex_);
     auto found(Find(peer.node_id, lock));
     if (found.first) {
       LOG(kVerbose) << "Node " << DebugId(peer.node_id) << " already in routing table.";
@@ -141,20 +285,18 @@ bool RoutingTable::AddOrCheckNode(NodeInfo peer, bool remove,
     if (MakeSpaceForNodeToBeAdded(peer, remove, removed_node, lock)) {
       if (remove) {
         assert(peer.bucket != NodeInfo::kInvalidBucket);
-        nodes_.push_back(peer);
+        InsertNode(peer, lock);
         old_connected_close_nodes = group_matrix_.GetConnectedPeers();
         matrix_change = UpdateCloseNodeChange(lock, peer, new_connected_close_nodes, matrix_update);
         if (nodes_.size() > Parameters::greedy_fraction)
           remove_furthest_node = true;
-        if (nodes_.size() >= Parameters::closest_nodes_size) {
-          NthElementSortFromTarget(kNodeId_, Parameters::closest_nodes_size, lock);
-          furthest_closest_node_id_ = nodes_[Parameters::closest_nodes_size - 1].node_id;
-        }
       }
       return_value = true;
     }
     routing_table_size = static_cast<uint16_t>(nodes_.size());
     unique_nodes = group_matrix_.GetUniqueNodeIds();
+    if (return_value && remove)
+      PublishSnapshot(lock);
   }
 
   if (return_value && remove) {  // Firing functors on Add only
@@ -167,14 +309,8 @@ bool RoutingTable::AddOrCheckNode(NodeInfo peer, bool remove,
         remove_node_functor_(removed_node, false);
     }
 
-    UpdateConnectedPeersMatrix(new_connected_close_nodes, old_connected_close_nodes);
-
-    if ((matrix_change != nullptr) && !matrix_change->OldEqualsToNew()) {
-      network_statistics_.UpdateLocalAverageDistance(unique_nodes);
-      if (matrix_change_functor_)
-        matrix_change_functor_(matrix_change);
-      IpcSendGroupMatrix();
-    }
+    NotifyCloseNodeChange(new_connected_close_nodes, old_connected_close_nodes, matrix_change,
+                          unique_nodes);
 
     if (peer.nat_type == rudp::NatType::kOther) {  // Usable as bootstrap endpoint
                                                    // if (new_bootstrap_endpoint_)
@@ -185,7 +321,7 @@ bool RoutingTable::AddOrCheckNode(NodeInfo peer, bool remove,
       if (remove_furthest_node_)
         remove_furthest_node_();
     }
-    LOG(kInfo) << PrintRoutingTable();
+    TRACE(kInfo) << *Snapshot();
   }
   return return_value;
 }
@@ -196,40 +332,34 @@ NodeInfo RoutingTable::DropNode(const NodeId& node_to_drop, bool routing_only) {
   std::shared_ptr<MatrixChange> matrix_change;
   std::vector<NodeId> unique_nodes;
   {
-    std::unique_lock<std::mutex> lock(mutex_);
+    UniqueLock lock(mutex_);
     auto found(Find(node_to_drop, lock));
     if (found.first) {
       dropped_node = *found.second;
-      nodes_.erase(found.second);
+      EraseNode(found.second, lock);
       old_connected_close_nodes = group_matrix_.GetConnectedPeers();
       matrix_change = group_matrix_.RemoveConnectedPeer(dropped_node);
       new_connected_close_nodes = group_matrix_.GetConnectedPeers();
       if (new_connected_close_nodes.size() != old_connected_close_nodes.size()) {
         if (nodes_.size() >= Parameters::closest_nodes_size) {
-          PartialSortFromTarget(kNodeId_, Parameters::closest_nodes_size, lock);
-          furthest_closest_node_id_ = nodes_[Parameters::closest_nodes_size - 1].node_id;
-          group_matrix_.AddConnectedPeer(nodes_[Parameters::closest_nodes_size - 1]);
+          auto furthest_close_node(
+              ClosestFromTarget(kNodeId_, Parameters::closest_nodes_size).back());
+          group_matrix_.AddConnectedPeer(*furthest_close_node);
           new_connected_close_nodes = group_matrix_.GetConnectedPeers();
-        } else {
-          furthest_closest_node_id_ = (NodeId(NodeId::kMaxId) ^ kNodeId_);
         }
       }
+      PublishSnapshot(lock);
     }
     unique_nodes = group_matrix_.GetUniqueNodeIds();
   }
 
-  UpdateConnectedPeersMatrix(new_connected_close_nodes, old_connected_close_nodes);
-
-  if ((matrix_change != nullptr) && !matrix_change->OldEqualsToNew()) {
-    network_statistics_.UpdateLocalAverageDistance(unique_nodes);
-    if (matrix_change_functor_)
-      matrix_change_functor_(matrix_change);
-    IpcSendGroupMatrix();
-  }
+  NotifyCloseNodeChange(new_connected_close_nodes, old_connected_close_nodes, matrix_change,
+                        unique_nodes);
 
   if (!dropped_node.node_id.IsZero()) {
-    assert(nodes_.size() <= std::numeric_limits<uint16_t>::max());
-    UpdateNetworkStatus(static_cast<uint16_t>(nodes_.size()));
+    size_t routing_table_size(size());
+    assert(routing_table_size <= std::numeric_limits<uint16_t>::max());
+    UpdateNetworkStatus(static_cast<uint16_t>(routing_table_size));
   }
 
   if (!dropped_node.node_id.IsZero()) {
@@ -239,85 +369,21 @@ NodeInfo RoutingTable::DropNode(const NodeId& node_to_drop, bool routing_only) {
     if (remove_node_functor_ && !routing_only)
       remove_node_functor_(dropped_node, false);
   }
-  LOG(kInfo) << PrintRoutingTable();
+  TRACE(kInfo) << *Snapshot();
   return dropped_node;
 }
 
 bool RoutingTable::IsThisNodeGroupLeader(const NodeId& target_id, NodeInfo& connected_peer) {
-  NodeId current_closest_id(kNodeId_);
-  NodeId closest_peer_id(GetClosestNode(target_id, true).node_id);
-  if (NodeId::CloserToTarget(closest_peer_id, current_closest_id, target_id))
-    current_closest_id = closest_peer_id;
-
-  std::unique_lock<std::mutex> lock(mutex_);
-  group_matrix_.GetBetterNodeForSendingMessage(target_id, true, current_closest_id);
-  if (current_closest_id != kNodeId_) {
-    auto found(Find(current_closest_id, lock));
-    if (found.first) {
-      connected_peer = *found.second;
-      return false;
-    }
-  }
-  return true;
+  return Snapshot()->IsThisNodeGroupLeader(target_id, connected_peer);
 }
 
 bool RoutingTable::IsThisNodeGroupLeader(const NodeId& target_id, NodeInfo& connected_peer,
                                          const std::vector<std::string>& exclude) {
-  NodeInfo current_closest;
-  current_closest.node_id = kNodeId_;
-  NodeInfo closest_peer(GetClosestNode(target_id, exclude, true));
-  if (NodeId::CloserToTarget(closest_peer.node_id, current_closest.node_id, target_id))
-    current_closest = closest_peer;
-  {
-    std::unique_lock<std::mutex> lock(mutex_);
-    group_matrix_.GetBetterNodeForSendingMessage(target_id, exclude, true, current_closest);
-    if (current_closest.node_id != kNodeId_) {
-      auto found(Find(current_closest.node_id, lock));
-      if (found.first) {
-        connected_peer = *found.second;
-        return false;
-      }
-    }
-  }
-  for (const auto& excluded : exclude) {
-    try {
-      NodeId excluded_id(excluded);
-      if (excluded_id != target_id && NodeId::CloserToTarget(excluded_id, kNodeId_, target_id)) {
-        if (connected_peer.node_id.IsZero())
-          connected_peer = closest_peer;
-        return false;
-      }
-    }
-    catch (const std::exception& ex) {
-      LOG(kError) << "Got invalid string for Node ID. Exception: " << ex.what();
-    }
-  }
-  return true;
+  return Snapshot()->IsThisNodeGroupLeader(target_id, connected_peer, exclude);
 }
 
 bool RoutingTable::ClosestToId(const NodeId& target_id) {
-  if (target_id == kNodeId_)
-    return false;
-
-  std::unique_lock<std::mutex> lock(mutex_);
-  if (nodes_.empty())  // should return false ?
-    return true;
-
-  if (nodes_.size() == 1) {
-    if (nodes_.at(0).node_id == target_id)
-      return true;
-    else
-      return NodeId::CloserToTarget(kNodeId_, nodes_.at(0).node_id, target_id);
-  }
-
-  PartialSortFromTarget(target_id, 2, lock);
-  uint16_t index(0);
-  if (nodes_.at(0).node_id == target_id)
-    index = 1;
-  if (!NodeId::CloserToTarget(kNodeId_, nodes_.at(index).node_id, target_id))
-    return false;
-
-  return group_matrix_.ClosestToId(target_id);
+  return Snapshot()->ClosestToId(target_id);
 }
 
 GroupRangeStatus RoutingTable::IsNodeIdInGroupRange(const NodeId& group_id) const {
@@ -326,83 +392,53 @@ GroupRangeStatus RoutingTable::IsNodeIdInGroupRange(const NodeId& group_id) cons
 
 GroupRangeStatus RoutingTable::IsNodeIdInGroupRange(const NodeId& group_id,
                                                     const NodeId& node_id) const {
-  std::lock_guard<std::mutex> lock(mutex_);
-  return group_matrix_.IsNodeIdInGroupRange(group_id, node_id);
+  return Snapshot()->IsNodeIdInGroupRange(group_id, node_id);
 }
 
 NodeId RoutingTable::RandomConnectedNode() {
-  std::unique_lock<std::mutex> lock(mutex_);
+  SharedLock lock(mutex_);
   assert(nodes_.size() > Parameters::closest_nodes_size &&
          "Shouldn't call RandomConnectedNode when routing table size is <= closest_nodes_size");
   if (nodes_.size() <= Parameters::closest_nodes_size)
     return NodeId();
 
-  PartialSortFromTarget(kNodeId_, static_cast<uint16_t>(nodes_.size()), lock);
-  size_t index(Parameters::closest_nodes_size +
-               RandomUint32() % (nodes_.size() - Parameters::closest_nodes_size));
-  return nodes_.at(index).node_id;
+  // Pick uniformly from the nodes outside our close group.
+  auto close_nodes(ClosestFromTarget(kNodeId_, Parameters::closest_nodes_size));
+  auto furthest_close_node_id(close_nodes.back()->node_id);
+  size_t index(RandomUint32() % (nodes_.size() - Parameters::closest_nodes_size));
+  for (const auto& node : nodes_) {
+    if (NodeId::CloserToTarget(furthest_close_node_id, node.node_id, kNodeId_) && index-- == 0)
+      return node.node_id;
+  }
+  assert(false && "Failed to pick a node outside the close group.");
+  return NodeId();
 }
 
 std::vector<NodeInfo> RoutingTable::GetMatrixNodes() {
-  std::lock_guard<std::mutex> lock(mutex_);
-  return group_matrix_.GetUniqueNodes();
+  return Snapshot()->group_matrix().GetUniqueNodes();
 }
 
-bool RoutingTable::IsConnected(const NodeId& node_id) {
-  if (Contains(node_id))
-    return true;
-  std::lock_guard<std::mutex> lock(mutex_);
-  return group_matrix_.Contains(node_id);
-}
+bool RoutingTable::IsConnected(const NodeId& node_id) { return Snapshot()->IsConnected(node_id); }
 
 bool RoutingTable::GetNodeInfo(const NodeId& node_id, NodeInfo& peer) const {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto found(Find(node_id, lock));
-  if (found.first)
-    peer = *found.second;
-  return found.first;
+  return Snapshot()->GetNodeInfo(node_id, peer);
 }
 
 bool RoutingTable::IsThisNodeInRange(const NodeId& target_id, const uint16_t range) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  if (nodes_.size() < range)
-    return true;
-  NthElementSortFromTarget(kNodeId_, range, lock);
-  return NodeId::CloserToTarget(target_id, nodes_[range - 1].node_id, kNodeId_);
+  return Snapshot()->IsThisNodeInRange(target_id, range);
 }
 
 bool RoutingTable::IsThisNodeClosestTo(const NodeId& target_id, bool ignore_exact_match) {
-  if (target_id.IsZero()) {
-    LOG(kError) << "Invalid target_id passed.";
-    return false;
-  }
-  NodeInfo closest_node(GetClosestNode(target_id, ignore_exact_match));
-  return (closest_node.bucket == NodeInfo::kInvalidBucket) ||
-         NodeId::CloserToTarget(kNodeId_, closest_node.node_id, target_id);
+  return Snapshot()->IsThisNodeClosestTo(target_id, ignore_exact_match);
 }
 
 bool RoutingTable::IsThisNodeClosestToIncludingMatrix(const NodeId& target_id,
                                                       bool ignore_exact_match) {
-  if (target_id.IsZero()) {
-    LOG(kError) << "Invalid target_id passed.";
-    return false;
-  }
-  NodeInfo closest_node(GetClosestNode(target_id, ignore_exact_match));
-
-  if (closest_node.bucket == NodeInfo::kInvalidBucket)
-    return true;  // ?
-
-  if (!NodeId::CloserToTarget(kNodeId_, closest_node.node_id, target_id))
-    return false;
-
-  NodeId connected_peer;
-  std::lock_guard<std::mutex> lock(mutex_);
-  return group_matrix_.IsThisNodeGroupLeader(target_id, connected_peer);  // use connected peer?
+  return Snapshot()->IsThisNodeClosestToIncludingMatrix(target_id, ignore_exact_match);
 }
 
 bool RoutingTable::Contains(const NodeId& node_id) const {
-  std::unique_lock<std::mutex> lock(mutex_);
-  return Find(node_id, lock).first;
+  return Snapshot()->Contains(node_id);
 }
 
 bool RoutingTable::ConfirmGroupMembers(const NodeId& node1, const NodeId& node2) {
@@ -415,7 +451,7 @@ void RoutingTable::GroupUpdateFromConnectedPeer(const NodeId& peer,
   std::shared_ptr<MatrixChange> matrix_change;
   std::vector<NodeInfo> new_connected_peers, old_connected_peers;
   {
-    std::unique_lock<std::mutex> lock(mutex_);
+    UniqueLock lock(mutex_);
     std::vector<NodeId> old_unique_ids(group_matrix_.GetUniqueNodeIds());
     old_connected_peers = group_matrix_.GetConnectedPeers();
     if (std::find_if(old_connected_peers.begin(), old_connected_peers.end(),
@@ -428,6 +464,7 @@ void RoutingTable::GroupUpdateFromConnectedPeer(const NodeId& peer,
     }
     matrix_change = group_matrix_.UpdateFromConnectedPeer(peer, nodes, old_unique_ids);
     new_connected_peers = group_matrix_.GetConnectedPeers();
+    PublishSnapshot(lock);
   }
   if (!matrix_change->OldEqualsToNew() && matrix_change_functor_)
     matrix_change_functor_(matrix_change);
@@ -446,54 +483,64 @@ void RoutingTable::UpdateConnectedPeersMatrix(const std::vector<NodeInfo>& new_c
       connected_group_change_functor_(new_connected_peers, old_connected_peers);
 }
 
+void RoutingTable::NotifyCloseNodeChange(const std::vector<NodeInfo>& new_connected_close_nodes,
+                                         const std::vector<NodeInfo>& old_connected_close_nodes,
+                                         std::shared_ptr<MatrixChange> matrix_change,
+                                         std::vector<NodeId>& unique_nodes) {
+  UpdateConnectedPeersMatrix(new_connected_close_nodes, old_connected_close_nodes);
+
+  if ((matrix_change != nullptr) && !matrix_change->OldEqualsToNew()) {
+    network_statistics_.UpdateLocalAverageDistance(unique_nodes);
+    if (matrix_change_functor_)
+      matrix_change_functor_(matrix_change);
+    IpcSendGroupMatrix();
+  }
+}
+
 std::shared_ptr<MatrixChange> RoutingTable::UpdateCloseNodeChange(
-    std::unique_lock<std::mutex>& lock, const NodeInfo& peer,
-    std::vector<NodeInfo>& new_connected_nodes, const std::vector<NodeInfo>& matrix_update) {
+    UniqueLock& lock, const NodeInfo& peer, std::vector<NodeInfo>& new_connected_nodes,
+    const std::vector<NodeInfo>& matrix_update) {
   assert(lock.owns_lock());
+  static_cast<void>(lock);
   std::shared_ptr<MatrixChange> matrix_change;
-  PartialSortFromTarget(kNodeId_, Parameters::closest_nodes_size, lock);
   if ((nodes_.size() < Parameters::closest_nodes_size ||
-       !NodeId::CloserToTarget(nodes_[Parameters::closest_nodes_size - 1].node_id, peer.node_id,
-                               kNodeId_))) {
+       !NodeId::CloserToTarget(
+           ClosestFromTarget(kNodeId_, Parameters::closest_nodes_size).back()->node_id,
+           peer.node_id, kNodeId_))) {
     matrix_change = group_matrix_.AddConnectedPeer(peer, matrix_update);
   }
   new_connected_nodes = group_matrix_.GetConnectedPeers();
   return matrix_change;
 }
 
-// bucket 0 is us, 511 is furthest bucket (should fill first)
+// bucket 0 is us, 511 is furthest bucket (should fill first).  The bucket is the index of the
+// most significant bit in which the ids differ.
 void RoutingTable::SetBucketIndex(NodeInfo& node_info) const {
-  std::string holder_raw_id(kNodeId_.string());
-  std::string node_raw_id(node_info.node_id.string());
-  int16_t byte_index(0);
-  while (byte_index != NodeId::kSize) {
-    if (holder_raw_id[byte_index] != node_raw_id[byte_index]) {
-      std::bitset<8> holder_byte(static_cast<int>(holder_raw_id[byte_index]));
-      std::bitset<8> node_byte(static_cast<int>(node_raw_id[byte_index]));
-      int16_t bit_index(0);
-      while (bit_index != 8U) {
-        if (holder_byte[7U - bit_index] != node_byte[7U - bit_index])
-          break;
-        ++bit_index;
-      }
-      node_info.bucket = (8 * (NodeId::kSize - byte_index)) - bit_index - 1;
-      return;
-    }
-    ++byte_index;
-  }
-  node_info.bucket = 0;
+  Uint512 distance(kNodeIdValue_ ^ Uint512(node_info.node_id));
+  node_info.bucket = distance.IsZero() ? 0 : (NodeId::kSize * 8) - 1 - distance.CountLeadingZeros();
 }
 
-bool RoutingTable::CheckPublicKeyIsUnique(const NodeInfo& node,
-                                          std::unique_lock<std::mutex>& lock) const {
+void RoutingTable::SetBucketIndices(std::vector<NodeInfo>& nodes) const {
+  for (auto& node : nodes)
+    SetBucketIndex(node);
+}
+
+bool RoutingTable::CheckPublicKeyIsUnique(const NodeInfo& node, UniqueLock& lock) const {
   assert(lock.owns_lock());
   static_cast<void>(lock);
-  // If we already have a duplicate public key return false
-  if (std::find_if(nodes_.begin(), nodes_.end(), [node](const NodeInfo & node_info) {
-        return asymm::MatchingKeys(node_info.public_key, node.public_key);
-      }) != nodes_.end()) {
-    LOG(kInfo) << "Already have node with this public key";
-    return false;
+  // If we already have a duplicate public key return false.  Only those nodes whose key has the
+  // same fingerprint need their keys compared in full.
+  auto candidates(public_key_index_.equal_range(PublicKeyFingerprint(node.public_key)));
+  for (auto candidate(candidates.first); candidate != candidates.second; ++candidate) {
+    auto existing(std::lower_bound(nodes_.begin(), nodes_.end(), candidate->second,
+                                   [](const NodeInfo & node_info, const NodeId & id) {
+      return node_info.node_id < id;
+    }));
+    assert(existing != nodes_.end() && existing->node_id == candidate->second);
+    if (asymm::MatchingKeys(existing->public_key, node.public_key)) {
+      LOG(kInfo) << "Already have node with this public key";
+      return false;
+    }
   }
 
   // If the endpoint is kNonRoutable then no need to check for endpoint duplication.
@@ -513,8 +560,7 @@ bool RoutingTable::CheckPublicKeyIsUnique(const NodeInfo& node,
 }
 
 bool RoutingTable::MakeSpaceForNodeToBeAdded(const NodeInfo& node, bool remove,
-                                             NodeInfo& removed_node,
-                                             std::unique_lock<std::mutex>& lock) {
+                                             NodeInfo& removed_node, UniqueLock& lock) {
   assert(lock.owns_lock());
 
   if (remove && !CheckPublicKeyIsUnique(node, lock))
@@ -523,35 +569,45 @@ bool RoutingTable::MakeSpaceForNodeToBeAdded(const NodeInfo& node, bool remove,
   if (nodes_.size() < kMaxSize_)
     return true;
 
-  PartialSortFromTarget(kNodeId_, Parameters::closest_nodes_size, lock);
-  NodeInfo furthest_close_node = nodes_[Parameters::closest_nodes_size - 1];
-  auto const furthest_close_node_iter = nodes_.begin() + (Parameters::closest_nodes_size - 1);
+  auto close_nodes(ClosestFromTarget(kNodeId_, Parameters::closest_nodes_size));
+  ConstIterator furthest_close_node(close_nodes.back());
 
-  if (NodeId::CloserToTarget(node.node_id, furthest_close_node.node_id, kNodeId_)) {
+  if (NodeId::CloserToTarget(node.node_id, furthest_close_node->node_id, kNodeId_)) {
     if (remove) {
-      assert(node.bucket <= furthest_close_node.bucket &&
+      assert(node.bucket <= furthest_close_node->bucket &&
              "close node replacement to higher bucket");
-      removed_node = *furthest_close_node_iter;
-      nodes_.erase(furthest_close_node_iter);
+      removed_node = *furthest_close_node;
+      EraseNode(furthest_close_node, lock);
     }
     return true;
   }
 
-  uint16_t size(Parameters::bucket_target_size + 1);
-  for (auto it = furthest_close_node_iter; it != nodes_.end(); ++it) {
-    if (node.bucket >= (*it).bucket)  // Stop searching as it's worthless
-      return false;
-    // Safety net
-    if ((nodes_.end() - it) < size)  // Reached end of checkable area
+  // Outside the close nodes (but including the furthest of them), look for the nearest bucket
+  // holding more than bucket_target_size + 1 nodes.  Only buckets further out than the new node's
+  // one are worth giving up a node for; the one given up is that bucket's closest to this node.
+  for (int32_t bucket(furthest_close_node->bucket); bucket < kBucketCount; ++bucket) {
+    size_t count(bucket_counts_[bucket]);
+    if (bucket == furthest_close_node->bucket) {
+      count -= std::count_if(close_nodes.begin(), close_nodes.end() - 1,
+                             [bucket](ConstIterator close_node) {
+        return close_node->bucket == bucket;
+      });
+    }
+    if (count == 0)
+      continue;
+    if (node.bucket >= bucket)  // Stop searching as it's worthless
       return false;
-
-    if ((*it).bucket == (*(it + size)).bucket) {
+    if (count > Parameters::bucket_target_size + 1U) {
       // Here we know the node should fit into a bucket if the bucket has too many nodes AND node to
       // add has a lower bucket index
-      assert(node.bucket < (*it).bucket);
+      ConstIterator removable(furthest_close_node);
+      if (bucket != furthest_close_node->bucket) {
+        auto range(BucketRange(bucket));
+        removable = ClosestInSortedRange(range.first, range.second, kNodeId_, 1, NodeIdOf).front();
+      }
       if (remove) {
-        removed_node = *it;
-        nodes_.erase(it);
+        removed_node = *removable;
+        EraseNode(removable, lock);
       }
       return true;
     }
@@ -559,138 +615,75 @@ bool RoutingTable::MakeSpaceForNodeToBeAdded(const NodeInfo& node, bool remove,
   return false;
 }
 
-uint16_t RoutingTable::PartialSortFromTarget(const NodeId& target, uint16_t number,
-                                             std::unique_lock<std::mutex>& lock) {
-  assert(lock.owns_lock());
-  static_cast<void>(lock);
-  uint16_t count = std::min(number, static_cast<uint16_t>(nodes_.size()));
-  std::partial_sort(nodes_.begin(), nodes_.begin() + count, nodes_.end(),
-                    [target](const NodeInfo & lhs, const NodeInfo & rhs) {
-    return NodeId::CloserToTarget(lhs.node_id, rhs.node_id, target);
-  });
-  return count;
-}
+NodeId RoutingTable::FurthestCloseNode() const { return Snapshot()->furthest_close_node_id(); }
 
-void RoutingTable::NthElementSortFromTarget(const NodeId& target, uint16_t nth_element,
-                                            std::unique_lock<std::mutex>& lock) {
-  assert(lock.owns_lock());
-  static_cast<void>(lock);
-  assert((nodes_.size() >= nth_element) &&
-         "This should only be called when n is at max the size of RT");
-#ifndef __GNUC__
-  std::nth_element(nodes_.begin(), nodes_.begin() + nth_element - 1, nodes_.end(),
-                   [target](const NodeInfo & lhs, const NodeInfo & rhs) {
-                       return NodeId::CloserToTarget(lhs.node_id, rhs.node_id, target);
-                   });
-#else
-// BEFORE_RELEASE use std::nth_element() for all platform when min required Gcc version is 4.8.3
-// http://gcc.gnu.org/bugzilla/show_bug.cgi?id=58800 Bug fixed in gcc 4.8.3
-  std::partial_sort(nodes_.begin(), nodes_.begin() + nth_element - 1, nodes_.end(),
-                    [target](const NodeInfo & lhs, const NodeInfo & rhs) {
-                        return NodeId::CloserToTarget(lhs.node_id, rhs.node_id, target);
-                    });
-#endif
-}
-
-NodeId RoutingTable::FurthestCloseNode() {
-  return GetNthClosestNode(kNodeId_, Parameters::closest_nodes_size).node_id;
+NodeId RoutingTable::FurthestClientCloseNode() const {
+  return Snapshot()->furthest_client_close_node_id();
 }
 
 NodeInfo RoutingTable::GetClosestNode(const NodeId& target_id, bool ignore_exact_match) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  int sorted_count(PartialSortFromTarget(target_id, 2, lock));
-  if (sorted_count == 0)
-    return NodeInfo();
-  if (ignore_exact_match && (nodes_[0].node_id == target_id))
-    return (sorted_count == 1) ? NodeInfo() : nodes_[1];
-  return nodes_[0];
+  return Snapshot()->GetClosestNode(target_id, ignore_exact_match);
 }
 
 NodeInfo RoutingTable::GetClosestNode(const NodeId& target_id,
                                       const std::vector<std::string>& exclude,
                                       bool ignore_exact_match) {
-  std::vector<NodeInfo> closest_nodes(
-      GetClosestNodeInfo(target_id, Parameters::closest_nodes_size, ignore_exact_match));
-  for (const auto& node_info : closest_nodes) {
-    if (std::find(exclude.begin(), exclude.end(), node_info.node_id.string()) == exclude.end())
-      return node_info;
-  }
-  return NodeInfo();
+  return Snapshot()->GetClosestNode(target_id, exclude, ignore_exact_match);
 }
 
-/*
-NodeInfo RoutingTable::GetNodeForSendingMessage(const NodeId& target_id,
-                                                bool ignore_exact_match) {
-  NodeInfo node_info(GetClosestNode(target_id, ignore_exact_match));
-
-  if (node_info.node_id != target_id) {
-    std::vector<NodeInfo> connected_peers(group_matrix_.GetAllConnectedPeersFor(target_id));
-    if (connected_peers.empty())
-      return node_info;
-
-    return connected_peers.at(0);
-  }
-  return node_info;
-}
-*/
-
 NodeInfo RoutingTable::GetNodeForSendingMessage(const NodeId& target_id,
                                                 const std::vector<std::string>& exclude,
                                                 bool ignore_exact_match) {
-  NodeInfo current_peer(GetClosestNode(target_id, exclude, ignore_exact_match));
-  if (current_peer.node_id != target_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    group_matrix_.GetBetterNodeForSendingMessage(target_id, exclude, ignore_exact_match,
-                                                 current_peer);
-  }
-  std::string excluded_ids;
-  for (const auto& excluded_id : exclude) {
-    excluded_ids.append("\t");
-    excluded_ids.append(HexSubstr(excluded_id));
-  }
-  LOG(kVerbose) << "[" << DebugId(kNodeId_) << "] - best node to send to is "
-                << DebugId(current_peer.node_id) << " (Excluded: " << excluded_ids << ")";
-  return current_peer;
+  return Snapshot()->GetNodeForSendingMessage(target_id, exclude, ignore_exact_match);
 }
 
 NodeInfo RoutingTable::GetRemovableNode(std::vector<std::string> attempted) {
-  std::map<uint32_t, uint16_t> bucket_rank_map;
-  std::unique_lock<std::mutex> lock(mutex_);
-  PartialSortFromTarget(kNodeId_, static_cast<uint16_t>(nodes_.size()), lock);
-
-  auto const from_iterator(nodes_.begin() + Parameters::closest_nodes_size);
-
-  for (auto it = from_iterator; it != nodes_.end(); ++it) {
-    if (std::find(attempted.begin(), attempted.end(), ((*it).node_id.string())) ==
-        attempted.end()) {
-      auto bucket_iter = bucket_rank_map.find((*it).bucket);
-      if (bucket_iter != bucket_rank_map.end()) {
-        (*bucket_iter).second++;
-      } else {
-        bucket_rank_map.insert(bucket_rank_map.begin(), std::pair<int, int>((*it).bucket, 1));
-      }
-    }
-  }
+  SharedLock lock(mutex_);
+  auto closest(ClosestFromTarget(kNodeId_,
+                                 Parameters::closest_nodes_size + Parameters::group_size + 1));
+  auto const close_end(closest.begin() +
+                       std::min(closest.size(), static_cast<size_t>(Parameters::closest_nodes_size)));
+
+  // Candidates are the non-close nodes which haven't already been attempted.
+  std::vector<ConstIterator> excluded(closest.begin(), close_end);
+  for (const auto& attempted_id : attempted) {
+    if (attempted_id.size() != NodeId::kSize)
+      continue;
+    NodeId node_id(attempted_id);
+    auto itr(std::lower_bound(nodes_.cbegin(), nodes_.cend(), node_id,
+                              [](const NodeInfo & node_info, const NodeId & id) {
+      return node_info.node_id < id;
+    }));
+    if (itr != nodes_.cend() && itr->node_id == node_id)
+      excluded.push_back(itr);
+  }
+  std::sort(excluded.begin(), excluded.end());
+  excluded.erase(std::unique(excluded.begin(), excluded.end()), excluded.end());
+  std::array<uint16_t, NodeId::kSize * 8> candidate_counts(bucket_counts_);
+  for (const auto& itr : excluded)
+    --candidate_counts[itr->bucket];
 
   int32_t max_bucket(0), max_bucket_count(1);
-  for (auto& elem : bucket_rank_map) {
-    if ((elem).second >= max_bucket_count) {
-      max_bucket = (elem).first;
-      max_bucket_count = (elem).second;
+  for (int32_t bucket(0); bucket < kBucketCount; ++bucket) {
+    if (candidate_counts[bucket] >= max_bucket_count) {
+      max_bucket = bucket;
+      max_bucket_count = candidate_counts[bucket];
     }
   }
 
   LOG(kVerbose) << "[" << DebugId(kNodeId_) << "] max_bucket " << max_bucket << " count "
                 << max_bucket_count;
   if (max_bucket_count == 1) {
-    return nodes_[Parameters::closest_nodes_size + Parameters::group_size];
+    size_t index(Parameters::closest_nodes_size + Parameters::group_size);
+    return closest.size() > index ? *closest[index] : NodeInfo();
   }
 
   NodeInfo removable_node;
-  for (auto it(from_iterator); it != nodes_.end(); ++it) {
-    if (((*it).bucket == max_bucket) &&
-        std::find(attempted.begin(), attempted.end(), (*it).node_id.string()) == attempted.end()) {
-      removable_node = (*it);
+  auto range(BucketRange(max_bucket));
+  for (const auto& itr : ClosestInSortedRange(range.first, range.second, kNodeId_,
+                                              range.second - range.first, NodeIdOf)) {
+    if (!std::binary_search(excluded.begin(), excluded.end(), itr)) {
+      removable_node = *itr;
       break;
     }
   }
@@ -700,50 +693,28 @@ NodeInfo RoutingTable::GetRemovableNode(std::vector<std::string> attempted) {
 }
 
 void RoutingTable::GetNodesNeedingGroupUpdates(std::vector<NodeInfo>& nodes_needing_update) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  int sorted_count(PartialSortFromTarget(kNodeId_, Parameters::closest_nodes_size, lock));
-  if (sorted_count == 0)
-    return;
-  for (auto iter(nodes_.begin());
-       iter != (nodes_.begin() +
-                std::min(Parameters::closest_nodes_size, static_cast<uint16_t>(nodes_.size())));
-       ++iter) {
-    if (group_matrix_.IsRowEmpty(*iter))
-      nodes_needing_update.push_back(*iter);
+  SharedLock lock(mutex_);
+  for (const auto& close_node : ClosestFromTarget(kNodeId_, Parameters::closest_nodes_size)) {
+    if (group_matrix_.IsRowEmpty(*close_node))
+      nodes_needing_update.push_back(*close_node);
   }
 }
 
 NodeInfo RoutingTable::GetNthClosestNode(const NodeId& target_id, uint16_t node_number) {
-  assert((node_number > 0) && "Node number starts with position 1");
-  std::unique_lock<std::mutex> lock(mutex_);
-  if (nodes_.size() < node_number) {
-    NodeInfo node_info;
-    node_info.node_id = (NodeId(NodeId::kMaxId) ^ kNodeId_);
-    return node_info;
-  }
-  NthElementSortFromTarget(target_id, node_number, lock);
-  return nodes_[node_number - 1];
+  return Snapshot()->GetNthClosestNode(target_id, node_number);
 }
 
 std::vector<NodeId> RoutingTable::GetClosestNodes(const NodeId& target_id, uint16_t number_to_get) {
-  std::vector<NodeId> close_nodes;
-  std::unique_lock<std::mutex> lock(mutex_);
-  int sorted_count(PartialSortFromTarget(target_id, number_to_get, lock));
-
-  for (int i = 0; i != sorted_count; ++i)
-    close_nodes.push_back(nodes_[i].node_id);
-  return close_nodes;
+  return Snapshot()->GetClosestNodes(target_id, number_to_get);
 }
 
 std::vector<NodeInfo> RoutingTable::GetClosestMatrixNodes(const NodeId& target_id,
                                                           uint16_t number_to_get) {
   std::vector<NodeInfo> closest_matrix_nodes(GetMatrixNodes());
   size_t sorting_size(std::min(static_cast<size_t>(number_to_get), closest_matrix_nodes.size()));
-  std::partial_sort(closest_matrix_nodes.begin(), closest_matrix_nodes.begin() + sorting_size,
-                    closest_matrix_nodes.end(),
-                    [&target_id](const NodeInfo & lhs, const NodeInfo & rhs) {
-    return NodeId::CloserToTarget(lhs.node_id, rhs.node_id, target_id);
-  });
+  PartialSortByDistance(closest_matrix_nodes.begin(),
+                        closest_matrix_nodes.begin() + sorting_size, closest_matrix_nodes.end(),
+                        target_id);
   closest_matrix_nodes.resize(sorting_size);
   return closest_matrix_nodes;
 }
@@ -751,52 +722,58 @@ std::vector<NodeInfo> RoutingTable::GetClosestMatrixNodes(const NodeId& target_i
 std::vector<NodeId> RoutingTable::GetGroup(const NodeId& target_id) {
   std::vector<NodeInfo> nodes(GetMatrixNodes());
   std::vector<NodeId> group;
-  std::partial_sort(nodes.begin(), nodes.begin() + Parameters::group_size, nodes.end(),
-                    [&](const NodeInfo & lhs, const NodeInfo & rhs) {
-    return NodeId::CloserToTarget(lhs.node_id, rhs.node_id, target_id);
-  });
+  PartialSortByDistance(nodes.begin(), nodes.begin() + Parameters::group_size, nodes.end(),
+                        target_id);
   for (auto iter(nodes.begin()); iter != nodes.begin() + Parameters::group_size; ++iter)
     group.push_back(iter->node_id);
   return group;
 }
 
-std::vector<NodeInfo> RoutingTable::GetClosestNodeInfo(const NodeId& target_id,
-                                                       uint16_t number_to_get,
-                                                       bool ignore_exact_match) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  int sorted_count(PartialSortFromTarget(target_id, number_to_get + 1, lock));
-  if (sorted_count == 0)
-    return std::vector<NodeInfo>();
-
-  auto itr(nodes_.begin());
-  if (ignore_exact_match && ((*itr).node_id == target_id)) {
-    return (sorted_count == 1)
-               ? std::vector<NodeInfo>()
-               : std::vector<NodeInfo>(nodes_.begin() + 1, nodes_.begin() + sorted_count);
-  }
-
-  return std::vector<NodeInfo>(
-      nodes_.begin(), nodes_.begin() + std::min(sorted_count, static_cast<int>(number_to_get)));
+std::vector<RoutingTable::ConstIterator> RoutingTable::ClosestFromTarget(const NodeId& target,
+                                                                      size_t count) const {
+  return ClosestInSortedRange(nodes_.cbegin(), nodes_.cend(), target, count, NodeIdOf);
 }
 
-std::pair<bool, std::vector<NodeInfo>::iterator> RoutingTable::Find(
-    const NodeId& node_id, std::unique_lock<std::mutex>& lock) {
+std::pair<bool, std::vector<NodeInfo>::iterator> RoutingTable::Find(const NodeId& node_id,
+                                                                    UniqueLock& lock) {
   assert(lock.owns_lock());
   static_cast<void>(lock);
-  auto itr(std::find_if(nodes_.begin(), nodes_.end(), [&node_id](const NodeInfo & node_info) {
-    return node_info.node_id == node_id;
+  auto itr(std::lower_bound(nodes_.begin(), nodes_.end(), node_id,
+                            [](const NodeInfo & node_info, const NodeId & id) {
+    return node_info.node_id < id;
   }));
+  if (itr != nodes_.end() && itr->node_id != node_id)
+    itr = nodes_.end();
   return std::make_pair(itr != nodes_.end(), itr);
 }
 
-std::pair<bool, std::vector<NodeInfo>::const_iterator> RoutingTable::Find(
-    const NodeId& node_id, std::unique_lock<std::mutex>& lock) const {
+void RoutingTable::InsertNode(const NodeInfo& node, UniqueLock& lock) {
   assert(lock.owns_lock());
   static_cast<void>(lock);
-  auto itr(std::find_if(nodes_.begin(), nodes_.end(), [&node_id](const NodeInfo & node_info) {
-    return node_info.node_id == node_id;
-  }));
-  return std::make_pair(itr != nodes_.end(), itr);
+  nodes_.insert(std::upper_bound(nodes_.begin(), nodes_.end(), node, NodeIdLess), node);
+  ++bucket_counts_[node.bucket];
+  public_key_index_.insert(std::make_pair(PublicKeyFingerprint(node.public_key), node.node_id));
+}
+
+void RoutingTable::EraseNode(ConstIterator itr, UniqueLock& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  assert(bucket_counts_[itr->bucket] != 0);
+  --bucket_counts_[itr->bucket];
+  auto indexed(public_key_index_.equal_range(PublicKeyFingerprint(itr->public_key)));
+  for (auto entry(indexed.first); entry != indexed.second; ++entry) {
+    if (entry->second == itr->node_id) {
+      public_key_index_.erase(entry);
+      break;
+    }
+  }
+  nodes_.erase(itr);
+}
+
+std::pair<RoutingTable::ConstIterator, RoutingTable::ConstIterator> RoutingTable::BucketRange(
+    int32_t bucket) const {
+  return RangeFirstDifferingAt(nodes_.cbegin(), nodes_.cend(), kNodeId_, kBucketCount - 1 - bucket,
+                               NodeIdOf);
 }
 
 void RoutingTable::UpdateNetworkStatus(uint16_t size) const {
@@ -810,9 +787,22 @@ void RoutingTable::UpdateNetworkStatus(uint16_t size) const {
   LOG(kVerbose) << DebugId(kNodeId_) << " Updating network status !!! " << (size * 100) / kMaxSize_;
 }
 
-size_t RoutingTable::size() const {
-  std::lock_guard<std::mutex> lock(mutex_);
-  return nodes_.size();
+size_t RoutingTable::size() const { return Snapshot()->size(); }
+
+std::shared_ptr<const RoutingTableSnapshot> RoutingTable::Snapshot() const {
+  return std::atomic_load(&snapshot_);
+}
+
+RouteDecision RoutingTable::Route(const NodeId& destination_id, bool ignore_exact_match) const {
+  return RoutingTableSnapshot::Route(Snapshot(), destination_id, ignore_exact_match);
+}
+
+void RoutingTable::PublishSnapshot(UniqueLock& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  std::shared_ptr<const RoutingTableSnapshot> snapshot(std::make_shared<RoutingTableSnapshot>(
+      kNodeId_, ++snapshot_version_, nodes_, group_matrix_));
+  std::atomic_store(&snapshot_, snapshot);
 }
 
 void RoutingTable::IpcSendGroupMatrix() const {
@@ -820,9 +810,9 @@ void RoutingTable::IpcSendGroupMatrix() const {
     network_viewer::MatrixRecord matrix_record(kNodeId_);
     std::vector<NodeInfo> matrix, close;
     {
-      std::lock_guard<std::mutex> lock(mutex_);
-      matrix = group_matrix_.GetUniqueNodes();
-      close = group_matrix_.GetConnectedPeers();
+      auto snapshot(Snapshot());
+      matrix = snapshot->group_matrix().GetUniqueNodes();
+      close = snapshot->group_matrix().GetConnectedPeers();
     }
     std::string printout("\tMatrix sent by: " + DebugId(kNodeId_) + "\n");
     for (const auto& matrix_element : matrix) {
@@ -830,10 +820,7 @@ void RoutingTable::IpcSendGroupMatrix() const {
       printout += "\t\t" + DebugId(matrix_element.node_id) + " - kMatrix\n";
     }
 
-    std::sort(std::begin(close), std::end(close),
-              [this](const NodeInfo & lhs, const NodeInfo & rhs) {
-      return NodeId::CloserToTarget(lhs.node_id, rhs.node_id, kNodeId_);
-    });
+    SortByDistance(std::begin(close), std::end(close), kNodeId_);
 
     size_t index(0);
     size_t limit(std::min(static_cast<size_t>(Parameters::group_size), close.size()));
@@ -851,30 +838,16 @@ void RoutingTable::IpcSendGroupMatrix() const {
   }
 }
 
-std::string RoutingTable::PrintRoutingTable() {
-  std::vector<NodeInfo> rt;
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::sort(nodes_.begin(), nodes_.end(), [&](const NodeInfo & lhs, const NodeInfo & rhs) {
-      return NodeId::CloserToTarget(lhs.node_id, rhs.node_id, kNodeId_);
-    });
-    rt = nodes_;
-  }
-  std::string s = "\n\n[" + DebugId(kNodeId_) +
-                  "] This node's own routing table and peer connections:\n" +
-                  "Routing table size: " + std::to_string(nodes_.size()) + "\n";
-  for (const auto& node : rt) {
-    s += std::string("\tPeer ") + "[" + DebugId(node.node_id) + "]" + "-->";
-    s += DebugId(node.connection_id) + " && xored ";
-    s += DebugId(kNodeId_ ^ node.node_id) + " bucket ";
-    s += std::to_string(node.bucket) + "\n";
-  }
-  s += "\n\n";
-  return s;
+std::string RoutingTable::PrintRoutingTable() const {
+  std::ostringstream stream;
+  stream << *Snapshot();
+  return stream.str();
 }
 
-void RoutingTable::PrintGroupMatrix() {
-  group_matrix_.PrintGroupMatrix();
+std::string RoutingTable::PrintGroupMatrix() const {
+  std::ostringstream stream;
+  stream << Snapshot()->group_matrix();
+  return stream.str();
 }
 
 }  // namespace routing
@@ -19,16 +19,19 @@
 #ifndef MAIDSAFE_ROUTING_ROUTING_TABLE_H_
 #define MAIDSAFE_ROUTING_ROUTING_TABLE_H_
 
+#include <array>
 #include <cstdint>
 #include <memory>
-#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "boost/asio/ip/udp.hpp"
 #include "boost/filesystem/path.hpp"
 #include "boost/interprocess/ipc/message_queue.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/shared_mutex.hpp"
 
 #include "maidsafe/common/node_id.h"
 #include "maidsafe/common/rsa.h"
@@ -39,6 +42,8 @@
 #include "maidsafe/routing/group_matrix.h"
 #include "maidsafe/routing/network_statistics.h"
 #include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing_table_snapshot.h"
+#include "maidsafe/routing/uint512.h"
 
 namespace maidsafe {
 
@@ -55,6 +60,9 @@ class RoutingTableTest_BEH_CheckMockSendGroupChangeRpcs_Test;
 class RoutingTableTest_BEH_GroupUpdateFromConnectedPeer_Test;
 class NetworkStatisticsTest_BEH_IsIdInGroupRange_Test;
 class RoutingTableTest_FUNC_IsNodeIdInGroupRange_Test;
+class RoutingTableTest_BEH_ClosestLookupLeavesTableUnchanged_Test;
+class RoutingTableTest_BEH_SetBucketIndex_Test;
+class RoutingTableTest_FUNC_BucketCountsFollowChanges_Test;
 }
 
 namespace protobuf {
@@ -79,7 +87,18 @@ class RoutingTable {
                           MatrixChangedFunctor matrix_change_functor);
   bool AddNode(const NodeInfo& peer,
                const std::vector<NodeInfo>& matrix_update = std::vector<NodeInfo>());
+  // Adds as many of 'peers' as the table accepts under a single lock, returning those added.
+  // 'matrix_updates', if not empty, holds the matrix update for each of 'peers', as AddNode's
+  // 'matrix_update'.  The close nodes, matrix change and functors are worked out once for the whole
+  // batch rather than once per peer.  A peer evicted by a later member of the batch isn't returned.
+  std::vector<NodeInfo> AddNodes(
+      std::vector<NodeInfo> peers,
+      const std::vector<std::vector<NodeInfo>>& matrix_updates =
+          std::vector<std::vector<NodeInfo>>());
   bool CheckNode(const NodeInfo& peer);
+  // Returns those of 'node_ids' which CheckNode would currently accept, checking them all under a
+  // single lock.
+  std::vector<NodeId> CheckNodes(const std::vector<NodeId>& node_ids);
   NodeInfo DropNode(const NodeId& node_to_drop, bool routing_only);
   bool ClosestToId(const NodeId& target_id);
 
@@ -110,6 +129,11 @@ class RoutingTable {
                                     bool ignore_exact_match = false);
   // Returns max NodeId if routing table size is less than requested node_number
   NodeInfo GetNthClosestNode(const NodeId& target_id, uint16_t node_number);
+  // Equivalent to GetNthClosestNode(kNodeId(), closest_nodes_size).node_id, but constant time.
+  NodeId FurthestCloseNode() const;
+  // Equivalent to GetNthClosestNode(kNodeId(), 2 * closest_nodes_size).node_id, but constant time.
+  // Clients are accepted if they are closer to this node than this.
+  NodeId FurthestClientCloseNode() const;
   std::vector<NodeId> GetClosestNodes(const NodeId& target_id, uint16_t number_to_get);
   std::vector<NodeInfo> GetClosestMatrixNodes(const NodeId& target_id, uint16_t number_to_get);
   std::vector<NodeId> GetGroup(const NodeId& target_id);
@@ -122,6 +146,15 @@ class RoutingTable {
   asymm::PublicKey kPublicKey() const { return kKeys_.public_key; }
   NodeId kConnectionId() const { return kConnectionId_; }
   bool client_mode() const { return kClientMode_; }
+  // Returns the most recently published view of the table without blocking.  Callers making several
+  // related decisions (e.g. while routing one message) should fetch a snapshot once and query it.
+  std::shared_ptr<const RoutingTableSnapshot> Snapshot() const;
+  // Looks up a message's destination in the current snapshot; see RouteDecision.
+  RouteDecision Route(const NodeId& destination_id, bool ignore_exact_match) const;
+  // Diagnostic dumps of the current table (closest node first) and group matrix, built on demand
+  // from Snapshot().  Hot paths stream the snapshot or matrix straight into LOG instead.
+  std::string PrintRoutingTable() const;
+  std::string PrintGroupMatrix() const;
 
   friend class test::GenericNode;
   friend class GroupChangeHandler;
@@ -132,58 +165,77 @@ class RoutingTable {
   friend class test::RoutingTableTest_BEH_GroupUpdateFromConnectedPeer_Test;
   friend class test::NetworkStatisticsTest_BEH_IsIdInGroupRange_Test;
   friend class test::RoutingTableTest_FUNC_IsNodeIdInGroupRange_Test;
+  friend class test::RoutingTableTest_BEH_ClosestLookupLeavesTableUnchanged_Test;
+  friend class test::RoutingTableTest_BEH_SetBucketIndex_Test;
+  friend class test::RoutingTableTest_FUNC_BucketCountsFollowChanges_Test;
 
  private:
+  typedef boost::shared_lock<boost::shared_mutex> SharedLock;
+  typedef boost::unique_lock<boost::shared_mutex> UniqueLock;
+  typedef std::vector<NodeInfo>::const_iterator ConstIterator;
+
   RoutingTable(const RoutingTable&);
   RoutingTable& operator=(const RoutingTable&);
   bool AddOrCheckNode(NodeInfo node, bool remove,
                       const std::vector<NodeInfo>& matrix_update = std::vector<NodeInfo>());
   void SetBucketIndex(NodeInfo& node_info) const;
-  bool CheckPublicKeyIsUnique(const NodeInfo& node, std::unique_lock<std::mutex>& lock) const;
+  void SetBucketIndices(std::vector<NodeInfo>& nodes) const;
+  bool CheckPublicKeyIsUnique(const NodeInfo& node, UniqueLock& lock) const;
   NodeInfo ResolveConnectionDuplication(const NodeInfo& new_duplicate_node, bool local_endpoint,
                                         NodeInfo& existing_node);
   std::shared_ptr<MatrixChange> UpdateCloseNodeChange(
-      std::unique_lock<std::mutex>& lock, const NodeInfo& peer,
-      std::vector<NodeInfo>& new_connected_nodes,
+      UniqueLock& lock, const NodeInfo& peer, std::vector<NodeInfo>& new_connected_nodes,
       const std::vector<NodeInfo>& matrix_update = std::vector<NodeInfo>());
   bool MakeSpaceForNodeToBeAdded(const NodeInfo& node, bool remove, NodeInfo& removed_node,
-                                 std::unique_lock<std::mutex>& lock);
-  uint16_t PartialSortFromTarget(const NodeId& target, uint16_t number,
-                                 std::unique_lock<std::mutex>& lock);
-  void NthElementSortFromTarget(const NodeId& target, uint16_t nth_element,
-                                std::unique_lock<std::mutex>& lock);
-  NodeId FurthestCloseNode();
-  std::vector<NodeInfo> GetClosestNodeInfo(const NodeId& target_id, uint16_t number_to_get,
-                                           bool ignore_exact_match = false);
-  std::pair<bool, std::vector<NodeInfo>::iterator> Find(const NodeId& node_id,
-                                                        std::unique_lock<std::mutex>& lock);
-  std::pair<bool, std::vector<NodeInfo>::const_iterator> Find(
-      const NodeId& node_id, std::unique_lock<std::mutex>& lock) const;
+                                 UniqueLock& lock);
+  // Returns up to 'count' entries of nodes_ closest to 'target', closest first, without reordering
+  // nodes_.  Caller must hold mutex_ (shared or exclusive).
+  std::vector<ConstIterator> ClosestFromTarget(const NodeId& target, size_t count) const;
+  std::pair<bool, std::vector<NodeInfo>::iterator> Find(const NodeId& node_id, UniqueLock& lock);
+  void InsertNode(const NodeInfo& node, UniqueLock& lock);
+  void EraseNode(ConstIterator itr, UniqueLock& lock);
+  // Returns the entries of nodes_ in 'bucket'.  Caller must hold mutex_ (shared or exclusive).
+  std::pair<ConstIterator, ConstIterator> BucketRange(int32_t bucket) const;
+  // Must be called by every writer, before releasing mutex_, once it has modified nodes_ or
+  // group_matrix_.
+  void PublishSnapshot(UniqueLock& lock);
   void UpdateNetworkStatus(uint16_t size) const;
   void UpdateConnectedPeersMatrix(const std::vector<NodeInfo>& new_connected_peers,
                                   const std::vector<NodeInfo>& old_connected_peers);
+  // Fires the functors for a change to the close nodes made by AddNode, AddNodes or DropNode.  Must
+  // be called without mutex_ held.
+  void NotifyCloseNodeChange(const std::vector<NodeInfo>& new_connected_close_nodes,
+                             const std::vector<NodeInfo>& old_connected_close_nodes,
+                             std::shared_ptr<MatrixChange> matrix_change,
+                             std::vector<NodeId>& unique_nodes);
 
   void IpcSendGroupMatrix() const;
-  std::string PrintRoutingTable();
-  void PrintGroupMatrix();
 
   const bool kClientMode_;
   const NodeId kNodeId_;
+  const Uint512 kNodeIdValue_;
   const NodeId kConnectionId_;
   const asymm::Keys kKeys_;
   const uint16_t kMaxSize_;
   const uint16_t kThresholdSize_;
-  mutable std::mutex mutex_;
-  NodeId furthest_closest_node_id_;
+  mutable boost::shared_mutex mutex_;
   std::function<void(const NodeInfo&, bool)> remove_node_functor_;
   NetworkStatusFunctor network_status_functor_;
   RemoveFurthestUnnecessaryNode remove_furthest_node_;
   ConnectedGroupChangeFunctor connected_group_change_functor_;
   MatrixChangedFunctor matrix_change_functor_;
+  // Kept sorted by node id; see sorted_id_lookup.h.  Each bucket is a contiguous range of it.
   std::vector<NodeInfo> nodes_;
+  // Number of entries of nodes_ in each bucket, kept in step by InsertNode and EraseNode
+  std::array<uint16_t, NodeId::kSize * 8> bucket_counts_;
+  // Public key fingerprint to node id for each entry of nodes_, kept in step by InsertNode and
+  // EraseNode so that CheckPublicKeyIsUnique only compares keys whose fingerprints match.
+  std::unordered_multimap<size_t, NodeId> public_key_index_;
   GroupMatrix group_matrix_;
   std::unique_ptr<boost::interprocess::message_queue> ipc_message_queue_;
   NetworkStatistics& network_statistics_;
+  uint64_t snapshot_version_;
+  std::shared_ptr<const RoutingTableSnapshot> snapshot_;
 };
 
 }  // namespace routing
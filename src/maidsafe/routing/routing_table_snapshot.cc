@@ -0,0 +1,375 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/routing_table_snapshot.h"
+
+#include <algorithm>
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/sorted_id_lookup.h"
+#include "maidsafe/routing/trace.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace {
+
+const NodeId& NodeIdOf(const NodeInfo& node_info) { return node_info.node_id; }
+
+NodeIdIndex IndexByNodeId(const std::vector<NodeInfo>& nodes) {
+  NodeIdIndex node_index(nodes.size());
+  for (size_t i(0); i != nodes.size(); ++i)
+    node_index.insert(std::make_pair(nodes[i].node_id, i));
+  return node_index;
+}
+
+// Converts a message's route history once, so that each candidate hop is then checked against it
+// in constant time.
+NodeIdSet MakeNodeIdSet(const std::vector<std::string>& raw_ids) {
+  NodeIdSet node_ids(raw_ids.size());
+  for (const auto& raw_id : raw_ids) {
+    try {
+      node_ids.insert(NodeId(raw_id));
+    }
+    catch (const std::exception& ex) {
+      LOG(kError) << "Got invalid string for Node ID. Exception: " << ex.what();
+    }
+  }
+  return node_ids;
+}
+
+NodeInfo FirstNotExcluded(const std::vector<NodeInfo>& nodes, const NodeIdSet& exclude) {
+  for (const auto& node_info : nodes) {
+    if (exclude.count(node_info.node_id) == 0)
+      return node_info;
+  }
+  return NodeInfo();
+}
+
+}  // unnamed namespace
+
+RoutingTableSnapshot::RoutingTableSnapshot(const NodeId& node_id, uint64_t version,
+                                           const std::vector<NodeInfo>& nodes,
+                                           const GroupMatrix& group_matrix)
+    : kNodeId_(node_id),
+      kVersion_(version),
+      nodes_(nodes),
+      node_index_(IndexByNodeId(nodes_)),
+      group_matrix_(group_matrix),
+      furthest_close_node_id_(NthClosestToSelf(Parameters::closest_nodes_size)),
+      furthest_client_close_node_id_(NthClosestToSelf(2 * Parameters::closest_nodes_size)),
+      furthest_group_node_id_(NthClosestToSelf(Parameters::group_size)) {
+  assert(std::is_sorted(nodes_.begin(), nodes_.end(),
+                        [](const NodeInfo & lhs, const NodeInfo & rhs) {
+    return lhs.node_id < rhs.node_id;
+  }));
+}
+
+bool RoutingTableSnapshot::Contains(const NodeId& node_id) const { return Find(node_id).first; }
+
+bool RoutingTableSnapshot::IsConnected(const NodeId& node_id) const {
+  return Contains(node_id) || group_matrix_.Contains(node_id);
+}
+
+bool RoutingTableSnapshot::GetNodeInfo(const NodeId& node_id, NodeInfo& node_info) const {
+  auto found(Find(node_id));
+  if (found.first)
+    node_info = *found.second;
+  return found.first;
+}
+
+bool RoutingTableSnapshot::IsThisNodeInRange(const NodeId& target_id, uint16_t range) const {
+  if (nodes_.size() < range)
+    return true;
+  if (range == Parameters::closest_nodes_size)
+    return NodeId::CloserToTarget(target_id, furthest_close_node_id_, kNodeId_);
+  if (range == Parameters::group_size)
+    return NodeId::CloserToTarget(target_id, furthest_group_node_id_, kNodeId_);
+  return NodeId::CloserToTarget(target_id, ClosestFromTarget(kNodeId_, range).back()->node_id,
+                                kNodeId_);
+}
+
+bool RoutingTableSnapshot::IsThisNodeClosestTo(const NodeId& target_id,
+                                               bool ignore_exact_match) const {
+  if (target_id.IsZero()) {
+    LOG(kError) << "Invalid target_id passed.";
+    return false;
+  }
+  NodeInfo closest_node(GetClosestNode(target_id, ignore_exact_match));
+  return (closest_node.bucket == NodeInfo::kInvalidBucket) ||
+         NodeId::CloserToTarget(kNodeId_, closest_node.node_id, target_id);
+}
+
+bool RoutingTableSnapshot::IsThisNodeClosestToIncludingMatrix(const NodeId& target_id,
+                                                              bool ignore_exact_match) const {
+  if (target_id.IsZero()) {
+    LOG(kError) << "Invalid target_id passed.";
+    return false;
+  }
+  NodeInfo closest_node(GetClosestNode(target_id, ignore_exact_match));
+
+  if (closest_node.bucket == NodeInfo::kInvalidBucket)
+    return true;  // ?
+
+  if (!NodeId::CloserToTarget(kNodeId_, closest_node.node_id, target_id))
+    return false;
+
+  NodeId connected_peer;
+  return group_matrix_.IsThisNodeGroupLeader(target_id, connected_peer);  // use connected peer?
+}
+
+bool RoutingTableSnapshot::IsThisNodeGroupLeader(const NodeId& target_id,
+                                                 NodeInfo& connected_peer) const {
+  NodeId current_closest_id(kNodeId_);
+  NodeId closest_peer_id(GetClosestNode(target_id, true).node_id);
+  if (NodeId::CloserToTarget(closest_peer_id, current_closest_id, target_id))
+    current_closest_id = closest_peer_id;
+
+  group_matrix_.GetBetterNodeForSendingMessage(target_id, true, current_closest_id);
+  if (current_closest_id != kNodeId_) {
+    auto found(Find(current_closest_id));
+    if (found.first) {
+      connected_peer = *found.second;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RoutingTableSnapshot::IsThisNodeGroupLeader(const NodeId& target_id,
+                                                 NodeInfo& connected_peer,
+                                                 const std::vector<std::string>& exclude) const {
+  const NodeIdSet excluded(MakeNodeIdSet(exclude));
+  NodeInfo current_closest;
+  current_closest.node_id = kNodeId_;
+  NodeInfo closest_peer(ClosestNotExcluded(target_id, excluded, true));
+  if (NodeId::CloserToTarget(closest_peer.node_id, current_closest.node_id, target_id))
+    current_closest = closest_peer;
+
+  group_matrix_.GetBetterNodeForSendingMessage(target_id, excluded, true, current_closest);
+  if (current_closest.node_id != kNodeId_) {
+    auto found(Find(current_closest.node_id));
+    if (found.first) {
+      connected_peer = *found.second;
+      return false;
+    }
+  }
+  for (const auto& excluded_id : excluded) {
+    if (excluded_id != target_id && NodeId::CloserToTarget(excluded_id, kNodeId_, target_id)) {
+      if (connected_peer.node_id.IsZero())
+        connected_peer = closest_peer;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RoutingTableSnapshot::ClosestToId(const NodeId& target_id) const {
+  if (target_id == kNodeId_)
+    return false;
+
+  if (nodes_.empty())  // should return false ?
+    return true;
+
+  if (nodes_.size() == 1) {
+    if (nodes_.at(0).node_id == target_id)
+      return true;
+    else
+      return NodeId::CloserToTarget(kNodeId_, nodes_.at(0).node_id, target_id);
+  }
+
+  auto closest(ClosestFromTarget(target_id, 2));
+  uint16_t index(0);
+  if (closest.at(0)->node_id == target_id)
+    index = 1;
+  if (!NodeId::CloserToTarget(kNodeId_, closest.at(index)->node_id, target_id))
+    return false;
+
+  return group_matrix_.ClosestToId(target_id);
+}
+
+GroupRangeStatus RoutingTableSnapshot::IsNodeIdInGroupRange(const NodeId& group_id,
+                                                            const NodeId& node_id) const {
+  return group_matrix_.IsNodeIdInGroupRange(group_id, node_id);
+}
+
+NodeInfo RoutingTableSnapshot::GetClosestNode(const NodeId& target_id,
+                                              bool ignore_exact_match) const {
+  auto closest(ClosestFromTarget(target_id, 2));
+  if (closest.empty())
+    return NodeInfo();
+  if (ignore_exact_match && (closest[0]->node_id == target_id))
+    return (closest.size() == 1) ? NodeInfo() : *closest[1];
+  return *closest[0];
+}
+
+NodeInfo RoutingTableSnapshot::GetClosestNode(const NodeId& target_id,
+                                              const std::vector<std::string>& exclude,
+                                              bool ignore_exact_match) const {
+  return ClosestNotExcluded(target_id, MakeNodeIdSet(exclude), ignore_exact_match);
+}
+
+NodeInfo RoutingTableSnapshot::GetNodeForSendingMessage(const NodeId& target_id,
+                                                        const std::vector<std::string>& exclude,
+                                                        bool ignore_exact_match) const {
+  return NodeForSendingMessage(
+      target_id, GetClosestNodeInfo(target_id, Parameters::closest_nodes_size, ignore_exact_match),
+      exclude, ignore_exact_match);
+}
+
+RouteDecision RoutingTableSnapshot::Route(
+    const std::shared_ptr<const RoutingTableSnapshot>& snapshot, const NodeId& destination_id,
+    bool ignore_exact_match) {
+  RouteDecision route;
+  route.snapshot = snapshot;
+  route.destination_id = destination_id;
+  route.ignore_exact_match = ignore_exact_match;
+  route.closest_nodes = snapshot->GetClosestNodeInfo(destination_id, Parameters::closest_nodes_size,
+                                                     ignore_exact_match);
+  route.destination_in_table = snapshot->Contains(destination_id);
+  route.this_node_in_group_range =
+      snapshot->IsThisNodeInRange(destination_id, Parameters::group_size);
+  route.this_node_in_close_range =
+      snapshot->IsThisNodeInRange(destination_id, Parameters::closest_nodes_size);
+  if (destination_id.IsZero()) {
+    LOG(kError) << "Invalid target_id passed.";
+  } else {
+    route.this_node_closest =
+        route.closest_nodes.empty() ||
+        NodeId::CloserToTarget(snapshot->kNodeId_, route.closest_nodes.front().node_id,
+                               destination_id);
+  }
+  return route;
+}
+
+bool RoutingTableSnapshot::IsThisNodeClosestToIncludingMatrix(const RouteDecision& route) const {
+  if (!route.this_node_closest)
+    return false;
+  if (route.closest_nodes.empty())
+    return true;
+  NodeId connected_peer;
+  return group_matrix_.IsThisNodeGroupLeader(route.destination_id, connected_peer);
+}
+
+NodeInfo RoutingTableSnapshot::GetNodeForSendingMessage(
+    const RouteDecision& route, const std::vector<std::string>& exclude) const {
+  return NodeForSendingMessage(route.destination_id, route.closest_nodes, exclude,
+                               route.ignore_exact_match);
+}
+
+NodeInfo RoutingTableSnapshot::NodeForSendingMessage(const NodeId& target_id,
+                                                     const std::vector<NodeInfo>& closest_nodes,
+                                                     const std::vector<std::string>& exclude,
+                                                     bool ignore_exact_match) const {
+  const NodeIdSet excluded(MakeNodeIdSet(exclude));
+  NodeInfo current_peer(FirstNotExcluded(closest_nodes, excluded));
+  if (current_peer.node_id != target_id) {
+    group_matrix_.GetBetterNodeForSendingMessage(target_id, excluded, ignore_exact_match,
+                                                 current_peer);
+  }
+  if (TraceEnabled(kVerbose)) {
+    std::string excluded_ids;
+    for (const auto& excluded_id : exclude) {
+      excluded_ids.append("\t");
+      excluded_ids.append(HexSubstr(excluded_id));
+    }
+    LOG(kVerbose) << "[" << DebugId(kNodeId_) << "] - best node to send to is "
+                  << DebugId(current_peer.node_id) << " (Excluded: " << excluded_ids << ")";
+  }
+  return current_peer;
+}
+
+NodeInfo RoutingTableSnapshot::GetNthClosestNode(const NodeId& target_id,
+                                                 uint16_t node_number) const {
+  assert((node_number > 0) && "Node number starts with position 1");
+  if (nodes_.size() < node_number) {
+    NodeInfo node_info;
+    node_info.node_id = (NodeId(NodeId::kMaxId) ^ kNodeId_);
+    return node_info;
+  }
+  return *ClosestFromTarget(target_id, node_number).back();
+}
+
+NodeId RoutingTableSnapshot::NthClosestToSelf(uint16_t node_number) const {
+  if (nodes_.size() < node_number)
+    return NodeId(NodeId::kMaxId) ^ kNodeId_;
+  return ClosestFromTarget(kNodeId_, node_number).back()->node_id;
+}
+
+std::vector<NodeId> RoutingTableSnapshot::GetClosestNodes(const NodeId& target_id,
+                                                          uint16_t number_to_get) const {
+  std::vector<NodeId> close_nodes;
+  for (const auto& close_node : ClosestFromTarget(target_id, number_to_get))
+    close_nodes.push_back(close_node->node_id);
+  return close_nodes;
+}
+
+std::vector<NodeInfo> RoutingTableSnapshot::GetClosestNodeInfo(const NodeId& target_id,
+                                                               uint16_t number_to_get,
+                                                               bool ignore_exact_match) const {
+  auto closest(ClosestFromTarget(target_id, number_to_get + 1));
+  auto itr(closest.begin());
+  if (ignore_exact_match && itr != closest.end() && ((*itr)->node_id == target_id))
+    ++itr;
+
+  std::vector<NodeInfo> closest_nodes;
+  for (; itr != closest.end() && closest_nodes.size() < number_to_get; ++itr)
+    closest_nodes.push_back(**itr);
+  return closest_nodes;
+}
+
+std::vector<RoutingTableSnapshot::ConstIterator> RoutingTableSnapshot::ClosestFromTarget(
+    const NodeId& target, size_t count) const {
+  return ClosestInSortedRange(nodes_.cbegin(), nodes_.cend(), target, count, NodeIdOf);
+}
+
+NodeInfo RoutingTableSnapshot::ClosestNotExcluded(const NodeId& target_id,
+                                                  const NodeIdSet& exclude,
+                                                  bool ignore_exact_match) const {
+  return FirstNotExcluded(
+      GetClosestNodeInfo(target_id, Parameters::closest_nodes_size, ignore_exact_match), exclude);
+}
+
+std::pair<bool, RoutingTableSnapshot::ConstIterator> RoutingTableSnapshot::Find(
+    const NodeId& node_id) const {
+  auto found(node_index_.find(node_id));
+  if (found == node_index_.end())
+    return std::make_pair(false, nodes_.cend());
+  return std::make_pair(true, nodes_.cbegin() + found->second);
+}
+
+std::ostream& operator<<(std::ostream& stream, const RoutingTableSnapshot& snapshot) {
+  auto closest(snapshot.ClosestFromTarget(snapshot.kNodeId_, snapshot.nodes_.size()));
+  stream << "\n\n[" << DebugId(snapshot.kNodeId_)
+         << "] This node's own routing table and peer connections:\n"
+         << "Routing table size: " << closest.size() << "\n";
+  for (const auto& node : closest) {
+    stream << "\tPeer [" << DebugId(node->node_id) << "]-->" << DebugId(node->connection_id)
+           << " && xored " << DebugId(snapshot.kNodeId_ ^ node->node_id) << " bucket "
+           << node->bucket << "\n";
+  }
+  return stream << "\n\n";
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,153 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_ROUTING_TABLE_SNAPSHOT_H_
+#define MAIDSAFE_ROUTING_ROUTING_TABLE_SNAPSHOT_H_
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+
+#include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/group_matrix.h"
+#include "maidsafe/routing/node_id_hash.h"
+#include "maidsafe/routing/node_info.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+class RoutingTableSnapshot;
+
+// What one snapshot of the routing table says about a message's destination, worked out by
+// RoutingTableSnapshot::Route with a single search of the table.  Each step of handling and
+// forwarding the message reads it instead of searching the table again.
+struct RouteDecision {
+  RouteDecision()
+      : snapshot(),
+        destination_id(),
+        ignore_exact_match(false),
+        closest_nodes(),
+        destination_in_table(false),
+        this_node_in_group_range(false),
+        this_node_in_close_range(false),
+        this_node_closest(false) {}
+  std::shared_ptr<const RoutingTableSnapshot> snapshot;
+  NodeId destination_id;
+  bool ignore_exact_match;
+  // Up to closest_nodes_size nodes closest to the destination, closest first, leaving out the
+  // destination itself if ignore_exact_match is set.
+  std::vector<NodeInfo> closest_nodes;
+  bool destination_in_table;      // As Contains(destination_id)
+  bool this_node_in_group_range;  // As IsThisNodeInRange(destination_id, group_size)
+  bool this_node_in_close_range;  // As IsThisNodeInRange(destination_id, closest_nodes_size)
+  bool this_node_closest;         // As IsThisNodeClosestTo(destination_id, ignore_exact_match)
+};
+
+// Immutable view of a RoutingTable's nodes and group matrix.  A new snapshot is published by every
+// change to the table; readers holding one never block writers and see a consistent table for as
+// long as they keep it.  The query functions mirror the RoutingTable ones of the same name.
+class RoutingTableSnapshot {
+ public:
+  RoutingTableSnapshot(const NodeId& node_id, uint64_t version, const std::vector<NodeInfo>& nodes,
+                       const GroupMatrix& group_matrix);
+
+  bool Contains(const NodeId& node_id) const;
+  bool IsConnected(const NodeId& node_id) const;
+  bool GetNodeInfo(const NodeId& node_id, NodeInfo& node_info) const;
+  bool IsThisNodeInRange(const NodeId& target_id, uint16_t range) const;
+  bool IsThisNodeClosestTo(const NodeId& target_id, bool ignore_exact_match = false) const;
+  bool IsThisNodeClosestToIncludingMatrix(const NodeId& target_id,
+                                          bool ignore_exact_match = false) const;
+  bool IsThisNodeGroupLeader(const NodeId& target_id, NodeInfo& connected_peer) const;
+  bool IsThisNodeGroupLeader(const NodeId& target_id, NodeInfo& connected_peer,
+                             const std::vector<std::string>& exclude) const;
+  bool ClosestToId(const NodeId& target_id) const;
+  GroupRangeStatus IsNodeIdInGroupRange(const NodeId& group_id, const NodeId& node_id) const;
+  // Returns default-constructed NodeId if routing table size is zero
+  NodeInfo GetClosestNode(const NodeId& target_id, bool ignore_exact_match = false) const;
+  NodeInfo GetClosestNode(const NodeId& target_id, const std::vector<std::string>& exclude,
+                          bool ignore_exact_match = false) const;
+  NodeInfo GetNodeForSendingMessage(const NodeId& target_id,
+                                    const std::vector<std::string>& exclude,
+                                    bool ignore_exact_match = false) const;
+  // Returns max NodeId if routing table size is less than requested node_number
+  NodeInfo GetNthClosestNode(const NodeId& target_id, uint16_t node_number) const;
+  std::vector<NodeId> GetClosestNodes(const NodeId& target_id, uint16_t number_to_get) const;
+  std::vector<NodeInfo> GetClosestNodeInfo(const NodeId& target_id, uint16_t number_to_get,
+                                           bool ignore_exact_match = false) const;
+
+  // Fills in a RouteDecision for 'destination_id' from 'snapshot'.
+  static RouteDecision Route(const std::shared_ptr<const RoutingTableSnapshot>& snapshot,
+                             const NodeId& destination_id, bool ignore_exact_match);
+  // As the functions of the same name called with the route's destination_id and
+  // ignore_exact_match, but picking from its closest_nodes rather than searching the table again.
+  bool IsThisNodeClosestToIncludingMatrix(const RouteDecision& route) const;
+  NodeInfo GetNodeForSendingMessage(const RouteDecision& route,
+                                    const std::vector<std::string>& exclude) const;
+
+  size_t size() const { return nodes_.size(); }
+  uint64_t version() const { return kVersion_; }
+  // The boundaries of this node's close group (closest_nodes_size nodes) and of the wider range
+  // within which clients are accepted (2 * closest_nodes_size nodes), fixed when the snapshot is
+  // taken.  Each is the furthest node within the range, or max NodeId ^ this node's id if the table
+  // holds fewer nodes, as given by GetNthClosestNode.
+  const NodeId& furthest_close_node_id() const { return furthest_close_node_id_; }
+  const NodeId& furthest_client_close_node_id() const { return furthest_client_close_node_id_; }
+  // Sorted by node id
+  const std::vector<NodeInfo>& nodes() const { return nodes_; }
+  const GroupMatrix& group_matrix() const { return group_matrix_; }
+
+  // Writes the table, closest to this node first, for diagnostics.  LOG does the ordering and
+  // formatting even for a level the filter drops; only behind TRACE is it skipped.
+  friend std::ostream& operator<<(std::ostream& stream, const RoutingTableSnapshot& snapshot);
+
+ private:
+  typedef std::vector<NodeInfo>::const_iterator ConstIterator;
+
+  RoutingTableSnapshot(const RoutingTableSnapshot&);
+  RoutingTableSnapshot& operator=(const RoutingTableSnapshot&);
+  std::vector<ConstIterator> ClosestFromTarget(const NodeId& target, size_t count) const;
+  std::pair<bool, ConstIterator> Find(const NodeId& node_id) const;
+  NodeInfo ClosestNotExcluded(const NodeId& target_id, const NodeIdSet& exclude,
+                              bool ignore_exact_match) const;
+  NodeInfo NodeForSendingMessage(const NodeId& target_id, const std::vector<NodeInfo>& closest_nodes,
+                                 const std::vector<std::string>& exclude,
+                                 bool ignore_exact_match) const;
+  NodeId NthClosestToSelf(uint16_t node_number) const;
+
+  const NodeId kNodeId_;
+  const uint64_t kVersion_;
+  const std::vector<NodeInfo> nodes_;
+  const NodeIdIndex node_index_;
+  const GroupMatrix group_matrix_;
+  const NodeId furthest_close_node_id_;
+  const NodeId furthest_client_close_node_id_;
+  const NodeId furthest_group_node_id_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_ROUTING_TABLE_SNAPSHOT_H_
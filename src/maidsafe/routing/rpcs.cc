@@ -33,6 +33,29 @@ namespace routing {
 
 namespace rpcs {
 
+namespace {
+
+protobuf::Message ClosestNodesUpdateMessage(
+    const NodeId& node_id, const NodeId& my_node_id,
+    const protobuf::ClosestNodesUpdate& closest_nodes_update) {
+  protobuf::Message message;
+  message.set_destination_id(node_id.string());
+  message.set_source_id(my_node_id.string());
+  message.set_routing_message(true);
+  message.add_data(closest_nodes_update.SerializeAsString());
+  message.set_direct(true);
+  message.set_replication(1);
+  message.set_type(static_cast<int32_t>(MessageType::kClosestNodesUpdate));
+  message.set_request(true);
+  message.set_client_node(false);
+  message.set_hops_to_live(Parameters::hops_to_live);
+  message.set_id(RandomUint32() % 10000);
+  assert(message.IsInitialized() && "Unintialised message");
+  return message;
+}
+
+}  // unnamed namespace
+
 // This is maybe not required and might be removed
 protobuf::Message Ping(const NodeId& node_id, const std::string& identity) {
   assert(!node_id.IsZero() && "Invalid node_id");
@@ -228,11 +251,11 @@ protobuf::Message ConnectSuccessAcknowledgement(const NodeId& node_id, const Nod
 }
 
 protobuf::Message ClosestNodesUpdate(const NodeId& node_id, const NodeId& my_node_id,
-                                     const std::vector<NodeInfo>& closest_nodes) {
+                                     const std::vector<NodeInfo>& closest_nodes,
+                                     uint32_t sequence) {
   assert(!node_id.IsZero() && "Invalid node_id");
   assert(!my_node_id.IsZero() && "Invalid my node_id");
   // assert(!close_nodes.empty() && "Empty close nodes");
-  protobuf::Message message;
   protobuf::ClosestNodesUpdate closest_nodes_update;
   closest_nodes_update.set_node(my_node_id.string());
   for (const auto& i : closest_nodes) {
@@ -241,19 +264,39 @@ protobuf::Message ClosestNodesUpdate(const NodeId& node_id, const NodeId& my_nod
     basic_node_info->set_node_id(i.node_id.string());
     basic_node_info->set_rank(i.rank);
   }
-  message.set_destination_id(node_id.string());
-  message.set_source_id(my_node_id.string());
-  message.set_routing_message(true);
-  message.add_data(closest_nodes_update.SerializeAsString());
-  message.set_direct(true);
-  message.set_replication(1);
-  message.set_type(static_cast<int32_t>(MessageType::kClosestNodesUpdate));
-  message.set_request(true);
-  message.set_client_node(false);
-  message.set_hops_to_live(Parameters::hops_to_live);
-  message.set_id(RandomUint32() % 10000);
-  assert(message.IsInitialized() && "Unintialised message");
-  return message;
+  closest_nodes_update.set_sequence(sequence);
+  return ClosestNodesUpdateMessage(node_id, my_node_id, closest_nodes_update);
+}
+
+protobuf::Message ClosestNodesUpdateDelta(const NodeId& node_id, const NodeId& my_node_id,
+                                          const std::vector<NodeInfo>& added_nodes,
+                                          const std::vector<NodeId>& removed_nodes,
+                                          uint32_t sequence) {
+  assert(!node_id.IsZero() && "Invalid node_id");
+  assert(!my_node_id.IsZero() && "Invalid my node_id");
+  protobuf::ClosestNodesUpdate closest_nodes_update;
+  closest_nodes_update.set_node(my_node_id.string());
+  for (const auto& i : added_nodes) {
+    protobuf::BasicNodeInfo* basic_node_info;
+    basic_node_info = closest_nodes_update.add_nodes_info();
+    basic_node_info->set_node_id(i.node_id.string());
+    basic_node_info->set_rank(i.rank);
+  }
+  for (const auto& i : removed_nodes)
+    closest_nodes_update.add_removed_nodes(i.string());
+  closest_nodes_update.set_sequence(sequence);
+  closest_nodes_update.set_delta(true);
+  return ClosestNodesUpdateMessage(node_id, my_node_id, closest_nodes_update);
+}
+
+protobuf::Message ClosestNodesUpdateResendRequest(const NodeId& node_id,
+                                                  const NodeId& my_node_id) {
+  assert(!node_id.IsZero() && "Invalid node_id");
+  assert(!my_node_id.IsZero() && "Invalid my node_id");
+  protobuf::ClosestNodesUpdate closest_nodes_update;
+  closest_nodes_update.set_node(my_node_id.string());
+  closest_nodes_update.set_resend_requested(true);
+  return ClosestNodesUpdateMessage(node_id, my_node_id, closest_nodes_update);
 }
 
 protobuf::Message GetGroup(const NodeId& node_id, const NodeId& my_node_id) {
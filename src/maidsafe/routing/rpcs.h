@@ -71,7 +71,18 @@ protobuf::Message ConnectSuccessAcknowledgement(const NodeId& node_id, const Nod
                                                 bool client_node);
 
 protobuf::Message ClosestNodesUpdate(const NodeId& node_id, const NodeId& my_node_id,
-                                     const std::vector<NodeInfo>& closest_nodes);
+                                     const std::vector<NodeInfo>& closest_nodes,
+                                     uint32_t sequence);
+
+// Holds only the changes to my_node_id's closest nodes since the update numbered sequence - 1.
+protobuf::Message ClosestNodesUpdateDelta(const NodeId& node_id, const NodeId& my_node_id,
+                                          const std::vector<NodeInfo>& added_nodes,
+                                          const std::vector<NodeId>& removed_nodes,
+                                          uint32_t sequence);
+
+// Asks node_id to resend its full list of closest nodes.
+protobuf::Message ClosestNodesUpdateResendRequest(const NodeId& node_id,
+                                                  const NodeId& my_node_id);
 
 protobuf::Message GetGroup(const NodeId& node_id, const NodeId& my_node_id);
 
@@ -151,9 +151,7 @@ void Service::Connect(protobuf::Message& message) {
   bool check_node_succeeded(false);
   if (message.client_node()) {  // Client node, check non-routing table
     LOG(kVerbose) << "Client connect request - will check non-routing table.";
-    NodeId furthest_close_node_id =
-        routing_table_.GetNthClosestNode(routing_table_.kNodeId(),
-                                         2 * Parameters::closest_nodes_size).node_id;
+    NodeId furthest_close_node_id(routing_table_.FurthestClientCloseNode());
     check_node_succeeded = client_routing_table_.CheckNode(peer_node, furthest_close_node_id);
   } else {
     LOG(kVerbose) << "Server connect request - will check routing table.";
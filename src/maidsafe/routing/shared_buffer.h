@@ -0,0 +1,63 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_SHARED_BUFFER_H_
+#define MAIDSAFE_ROUTING_SHARED_BUFFER_H_
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace maidsafe {
+
+namespace routing {
+
+// Immutable bytes held by reference count.  Copies and slices refer to the one buffer, so a
+// received message can be posted, handled and sent on any number of times without its bytes being
+// copied again.
+class SharedBuffer {
+ public:
+  SharedBuffer() : bytes_(), offset_(0), size_(0) {}
+  // Pass an rvalue to have the buffer take the bytes without copying them.
+  explicit SharedBuffer(std::string bytes)
+      : bytes_(std::make_shared<const std::string>(std::move(bytes))),
+        offset_(0),
+        size_(bytes_->size()) {}
+  // The 'size' bytes of 'buffer' starting at 'offset', sharing its bytes.
+  SharedBuffer(const SharedBuffer& buffer, size_t offset, size_t size)
+      : bytes_(buffer.bytes_), offset_(buffer.offset_ + offset), size_(size) {
+    assert(offset + size <= buffer.size_);
+  }
+
+  const char* data() const { return bytes_ ? bytes_->data() + offset_ : nullptr; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  std::string string() const { return empty() ? std::string() : std::string(data(), size_); }
+
+ private:
+  std::shared_ptr<const std::string> bytes_;
+  size_t offset_, size_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_SHARED_BUFFER_H_
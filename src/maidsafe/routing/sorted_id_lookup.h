@@ -0,0 +1,164 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_SORTED_ID_LOOKUP_H_
+#define MAIDSAFE_ROUTING_SORTED_ID_LOOKUP_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+
+// A range of elements sorted by ascending id is an implicit binary trie over the 512-bit ids: all
+// elements sharing a prefix are contiguous, and the elements of such a block having the next bit
+// set all follow those having it clear.  Walking that trie, always descending first into the half
+// which matches the target's bit, visits elements in order of XOR distance from the target.  This
+// lets callers answer k-closest queries in roughly O(k log n) without reordering (or copying) the
+// range, so concurrent readers can share it.
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace detail {
+
+const int kIdBitCount(NodeId::kSize * 8);
+
+inline bool IsBitSet(const std::string& raw_id, int bit) {
+  return (static_cast<unsigned char>(raw_id[bit / 8]) & (0x80 >> (bit % 8))) != 0;
+}
+
+// Returns the index of the most significant bit at which the ids differ, or kIdBitCount if equal.
+inline int FirstDifferingBit(const std::string& lhs, const std::string& rhs) {
+  for (int byte_index(0); byte_index != NodeId::kSize; ++byte_index) {
+    unsigned char difference(static_cast<unsigned char>(lhs[byte_index] ^ rhs[byte_index]));
+    if (difference != 0) {
+      int bit_index(0);
+      while ((difference & (0x80 >> bit_index)) == 0)
+        ++bit_index;
+      return (byte_index * 8) + bit_index;
+    }
+  }
+  return kIdBitCount;
+}
+
+// Returns the smallest id sharing 'raw_id's first 'bit' bits and having 'bit' set.
+inline NodeId BranchPivot(const std::string& raw_id, int bit) {
+  std::string pivot(raw_id);
+  int byte_index(bit / 8);
+  unsigned char mask(static_cast<unsigned char>(0x80 >> (bit % 8)));
+  pivot[byte_index] = static_cast<char>(
+      (static_cast<unsigned char>(pivot[byte_index]) & ~(mask | (mask - 1))) | mask);
+  std::fill(pivot.begin() + byte_index + 1, pivot.end(), 0);
+  return NodeId(pivot);
+}
+
+// Returns the smallest (if 'fill' is 0) or largest (if 'fill' is 0xff) id which first differs from
+// 'raw_id' at 'bit'.
+inline NodeId FirstDifferingAt(const std::string& raw_id, int bit, unsigned char fill) {
+  std::string bound(raw_id);
+  int byte_index(bit / 8);
+  unsigned char mask(static_cast<unsigned char>(0x80 >> (bit % 8)));
+  unsigned char low_bits(static_cast<unsigned char>(mask - 1));
+  unsigned char byte(static_cast<unsigned char>(bound[byte_index]));
+  byte = static_cast<unsigned char>(byte ^ mask);
+  bound[byte_index] = static_cast<char>((byte & ~low_bits) | (fill & low_bits));
+  std::fill(bound.begin() + byte_index + 1, bound.end(), static_cast<char>(fill));
+  return NodeId(bound);
+}
+
+template <typename RandomIt, typename GetId>
+void CollectClosest(RandomIt first, RandomIt last, const NodeId& target,
+                    const std::string& raw_target, size_t count, GetId get_id,
+                    std::vector<RandomIt>& closest) {
+  typedef typename std::iterator_traits<RandomIt>::value_type ValueType;
+  if (first == last || closest.size() >= count)
+    return;
+
+  int bit(kIdBitCount);
+  if (static_cast<size_t>(last - first) > count - closest.size())
+    bit = FirstDifferingBit(get_id(*first).string(), get_id(*(last - 1)).string());
+
+  if (bit == kIdBitCount) {  // Whole block is needed (or can't be split further)
+    size_t block_begin(closest.size());
+    for (auto itr(first); itr != last && closest.size() != count; ++itr)
+      closest.push_back(itr);
+    std::sort(closest.begin() + block_begin, closest.end(),
+              [&](const RandomIt& lhs, const RandomIt& rhs) {
+      return NodeId::CloserToTarget(get_id(*lhs), get_id(*rhs), target);
+    });
+    return;
+  }
+
+  NodeId pivot(BranchPivot(get_id(*first).string(), bit));
+  RandomIt middle(std::lower_bound(first, last, pivot,
+                                   [&](const ValueType& element, const NodeId& pivot_id) {
+    return get_id(element) < pivot_id;
+  }));
+  if (IsBitSet(raw_target, bit)) {
+    CollectClosest(middle, last, target, raw_target, count, get_id, closest);
+    CollectClosest(first, middle, target, raw_target, count, get_id, closest);
+  } else {
+    CollectClosest(first, middle, target, raw_target, count, get_id, closest);
+    CollectClosest(middle, last, target, raw_target, count, get_id, closest);
+  }
+}
+
+}  // namespace detail
+
+// Returns iterators to up to 'count' elements of [first, last) closest to 'target', closest
+// first.  The range must be sorted by ascending id (as given by 'get_id') and is not modified.
+template <typename RandomIt, typename GetId>
+std::vector<RandomIt> ClosestInSortedRange(RandomIt first, RandomIt last, const NodeId& target,
+                                           size_t count, GetId get_id) {
+  std::vector<RandomIt> closest;
+  closest.reserve(std::min(count, static_cast<size_t>(last - first)));
+  detail::CollectClosest(first, last, target, target.string(), count, get_id, closest);
+  return closest;
+}
+
+// Returns the contiguous sub-range of [first, last) whose ids share exactly their first 'bit' bits
+// with 'id' (i.e. the members of a routing table's bucket 511 - 'bit').  The range must be sorted by
+// ascending id (as given by 'get_id').
+template <typename RandomIt, typename GetId>
+std::pair<RandomIt, RandomIt> RangeFirstDifferingAt(RandomIt first, RandomIt last, const NodeId& id,
+                                                    int bit, GetId get_id) {
+  typedef typename std::iterator_traits<RandomIt>::value_type ValueType;
+  const std::string raw_id(id.string());
+  const NodeId lowest(detail::FirstDifferingAt(raw_id, bit, 0));
+  const NodeId highest(detail::FirstDifferingAt(raw_id, bit, 0xff));
+  RandomIt range_begin(std::lower_bound(first, last, lowest,
+                                        [&](const ValueType& element, const NodeId& bound) {
+    return get_id(element) < bound;
+  }));
+  RandomIt range_end(std::upper_bound(range_begin, last, highest,
+                                      [&](const NodeId& bound, const ValueType& element) {
+    return bound < get_id(element);
+  }));
+  return std::make_pair(range_begin, range_end);
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_SORTED_ID_LOOKUP_H_
@@ -0,0 +1,204 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+
+#include "maidsafe/routing/change_coalescer.h"
+#include "maidsafe/routing/group_matrix.h"
+#include "maidsafe/routing/matrix_change.h"
+#include "maidsafe/routing/node_info.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+class ChangeCoalescerTest : public testing::Test {
+ protected:
+  ChangeCoalescerTest()
+      : asio_service_(1),
+        matrix_(NodeId(NodeId::kRandomId), false),
+        mutex_(),
+        group_changes_(),
+        matrix_changes_() {}
+
+  void InitialiseFunctors(ChangeCoalescer& coalescer) {
+    coalescer.InitialiseFunctors([this](std::vector<NodeInfo> new_peers,
+                                        std::vector<NodeInfo> old_peers) {
+                                   std::lock_guard<std::mutex> lock(mutex_);
+                                   group_changes_.push_back(std::make_pair(new_peers, old_peers));
+                                 },
+                                 [this](std::shared_ptr<MatrixChange> matrix_change) {
+                                   std::lock_guard<std::mutex> lock(mutex_);
+                                   matrix_changes_.push_back(matrix_change);
+                                 });
+  }
+
+  // Makes the change to matrix_ and reports it to 'coalescer' as the routing table would.
+  void AddPeer(ChangeCoalescer& coalescer, const NodeInfo& peer) {
+    std::vector<NodeInfo> old_peers(matrix_.GetConnectedPeers());
+    std::shared_ptr<MatrixChange> matrix_change(matrix_.AddConnectedPeer(peer));
+    coalescer.AddConnectedGroupChange(matrix_.GetConnectedPeers(), old_peers);
+    coalescer.AddMatrixChange(matrix_change);
+  }
+
+  void RemovePeer(ChangeCoalescer& coalescer, const NodeInfo& peer) {
+    std::vector<NodeInfo> old_peers(matrix_.GetConnectedPeers());
+    std::shared_ptr<MatrixChange> matrix_change(matrix_.RemoveConnectedPeer(peer));
+    coalescer.AddConnectedGroupChange(matrix_.GetConnectedPeers(), old_peers);
+    coalescer.AddMatrixChange(matrix_change);
+  }
+
+  static NodeInfo MakePeer() {
+    NodeInfo peer;
+    peer.node_id = NodeId(NodeId::kRandomId);
+    return peer;
+  }
+
+  AsioService asio_service_;
+  GroupMatrix matrix_;
+  std::mutex mutex_;
+  std::vector<std::pair<std::vector<NodeInfo>, std::vector<NodeInfo>>> group_changes_;
+  std::vector<std::shared_ptr<MatrixChange>> matrix_changes_;
+};
+
+TEST_F(ChangeCoalescerTest, BEH_MergesChangesWithinWindow) {
+  ChangeCoalescer coalescer(asio_service_.service(), std::chrono::milliseconds(100));
+  std::promise<void> matrix_changed;
+  coalescer.InitialiseFunctors([this](std::vector<NodeInfo> new_peers,
+                                      std::vector<NodeInfo> old_peers) {
+                                 std::lock_guard<std::mutex> lock(mutex_);
+                                 group_changes_.push_back(std::make_pair(new_peers, old_peers));
+                               },
+                               [&](std::shared_ptr<MatrixChange> matrix_change) {
+                                 {
+                                   std::lock_guard<std::mutex> lock(mutex_);
+                                   matrix_changes_.push_back(matrix_change);
+                                 }
+                                 matrix_changed.set_value();
+                               });
+  std::vector<NodeInfo> peers;
+  for (int i(0); i != 3; ++i) {
+    peers.push_back(MakePeer());
+    AddPeer(coalescer, peers.back());
+  }
+
+  ASSERT_EQ(std::future_status::ready,
+            matrix_changed.get_future().wait_for(std::chrono::seconds(5)));
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT_EQ(1U, group_changes_.size());
+  EXPECT_EQ(peers.size(), group_changes_.front().first.size());
+  EXPECT_TRUE(group_changes_.front().second.empty());
+  ASSERT_EQ(1U, matrix_changes_.size());
+  EXPECT_TRUE(matrix_changes_.front()->lost_nodes().empty());
+  EXPECT_EQ(peers.size(), matrix_changes_.front()->new_nodes().size());
+}
+
+TEST_F(ChangeCoalescerTest, BEH_DropsNetChangesWhichUndoThemselves) {
+  ChangeCoalescer coalescer(asio_service_.service(), std::chrono::hours(1));
+  InitialiseFunctors(coalescer);
+  NodeInfo peer(MakePeer());
+  AddPeer(coalescer, peer);
+  RemovePeer(coalescer, peer);
+  coalescer.Flush();
+  EXPECT_TRUE(group_changes_.empty());
+  EXPECT_TRUE(matrix_changes_.empty());
+
+  // The next window starts afresh.
+  AddPeer(coalescer, peer);
+  coalescer.Flush();
+  EXPECT_EQ(1U, group_changes_.size());
+  ASSERT_EQ(1U, matrix_changes_.size());
+  EXPECT_EQ(1U, matrix_changes_.front()->new_nodes().size());
+}
+
+TEST_F(ChangeCoalescerTest, BEH_ZeroWindowPassesChangesOn) {
+  ChangeCoalescer coalescer(asio_service_.service(), std::chrono::steady_clock::duration::zero());
+  InitialiseFunctors(coalescer);
+  NodeInfo peer(MakePeer());
+  AddPeer(coalescer, peer);
+  EXPECT_EQ(1U, group_changes_.size());
+  EXPECT_EQ(1U, matrix_changes_.size());
+  RemovePeer(coalescer, peer);
+  EXPECT_EQ(2U, group_changes_.size());
+  EXPECT_EQ(2U, matrix_changes_.size());
+}
+
+TEST_F(ChangeCoalescerTest, BEH_DestroyedWithWindowOpen) {
+  // Keep the only asio thread busy so that the window closes, and its handler is due to run, after
+  // the coalescer has gone.
+  std::promise<void> release;
+  std::shared_future<void> released(release.get_future());
+  asio_service_.service().post([released] { released.wait(); });
+  {
+    ChangeCoalescer coalescer(asio_service_.service(), std::chrono::milliseconds(10));
+    InitialiseFunctors(coalescer);
+    AddPeer(coalescer, MakePeer());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  release.set_value();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  std::lock_guard<std::mutex> lock(mutex_);
+  EXPECT_TRUE(group_changes_.empty());
+  EXPECT_TRUE(matrix_changes_.empty());
+}
+
+TEST_F(ChangeCoalescerTest, BEH_StopWaitsForNotifications) {
+  ChangeCoalescer coalescer(asio_service_.service(), std::chrono::hours(1));
+  std::promise<void> entered, release;
+  std::shared_future<void> released(release.get_future());
+  int matrix_change_count(0);
+  coalescer.InitialiseFunctors([](std::vector<NodeInfo>, std::vector<NodeInfo>) {},  // NOLINT
+                               [&](std::shared_ptr<MatrixChange>) {
+                                 ++matrix_change_count;
+                                 entered.set_value();
+                                 released.wait();
+                               });
+  AddPeer(coalescer, MakePeer());
+  auto flushed(std::async(std::launch::async, [&] { coalescer.Flush(); }));
+  ASSERT_EQ(std::future_status::ready,
+            entered.get_future().wait_for(std::chrono::seconds(5)));
+
+  auto stopped(std::async(std::launch::async, [&] { coalescer.Stop(); }));
+  EXPECT_EQ(std::future_status::timeout, stopped.wait_for(std::chrono::milliseconds(100)));
+  release.set_value();
+  ASSERT_EQ(std::future_status::ready, stopped.wait_for(std::chrono::seconds(5)));
+  flushed.get();
+
+  // Nothing is passed on once stopped.
+  AddPeer(coalescer, MakePeer());
+  coalescer.Flush();
+  EXPECT_EQ(1, matrix_change_count);
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
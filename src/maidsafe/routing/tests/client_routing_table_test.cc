@@ -16,6 +16,7 @@
     See the Licences for the specific language governing permissions and limitations relating to
     use of the MaidSafe Software.                                                                 */
 
+#include <algorithm>
 #include <bitset>
 #include <memory>
 #include <vector>
@@ -289,6 +290,47 @@ TEST_F(ClientRoutingTableTest, FUNC_GetNodesInfo) {
   }
 }
 
+TEST_F(ClientRoutingTableTest, FUNC_LookupsAfterDropConnection) {
+  ClientRoutingTable client_routing_table(node_id_);
+
+  PopulateNodesSetFurthestCloseNode(Parameters::max_client_routing_table_size,
+                                    client_routing_table.kNodeId());
+  ScrambleNodesOrder();
+
+  std::vector<NodeInfo> expected_nodes;
+  NodeId sought_id(BiasNodeIds(expected_nodes));
+
+  PopulateClientRoutingTable(client_routing_table);
+  ScrambleNodesOrder();
+
+  // Drop every other connection; the remaining entries must still be found by both ids.
+  for (size_t i(0); i < nodes_.size(); ++i) {
+    if (i % 2 == 0) {
+      EXPECT_EQ(nodes_.at(i).connection_id,
+                client_routing_table.DropConnection(nodes_.at(i).connection_id).connection_id);
+      EXPECT_TRUE(client_routing_table.DropConnection(nodes_.at(i).connection_id).node_id.IsZero());
+    }
+  }
+  EXPECT_EQ(nodes_.size() / 2, client_routing_table.size());
+
+  for (size_t i(1); i < nodes_.size(); i += 2) {
+    EXPECT_TRUE(client_routing_table.Contains(nodes_.at(i).node_id));
+    std::vector<NodeInfo> got_nodes(client_routing_table.GetNodesInfo(nodes_.at(i).node_id));
+    EXPECT_TRUE(std::any_of(got_nodes.begin(), got_nodes.end(), [&](const NodeInfo & node_info) {
+      return node_info.connection_id == nodes_.at(i).connection_id;
+    }));
+  }
+
+  size_t remaining_sought(0);
+  for (size_t i(1); i < nodes_.size(); i += 2) {
+    if (nodes_.at(i).node_id == sought_id)
+      ++remaining_sought;
+  }
+  EXPECT_EQ(remaining_sought, client_routing_table.GetNodesInfo(sought_id).size());
+  EXPECT_EQ(remaining_sought, client_routing_table.DropNodes(sought_id).size());
+  EXPECT_FALSE(client_routing_table.Contains(sought_id));
+}
+
 TEST_F(ClientRoutingTableTest, FUNC_IsConnected) {
   ClientRoutingTable client_routing_table(node_id_);
 
@@ -0,0 +1,277 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/client_routing_table.h"
+#include "maidsafe/routing/group_change_handler.h"
+#include "maidsafe/routing/message_handler.h"
+#include "maidsafe/routing/network_statistics.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/routing_table.h"
+#include "maidsafe/routing/rpcs.h"
+#include "maidsafe/routing/tests/mock_network_utils.h"
+#include "maidsafe/routing/tests/test_utils.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+class GroupChangeHandlerTest : public testing::Test {
+ protected:
+  typedef std::pair<NodeId, protobuf::ClosestNodesUpdate> SentUpdate;
+
+  GroupChangeHandlerTest()
+      : node_id_(NodeId::kRandomId),
+        network_statistics_(node_id_),
+        routing_table_(false, node_id_, asymm::GenerateKeyPair(), network_statistics_),
+        client_routing_table_(routing_table_.kNodeId()),
+        network_(routing_table_, client_routing_table_),
+        group_change_handler_(routing_table_, client_routing_table_, network_),
+        peers_(),
+        sent_updates_() {}
+
+  void SetUp() override {
+    for (uint16_t i(0); i != Parameters::closest_nodes_size + 1; ++i) {
+      peers_.push_back(MakeNode());
+      ASSERT_TRUE(routing_table_.AddNode(peers_.back()));
+    }
+    SortFromTarget(node_id_, peers_);
+    EXPECT_CALL(network_, SendToDirect(testing::_, testing::_, testing::_))
+        .WillRepeatedly(testing::Invoke(this, &GroupChangeHandlerTest::RecordDirectSend));
+    EXPECT_CALL(network_, SendToClosestNode(testing::_))
+        .WillRepeatedly(testing::Invoke(this, &GroupChangeHandlerTest::RecordRoutedSend));
+  }
+
+  void RecordDirectSend(const protobuf::Message& message, const NodeId& peer,
+                        const NodeId& /*connection*/) {
+    EXPECT_EQ(peer.string(), message.destination_id());
+    RecordRoutedSend(message);
+  }
+
+  void RecordRoutedSend(const protobuf::Message& message) {
+    protobuf::ClosestNodesUpdate closest_nodes_update;
+    ASSERT_EQ(static_cast<int32_t>(MessageType::kClosestNodesUpdate), message.type());
+    ASSERT_TRUE(closest_nodes_update.ParseFromString(message.data(0)));
+    EXPECT_EQ(node_id_.string(), closest_nodes_update.node());
+    sent_updates_.push_back(
+        std::make_pair(NodeId(message.destination_id()), closest_nodes_update));
+  }
+
+  // Returns the updates sent to 'peer_id' since sent_updates_ was last cleared.
+  std::vector<protobuf::ClosestNodesUpdate> SentTo(const NodeId& peer_id) const {
+    std::vector<protobuf::ClosestNodesUpdate> updates;
+    for (const auto& sent_update : sent_updates_) {
+      if (sent_update.first == peer_id)
+        updates.push_back(sent_update.second);
+    }
+    return updates;
+  }
+
+  std::pair<NodeId, std::vector<NodeInfo>> Receive(protobuf::Message message) {
+    return group_change_handler_.ClosestNodesUpdate(message);
+  }
+
+  static std::vector<NodeInfo> MakeList(size_t size) {
+    std::vector<NodeInfo> nodes;
+    for (size_t i(0); i != size; ++i) {
+      NodeInfo node_info;
+      node_info.node_id = NodeId(NodeId::kRandomId);
+      node_info.rank = static_cast<int32_t>(RandomUint32() % 100);
+      nodes.push_back(node_info);
+    }
+    return nodes;
+  }
+
+  static bool SameList(const std::vector<NodeInfo>& expected,
+                       const std::vector<NodeInfo>& actual) {
+    return expected.size() == actual.size() &&
+           std::equal(expected.begin(), expected.end(), actual.begin(),
+                      [](const NodeInfo& lhs, const NodeInfo& rhs) {
+                        return lhs.node_id == rhs.node_id && lhs.rank == rhs.rank;
+                      });
+  }
+
+  NodeId node_id_;
+  NetworkStatistics network_statistics_;
+  RoutingTable routing_table_;
+  ClientRoutingTable client_routing_table_;
+  MockNetworkUtils network_;
+  GroupChangeHandler group_change_handler_;
+  // In the routing table, closest to node_id_ first
+  std::vector<NodeInfo> peers_;
+  std::vector<SentUpdate> sent_updates_;
+};
+
+TEST_F(GroupChangeHandlerTest, BEH_AppliesDelta) {
+  const NodeId kSender(peers_.front().node_id);
+  std::vector<NodeInfo> expected(MakeList(Parameters::closest_nodes_size));
+
+  // Full lists are passed on closest to their sender first, whatever order they arrive in.
+  auto received(Receive(rpcs::ClosestNodesUpdate(node_id_, kSender, expected, 10)));
+  SortFromTarget(kSender, expected);
+  EXPECT_EQ(kSender, received.first);
+  EXPECT_TRUE(SameList(expected, received.second));
+
+  // Remove two nodes, add one and re-rank another.
+  std::vector<NodeId> removed_nodes(1, expected.at(0).node_id);
+  removed_nodes.push_back(expected.at(3).node_id);
+  std::vector<NodeInfo> added_nodes(MakeList(1));
+  added_nodes.push_back(expected.at(1));
+  added_nodes.back().rank += 1;
+  received = Receive(
+      rpcs::ClosestNodesUpdateDelta(node_id_, kSender, added_nodes, removed_nodes, 11));
+  expected.erase(expected.begin() + 3);
+  expected.erase(expected.begin());
+  expected.front().rank += 1;
+  expected.push_back(added_nodes.front());
+  SortFromTarget(kSender, expected);
+  EXPECT_EQ(kSender, received.first);
+  EXPECT_TRUE(SameList(expected, received.second));
+  EXPECT_TRUE(sent_updates_.empty());
+}
+
+TEST_F(GroupChangeHandlerTest, BEH_RequestsResendAfterMissedUpdate) {
+  const NodeId kSender(peers_.front().node_id);
+  std::vector<NodeInfo> nodes(MakeList(Parameters::closest_nodes_size));
+  EXPECT_EQ(kSender, Receive(rpcs::ClosestNodesUpdate(node_id_, kSender, nodes, 10)).first);
+
+  // Update 11 is missed.
+  auto received(Receive(rpcs::ClosestNodesUpdateDelta(node_id_, kSender, MakeList(1),
+                                                      std::vector<NodeId>(), 12)));
+  EXPECT_TRUE(received.first.IsZero());
+  ASSERT_EQ(1U, SentTo(kSender).size());
+  EXPECT_TRUE(SentTo(kSender).front().resend_requested());
+
+  // Until the full list arrives, no delta can be applied.
+  sent_updates_.clear();
+  received = Receive(rpcs::ClosestNodesUpdateDelta(node_id_, kSender, MakeList(1),
+                                                   std::vector<NodeId>(), 13));
+  EXPECT_TRUE(received.first.IsZero());
+  ASSERT_EQ(1U, SentTo(kSender).size());
+  EXPECT_TRUE(SentTo(kSender).front().resend_requested());
+
+  sent_updates_.clear();
+  EXPECT_EQ(kSender, Receive(rpcs::ClosestNodesUpdate(node_id_, kSender, nodes, 13)).first);
+  EXPECT_EQ(kSender, Receive(rpcs::ClosestNodesUpdateDelta(node_id_, kSender, MakeList(1),
+                                                           std::vector<NodeId>(), 14)).first);
+  EXPECT_TRUE(sent_updates_.empty());
+
+  // A sender which has left the routing table is still asked, via the closest node.
+  const NodeId kUnknownSender(NodeId::kRandomId);
+  received = Receive(rpcs::ClosestNodesUpdateDelta(node_id_, kUnknownSender, MakeList(1),
+                                                   std::vector<NodeId>(), 1));
+  EXPECT_TRUE(received.first.IsZero());
+  ASSERT_EQ(1U, SentTo(kUnknownSender).size());
+  EXPECT_TRUE(SentTo(kUnknownSender).front().resend_requested());
+}
+
+TEST_F(GroupChangeHandlerTest, BEH_AnswersResendRequest) {
+  std::vector<NodeInfo> closest_nodes(peers_.begin(),
+                                      peers_.begin() + Parameters::closest_nodes_size);
+  group_change_handler_.SendClosestNodesUpdateRpcs(closest_nodes, std::vector<NodeInfo>());
+  ASSERT_EQ(closest_nodes.size(), sent_updates_.size());
+  const uint32_t kSequence(sent_updates_.front().second.sequence());
+
+  // The requester is sent the last list in full, and is sent deltas from then on.
+  const NodeId kRequester(closest_nodes.front().node_id);
+  sent_updates_.clear();
+  EXPECT_TRUE(Receive(rpcs::ClosestNodesUpdateResendRequest(node_id_, kRequester)).first.IsZero());
+  ASSERT_EQ(1U, sent_updates_.size());
+  ASSERT_EQ(1U, SentTo(kRequester).size());
+  EXPECT_FALSE(SentTo(kRequester).front().delta());
+  EXPECT_EQ(kSequence, SentTo(kRequester).front().sequence());
+  EXPECT_EQ(static_cast<int>(closest_nodes.size()), SentTo(kRequester).front().nodes_info_size());
+
+  std::vector<NodeInfo> old_closest_nodes(closest_nodes);
+  closest_nodes.back() = peers_.back();
+  sent_updates_.clear();
+  group_change_handler_.SendClosestNodesUpdateRpcs(closest_nodes, old_closest_nodes);
+  ASSERT_EQ(1U, SentTo(kRequester).size());
+  EXPECT_TRUE(SentTo(kRequester).front().delta());
+  EXPECT_EQ(kSequence + 1, SentTo(kRequester).front().sequence());
+}
+
+TEST_F(GroupChangeHandlerTest, BEH_SendsDeltasOnlyToPeersWhichUnderstandThem) {
+  std::vector<NodeInfo> closest_nodes(peers_.begin(),
+                                      peers_.begin() + Parameters::closest_nodes_size);
+  // The first half number their updates.  The next peer runs an older version which doesn't.
+  const size_t kNumbering(closest_nodes.size() / 2);
+  for (size_t i(0); i != kNumbering; ++i) {
+    Receive(rpcs::ClosestNodesUpdate(node_id_, closest_nodes.at(i).node_id,
+                                     MakeList(Parameters::closest_nodes_size), 1));
+  }
+  protobuf::Message old_update(rpcs::ClosestNodesUpdate(node_id_,
+                                                        closest_nodes.at(kNumbering).node_id,
+                                                        MakeList(Parameters::closest_nodes_size),
+                                                        1));
+  protobuf::ClosestNodesUpdate old_closest_nodes_update;
+  ASSERT_TRUE(old_closest_nodes_update.ParseFromString(old_update.data(0)));
+  old_closest_nodes_update.clear_sequence();
+  old_update.set_data(0, old_closest_nodes_update.SerializeAsString());
+  Receive(old_update);
+  EXPECT_TRUE(sent_updates_.empty());
+
+  // Nobody has been sent an update yet, so all are sent the full list.
+  group_change_handler_.SendClosestNodesUpdateRpcs(closest_nodes, std::vector<NodeInfo>());
+  ASSERT_EQ(closest_nodes.size(), sent_updates_.size());
+  for (const auto& sent_update : sent_updates_) {
+    EXPECT_FALSE(sent_update.second.delta());
+    EXPECT_EQ(static_cast<int>(closest_nodes.size()), sent_update.second.nodes_info_size());
+  }
+
+  // The furthest close node is replaced.
+  std::vector<NodeInfo> old_closest_nodes(closest_nodes);
+  const NodeInfo kDropped(closest_nodes.back());
+  closest_nodes.back() = peers_.back();
+  sent_updates_.clear();
+  group_change_handler_.SendClosestNodesUpdateRpcs(closest_nodes, old_closest_nodes);
+  EXPECT_EQ(closest_nodes.size() + 1, sent_updates_.size());
+  for (size_t i(0); i != closest_nodes.size(); ++i) {
+    auto updates(SentTo(closest_nodes.at(i).node_id));
+    ASSERT_EQ(1U, updates.size());
+    if (i < kNumbering) {
+      EXPECT_TRUE(updates.front().delta());
+      ASSERT_EQ(1, updates.front().nodes_info_size());
+      EXPECT_EQ(peers_.back().node_id.string(), updates.front().nodes_info(0).node_id());
+      ASSERT_EQ(1, updates.front().removed_nodes_size());
+      EXPECT_EQ(kDropped.node_id.string(), updates.front().removed_nodes(0));
+    } else {  // Older, not yet heard from, or new to the list
+      EXPECT_FALSE(updates.front().delta());
+      EXPECT_EQ(static_cast<int>(closest_nodes.size()), updates.front().nodes_info_size());
+    }
+  }
+  // The node which has dropped out is told too.
+  ASSERT_EQ(1U, SentTo(kDropped.node_id).size());
+  EXPECT_FALSE(SentTo(kDropped.node_id).front().delta());
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
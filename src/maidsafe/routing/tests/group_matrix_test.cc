@@ -16,6 +16,7 @@
     See the Licences for the specific language governing permissions and limitations relating to
     use of the MaidSafe Software.                                                                 */
 
+#include <algorithm>
 #include <bitset>
 #include <memory>
 #include <numeric>
@@ -480,6 +481,15 @@ TEST_P(GroupMatrixTest, BEH_AddUpdateGetRemovePeers) {
 
   SortNodeInfosFromTarget(own_node_id_, row_ids);
   EXPECT_TRUE(CompareListOfNodeInfos(row_ids, matrix_.GetConnectedPeers()));
+  auto same_order([](const std::vector<NodeInfo>& expected, const std::vector<NodeInfo>& actual) {
+    return expected.size() == actual.size() &&
+           std::equal(expected.begin(), expected.end(), actual.begin(),
+                      [](const NodeInfo& lhs, const NodeInfo& rhs) {
+                        return lhs.node_id == rhs.node_id;
+                      });
+  });
+  // Closest first, whatever order the peers were added in
+  EXPECT_TRUE(same_order(row_ids, matrix_.GetConnectedPeers()));
 
   // Update peers
   std::vector<NodeInfo> row_entries;
@@ -500,6 +510,7 @@ TEST_P(GroupMatrixTest, BEH_AddUpdateGetRemovePeers) {
 
   SortNodeInfosFromTarget(own_node_id_, row_ids);
   EXPECT_EQ(row_ids.size(), matrix_.GetConnectedPeers().size());
+  EXPECT_TRUE(same_order(row_ids, matrix_.GetConnectedPeers()));
 
   // Remove peers
   SortNodeInfosFromTarget(own_node_id_, row_ids);
@@ -507,7 +518,7 @@ TEST_P(GroupMatrixTest, BEH_AddUpdateGetRemovePeers) {
     uint32_t index(RandomUint32() % row_ids.size());
     matrix_.RemoveConnectedPeer(row_ids.at(index));
     row_ids.erase(row_ids.begin() + index);
-    EXPECT_TRUE(CompareListOfNodeInfos(row_ids, matrix_.GetConnectedPeers()));
+    EXPECT_TRUE(same_order(row_ids, matrix_.GetConnectedPeers()));
   }
 
   EXPECT_EQ(0, matrix_.GetConnectedPeers().size());
@@ -863,6 +874,136 @@ TEST_P(GroupMatrixTest, BEH_CheckUniqueNodeList) {
   }
 }
 
+TEST_P(GroupMatrixTest, BEH_UniqueNodesFollowRemovals) {
+  std::vector<NodeInfo> row_ids, shared_entries;
+  for (uint32_t i(0); i < Parameters::closest_nodes_size; ++i) {
+    NodeInfo node;
+    node.node_id = NodeId(NodeId::kRandomId);
+    row_ids.push_back(node);
+    matrix_.AddConnectedPeer(node);
+  }
+  for (uint32_t i(0); i < 2; ++i) {
+    NodeInfo node;
+    node.node_id = NodeId(NodeId::kRandomId);
+    shared_entries.push_back(node);
+  }
+  for (const auto& row_id : row_ids)
+    matrix_.UpdateFromConnectedPeer(row_id.node_id, shared_entries, std::vector<NodeId>());
+
+  // Entries held by several rows remain unique nodes until the last of those rows is removed.
+  while (!row_ids.empty()) {
+    matrix_.RemoveConnectedPeer(row_ids.front());
+    row_ids.erase(row_ids.begin());
+    std::vector<NodeInfo> expected(row_ids);
+    if (!row_ids.empty())
+      expected.insert(expected.end(), shared_entries.begin(), shared_entries.end());
+    if (!client_mode_)
+      expected.push_back(own_node_info_);
+    SortNodeInfosFromTarget(own_node_id_, expected);
+    auto unique_nodes(matrix_.GetUniqueNodes());
+    ASSERT_EQ(expected.size(), unique_nodes.size());
+    for (size_t i(0); i != expected.size(); ++i)
+      EXPECT_EQ(expected.at(i).node_id, unique_nodes.at(i).node_id);
+    for (const auto& shared_entry : shared_entries)
+      EXPECT_EQ(!row_ids.empty(), matrix_.Contains(shared_entry.node_id));
+  }
+}
+
+TEST_P(GroupMatrixTest, BEH_RowsHoldIdsAndRanks) {
+  std::vector<NodeInfo> row_ids;
+  std::vector<std::vector<NodeInfo>> rows;
+  for (uint32_t i(0); i < 3; ++i) {
+    row_ids.push_back(MakeNode());
+    matrix_.AddConnectedPeer(row_ids.back());
+    std::vector<NodeInfo> row;
+    for (uint32_t j(0); j < i + 2; ++j) {
+      NodeInfo node;
+      node.node_id = NodeId(NodeId::kRandomId);
+      node.rank = static_cast<int32_t>(10 * i + j);
+      row.push_back(node);
+    }
+    rows.push_back(row);
+    matrix_.UpdateFromConnectedPeer(row_ids.back().node_id, row, std::vector<NodeId>());
+  }
+
+  // Erasing or resizing one row must leave the entries of the rows stored after it intact.
+  auto check_row([&](size_t index) {
+    std::vector<NodeInfo> row_entries;
+    ASSERT_TRUE(matrix_.GetRow(row_ids.at(index).node_id, row_entries));
+    ASSERT_EQ(rows.at(index).size(), row_entries.size());
+    for (size_t i(0); i != row_entries.size(); ++i) {
+      EXPECT_EQ(rows.at(index).at(i).node_id, row_entries.at(i).node_id);
+      EXPECT_EQ(rows.at(index).at(i).rank, row_entries.at(i).rank);
+    }
+  });
+  rows.at(1).resize(1);
+  matrix_.UpdateFromConnectedPeer(row_ids.at(1).node_id, rows.at(1), std::vector<NodeId>());
+  for (size_t index(0); index != rows.size(); ++index)
+    check_row(index);
+
+  matrix_.RemoveConnectedPeer(row_ids.at(0));
+  row_ids.erase(row_ids.begin());
+  rows.erase(rows.begin());
+  for (size_t index(0); index != rows.size(); ++index)
+    check_row(index);
+  EXPECT_EQ(row_ids.at(1).node_id,
+            matrix_.GetConnectedPeerFor(rows.at(1).back().node_id).node_id);
+}
+
+TEST_P(GroupMatrixTest, BEH_GetBetterNodeForSendingMessage) {
+  // Rows share some entries, so several peers can lead to the same node.
+  std::vector<NodeInfo> shared_entries;
+  for (uint32_t i(0); i < Parameters::closest_nodes_size; ++i)
+    shared_entries.push_back(MakeNode());
+  std::vector<std::pair<NodeInfo, std::vector<NodeInfo>>> rows;
+  for (uint32_t i(0); i < Parameters::closest_nodes_size; ++i) {
+    rows.push_back(std::make_pair(MakeNode(), std::vector<NodeInfo>()));
+    matrix_.AddConnectedPeer(rows.back().first);
+    for (uint32_t j(0); j < Parameters::closest_nodes_size; ++j) {
+      if (j % 2 == 0)
+        rows.back().second.push_back(shared_entries.at(RandomUint32() % shared_entries.size()));
+      else
+        rows.back().second.push_back(MakeNode());
+    }
+    matrix_.UpdateFromConnectedPeer(rows.back().first.node_id, rows.back().second,
+                                    std::vector<NodeId>());
+  }
+
+  // The lookup must agree with a scan of every row, taking the first row for a node.
+  for (int attempt(0); attempt != 50; ++attempt) {
+    const NodeId target_id(NodeId::kRandomId);
+    const bool ignore_exact_match(attempt % 2 == 0);
+    NodeIdSet exclude;
+    for (const auto& row : rows) {
+      if (RandomUint32() % 4 == 0)
+        exclude.insert(row.first.node_id);
+      if (RandomUint32() % 4 == 0)
+        exclude.insert(row.second.at(RandomUint32() % row.second.size()).node_id);
+    }
+    NodeInfo expected;
+    expected.node_id = own_node_id_;
+    NodeId closest_id(expected.node_id);
+    for (const auto& row : rows) {
+      if (exclude.count(row.first.node_id) != 0)
+        continue;
+      std::vector<NodeInfo> nodes(1, row.first);
+      nodes.insert(nodes.end(), row.second.begin(), row.second.end());
+      for (const auto& node : nodes) {
+        if (exclude.count(node.node_id) == 0 && node.node_id != own_node_id_ &&
+            NodeId::CloserToTarget(node.node_id, closest_id, target_id)) {
+          closest_id = node.node_id;
+          expected = row.first;
+        }
+      }
+    }
+    NodeInfo current_closest_peer;
+    current_closest_peer.node_id = own_node_id_;
+    matrix_.GetBetterNodeForSendingMessage(target_id, exclude, ignore_exact_match,
+                                           current_closest_peer);
+    EXPECT_EQ(expected.node_id, current_closest_peer.node_id);
+  }
+}
+
 TEST_P(GroupMatrixTest, BEH_GetAllConnectedPeers) {
   // Add rows to matrix and check GetUniqueNodes
   std::vector<NodeInfo> row_ids;
@@ -10,12 +10,14 @@
  *  the explicit written permission of the board of directors of maidsafe.net. *
  ******************************************************************************/
 
+#include <algorithm>
 #include <bitset>
 #include <map>
 #include <memory>
 #include <numeric>
 #include <random>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "maidsafe/common/node_id.h"
@@ -182,6 +184,44 @@ TEST_F(MatrixChangeTest, BEH_CheckHolders) {
     DoCheckHoldersTest(matrix_change);
 }
 
+TEST_F(MatrixChangeTest, BEH_CheckHoldersBatch) {
+  new_matrix_.erase(new_matrix_.begin() + 1, new_matrix_.begin() + 4);
+  for (auto i(0); i != 3; ++i)
+    new_matrix_.push_back(NodeId(NodeId::kRandomId));
+  MatrixChange matrix_change(kNodeId_, old_matrix_, new_matrix_);
+  EXPECT_FALSE(matrix_change.OldEqualsToNew());
+
+  // Sorted targets, including the matrix ids and ids differing from them only in the last bit, so
+  // that most share their region with the previous target.
+  std::vector<NodeId> targets(old_matrix_);
+  targets.insert(targets.end(), new_matrix_.begin(), new_matrix_.end());
+  for (const auto& node_id : new_matrix_) {
+    std::string raw_id(node_id.string());
+    raw_id.back() = static_cast<char>(raw_id.back() ^ 1);
+    targets.push_back(NodeId(raw_id));
+  }
+  for (auto i(0); i != 1000; ++i)
+    targets.push_back(NodeId(NodeId::kRandomId));
+  targets.erase(std::remove(targets.begin(), targets.end(), kNodeId_), targets.end());
+  std::sort(targets.begin(), targets.end());
+
+  for (unsigned worker_count(1); worker_count != 5; worker_count += 3) {
+    auto results(matrix_change.CheckHolders(targets, worker_count));
+    ASSERT_EQ(targets.size(), results.size());
+    for (size_t i(0); i != targets.size(); ++i) {
+      auto expected(CheckHolders(targets.at(i), old_matrix_, new_matrix_));
+      EXPECT_EQ(expected.proximity_status, results.at(i).proximity_status);
+      EXPECT_EQ(expected.new_holders, results.at(i).new_holders);
+      EXPECT_EQ(expected.old_holders, results.at(i).old_holders);
+    }
+  }
+
+  // The same ids in a different order are no change.
+  std::vector<NodeId> reordered(old_matrix_.rbegin(), old_matrix_.rend());
+  EXPECT_TRUE(MatrixChange(kNodeId_, old_matrix_, reordered).OldEqualsToNew());
+  EXPECT_TRUE(MatrixChange(kNodeId_, old_matrix_, reordered).lost_nodes().empty());
+}
+
 TEST_F(MatrixChangeTest, BEH_GroupMatrixUpdating) {
   GroupMatrix group_matrix(kNodeId_, false);
   for (auto& node : old_matrix_) {
@@ -26,6 +26,7 @@
 #include "maidsafe/passport/types.h"
 
 #include "maidsafe/routing/message_handler.h"
+#include "maidsafe/routing/message_header.h"
 #include "maidsafe/routing/tests/mock_service.h"
 #include "maidsafe/routing/tests/mock_response_handler.h"
 #include "maidsafe/routing/tests/mock_network_utils.h"
@@ -141,6 +142,101 @@ TEST_F(MessageHandlerTest, BEH_HandleInvalidMessage) {
   message_handler.HandleMessage(message);  // Handle message with invalid source ID
 }
 
+TEST_F(MessageHandlerTest, BEH_HandleMessageHeader) {
+  MessageHandler message_handler(*table_, *ntable_, *utils_, timer_, *remove_furthest_node_,
+                                 *group_change_handler_, *network_statistics_);
+  for (uint16_t i(0); i < Parameters::closest_nodes_size; ++i)
+    table_->AddNode(MakeNodeInfoAndKeys().node_info);
+  auto make_message = [](const NodeId& destination_id) -> protobuf::Message {
+    protobuf::Message message;
+    message.set_routing_message(false);
+    message.set_direct(true);
+    message.set_request(true);
+    message.set_client_node(false);
+    message.set_hops_to_live(2);
+    message.set_source_id(NodeId(NodeId::kRandomId).string());
+    message.set_destination_id(destination_id.string());
+    message.add_data("payload");
+    return message;
+  };
+  // Splits 'message' as a received message is split.
+  auto split = [](const protobuf::Message& message, protobuf::Message& header,
+                  SharedBuffer& payload) {
+    return ParseMessageHeader(SharedBuffer(message.SerializeAsString()), header, payload);
+  };
+  auto carries_payload = testing::Truly([](const protobuf::Message& message) {
+    return message.data_size() == 1 && message.data(0) == "payload";
+  });
+
+  {  // Passed on, without the payload being parsed
+    const NodeId destination_id(table_->kNodeId() ^ NodeId(NodeId::kMaxId));
+    protobuf::Message header;
+    SharedBuffer payload;
+    ASSERT_TRUE(split(make_message(destination_id), header, payload));
+    EXPECT_CALL(*utils_, SendToClosestNode(testing::AllOf(
+                             testing::Property(&protobuf::Message::destination_id,
+                                               destination_id.string()),
+                             testing::Property(&protobuf::Message::hops_to_live, 1),
+                             carries_payload)))
+        .Times(1)
+        .RetiresOnSaturation();
+    EXPECT_CALL(*utils_, SendToDirect(testing::_, testing::_, testing::_)).Times(0);
+    EXPECT_TRUE(message_handler.HandleMessageHeader(header, payload));
+    EXPECT_EQ(0, header.data_size());
+    testing::Mock::VerifyAndClearExpectations(utils_.get());
+  }
+  {  // Handled as one of the closest nodes, with the payload parsed
+    protobuf::Message header;
+    SharedBuffer payload;
+    ASSERT_TRUE(split(make_message(close_info_.node_id), header, payload));
+    EXPECT_CALL(*utils_, SendToClosestNode(testing::AllOf(
+                             testing::Property(&protobuf::Message::destination_id,
+                                               close_info_.node_id.string()),
+                             testing::Property(&protobuf::Message::hops_to_live, 1),
+                             carries_payload)))
+        .Times(1)
+        .RetiresOnSaturation();
+    EXPECT_CALL(*utils_, SendToDirect(testing::_, testing::_, testing::_)).Times(0);
+    EXPECT_TRUE(message_handler.HandleMessageHeader(header, payload));
+    EXPECT_EQ(1, header.data_size());
+    testing::Mock::VerifyAndClearExpectations(utils_.get());
+  }
+  {  // Invalid and stray messages dropped
+    EXPECT_CALL(*utils_, SendToClosestNode(testing::_)).Times(0);
+    EXPECT_CALL(*utils_, SendToDirect(testing::_, testing::_, testing::_)).Times(0);
+    protobuf::Message message(make_message(NodeId(NodeId::kRandomId))), header;
+    SharedBuffer payload;
+    message.set_hops_to_live(0);
+    ASSERT_TRUE(split(message, header, payload));
+    EXPECT_TRUE(message_handler.HandleMessageHeader(header, payload));
+    message.set_hops_to_live(2);
+    message.set_source_id(NodeId().string());
+    ASSERT_TRUE(split(message, header, payload));
+    EXPECT_TRUE(message_handler.HandleMessageHeader(header, payload));
+    testing::Mock::VerifyAndClearExpectations(utils_.get());
+  }
+  {  // Left unchanged for HandleMessage
+    EXPECT_CALL(*utils_, SendToClosestNode(testing::_)).Times(0);
+    EXPECT_CALL(*utils_, SendToDirect(testing::_, testing::_, testing::_)).Times(0);
+    protobuf::Message header;
+    SharedBuffer payload;
+    ASSERT_TRUE(split(make_message(table_->kNodeId()), header, payload));
+    std::string serialised_header(header.SerializeAsString());
+    EXPECT_FALSE(message_handler.HandleMessageHeader(header, payload));
+    EXPECT_EQ(serialised_header, header.SerializeAsString());
+
+    protobuf::Message relay_message(make_message(close_info_.node_id));
+    relay_message.clear_source_id();
+    relay_message.set_relay_id(NodeId(NodeId::kRandomId).string());
+    relay_message.set_relay_connection_id(NodeId(NodeId::kRandomId).string());
+    ASSERT_TRUE(split(relay_message, header, payload));
+    serialised_header = header.SerializeAsString();
+    EXPECT_FALSE(message_handler.HandleMessageHeader(header, payload));
+    EXPECT_EQ(serialised_header, header.SerializeAsString());
+    testing::Mock::VerifyAndClearExpectations(utils_.get());
+  }
+}
+
 TEST_F(MessageHandlerTest, BEH_HandleRelay) {
   MessageHandler message_handler(*table_, *ntable_, *utils_, timer_, *remove_furthest_node_,
                                  *group_change_handler_, *network_statistics_);
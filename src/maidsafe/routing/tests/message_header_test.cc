@@ -0,0 +1,131 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <string>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/message_header.h"
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/shared_buffer.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+namespace {
+
+protobuf::Message MakeMessage() {
+  protobuf::Message message;
+  message.set_source_id(NodeId(NodeId::kRandomId).string());
+  message.set_destination_id(NodeId(NodeId::kRandomId).string());
+  message.set_routing_message(false);
+  message.add_data(RandomString(1024));
+  message.add_data(RandomString(16));
+  message.set_signature(RandomString(64));
+  message.set_direct(true);
+  message.set_client_node(false);
+  message.set_request(true);
+  message.set_hops_to_live(10);
+  message.set_id(RandomUint32() % 10000);
+  message.add_route_history(NodeId(NodeId::kRandomId).string());
+  return message;
+}
+
+}  // unnamed namespace
+
+TEST(MessageHeaderTest, BEH_SplitsHeaderFromPayload) {
+  protobuf::Message message(MakeMessage());
+  const SharedBuffer kSerialisedMessage(message.SerializeAsString());
+  protobuf::Message header;
+  SharedBuffer payload;
+  ASSERT_TRUE(ParseMessageHeader(kSerialisedMessage, header, payload));
+  EXPECT_EQ(0, header.data_size());
+  EXPECT_FALSE(header.has_signature());
+  EXPECT_EQ(message.source_id(), header.source_id());
+  EXPECT_EQ(message.destination_id(), header.destination_id());
+  EXPECT_EQ(message.hops_to_live(), header.hops_to_live());
+  EXPECT_EQ(message.id(), header.id());
+  ASSERT_EQ(1, header.route_history_size());
+  EXPECT_EQ(message.route_history(0), header.route_history(0));
+  // The payload fields are adjacent on the wire, so the payload is a slice of the message.
+  EXPECT_GT(payload.data(), kSerialisedMessage.data());
+  EXPECT_LT(payload.data() + payload.size(), kSerialisedMessage.data() + kSerialisedMessage.size());
+
+  // Changes made to the header survive the payload being appended as received.
+  header.set_hops_to_live(header.hops_to_live() - 1);
+  header.add_route_history(NodeId(NodeId::kRandomId).string());
+  protobuf::Message forwarded;
+  ASSERT_TRUE(forwarded.ParseFromString(header.SerializeAsString() + payload.string()));
+  message.set_hops_to_live(message.hops_to_live() - 1);
+  message.add_route_history(header.route_history(1));
+  EXPECT_EQ(message.SerializeAsString(), forwarded.SerializeAsString());
+
+  ASSERT_TRUE(MergePayload(payload, header));
+  EXPECT_EQ(message.SerializeAsString(), header.SerializeAsString());
+}
+
+TEST(MessageHeaderTest, BEH_GathersScatteredPayload) {
+  // Fields may come in any order; here a header field lies between the data and the signature.
+  const protobuf::Message kMessage(MakeMessage());
+  protobuf::Message data_part, id_part, rest;
+  data_part.mutable_data()->CopyFrom(kMessage.data());
+  id_part.set_id(kMessage.id());
+  rest.CopyFrom(kMessage);
+  rest.clear_data();
+  rest.clear_id();
+  protobuf::Message header;
+  SharedBuffer payload;
+  ASSERT_TRUE(ParseMessageHeader(SharedBuffer(data_part.SerializePartialAsString() +
+                                              id_part.SerializePartialAsString() +
+                                              rest.SerializePartialAsString()),
+                                 header, payload));
+  EXPECT_EQ(0, header.data_size());
+  EXPECT_FALSE(header.has_signature());
+  EXPECT_EQ(kMessage.id(), header.id());
+  ASSERT_TRUE(MergePayload(payload, header));
+  EXPECT_EQ(kMessage.SerializeAsString(), header.SerializeAsString());
+}
+
+TEST(MessageHeaderTest, BEH_RejectsMalformedMessages) {
+  protobuf::Message header;
+  SharedBuffer payload;
+  const std::string kSerialisedMessage(MakeMessage().SerializeAsString());
+  EXPECT_FALSE(ParseMessageHeader(
+      SharedBuffer(kSerialisedMessage.substr(0, kSerialisedMessage.size() - 1)), header, payload));
+  EXPECT_FALSE(header.IsInitialized());
+  EXPECT_TRUE(payload.empty());
+  EXPECT_FALSE(ParseMessageHeader(SharedBuffer(RandomString(256)), header, payload));
+
+  // Missing required fields
+  protobuf::Message message(MakeMessage());
+  message.clear_hops_to_live();
+  EXPECT_FALSE(ParseMessageHeader(SharedBuffer(message.SerializePartialAsString()), header,
+                                  payload));
+  EXPECT_TRUE(payload.empty());
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -20,9 +20,11 @@
 #define MAIDSAFE_ROUTING_TESTS_MOCK_NETWORK_UTILS_H_
 
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 
+#include "maidsafe/routing/message_header.h"
 #include "maidsafe/routing/network_utils.h"
 #include "maidsafe/routing/routing.pb.h"
 
@@ -38,9 +40,28 @@ class MockNetworkUtils : public NetworkUtils {
   virtual ~MockNetworkUtils();
 
   MOCK_METHOD1(SendToClosestNode, void(const protobuf::Message& message));
+  // Sends along a looked-up route are expected as plain SendToClosestNode calls.
+  virtual void SendToClosestNode(const protobuf::Message& message, const RouteDecision& /*route*/) {
+    SendToClosestNode(message);
+  }
+  // So are sends of a message split by ParseMessageHeader, with the payload merged back in.
+  virtual void SendToClosestNode(const protobuf::Message& header, const RouteDecision& /*route*/,
+                                 const SharedBuffer& payload) {
+    protobuf::Message message(header);
+    if (MergePayload(payload, message))
+      SendToClosestNode(message);
+  }
   MOCK_METHOD1(MarkConnectionAsValid, int(const NodeId& peer_id));
   MOCK_METHOD3(SendToDirect, void(const protobuf::Message& message, const NodeId& peer,
                                   const NodeId& connection));
+  // Sends to several peers are expected as one SendToDirect call per peer.
+  virtual void SendToDirect(protobuf::Message& message, const std::vector<NodeInfo>& peers) {
+    for (const auto& peer : peers) {
+      protobuf::Message peer_message(message);
+      peer_message.set_destination_id(peer.node_id.string());
+      SendToDirect(peer_message, peer.node_id, peer.connection_id);
+    }
+  }
   MOCK_METHOD3(Add, int(const NodeId& peer_id, const rudp::EndpointPair& peer_endpoint_pair,
                         const std::string& validation_data));
   MOCK_METHOD4(GetAvailableEndpoint,
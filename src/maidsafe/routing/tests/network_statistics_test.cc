@@ -16,9 +16,11 @@
     See the Licences for the specific language governing permissions and limitations relating to
     use of the MaidSafe Software.                                                                 */
 
+#include <algorithm>
 #include <bitset>
+#include <limits>
 #include <memory>
-#include <numeric>
+#include <string>
 #include <vector>
 
 #include "maidsafe/common/node_id.h"
@@ -34,54 +36,60 @@ namespace maidsafe {
 namespace routing {
 namespace test {
 
-TEST(NetworkStatisticsTest, BEH_AverageDistance) {
-  NodeId node_id(NodeId::kRandomId);
-  NodeId average(node_id);
-  NetworkStatistics network_statistics(node_id);
-  network_statistics.network_distance_data_.average_distance = average;
-  network_statistics.UpdateNetworkAverageDistance(average);
-  EXPECT_EQ(network_statistics.network_distance_data_.average_distance, average);
-
-  node_id = NodeId();
-  network_statistics.network_distance_data_.total_distance = crypto::BigInt::Zero();
-  network_statistics.network_distance_data_.average_distance = NodeId();
-  average = node_id;
-  network_statistics.UpdateNetworkAverageDistance(node_id);
-  EXPECT_EQ(network_statistics.network_distance_data_.average_distance, average);
-
-  node_id = NodeId(NodeId::kMaxId);
-  network_statistics.network_distance_data_.total_distance =
-      crypto::BigInt((node_id.ToStringEncoded(NodeId::EncodingType::kHex) + 'h').c_str()) *
-      network_statistics.network_distance_data_.contributors_count;
-  average = node_id;
-  network_statistics.UpdateNetworkAverageDistance(node_id);
-  EXPECT_EQ(network_statistics.network_distance_data_.average_distance, average);
-
-  network_statistics.network_distance_data_.contributors_count = 0;
-  network_statistics.network_distance_data_.total_distance = crypto::BigInt::Zero();
-
-  std::vector<NodeId> distances_as_node_id;
-  std::vector<crypto::BigInt> distances_as_bigint;
-  uint32_t kCount(RandomUint32() % 1000 + 9000);
-  for (uint32_t i(0); i < kCount; ++i) {
-    NodeId node_id(NodeId::kRandomId);
-    distances_as_node_id.push_back(node_id);
-    distances_as_bigint.push_back(
-        crypto::BigInt((node_id.ToStringEncoded(NodeId::EncodingType::kHex) + 'h').c_str()));
-  }
+namespace {
 
-  crypto::BigInt total(std::accumulate(distances_as_bigint.begin(), distances_as_bigint.end(),
-                                       crypto::BigInt::Zero()));
+// Returns a distance whose leading 64 bits are 'leading_bits', followed by random bits (which the
+// average ignores).
+NodeId MakeDistance(uint64_t leading_bits) {
+  std::string raw_distance(NodeId(NodeId::kRandomId).string());
+  for (int i(7); i >= 0; --i, leading_bits >>= 8)
+    raw_distance[i] = static_cast<char>(leading_bits & 0xff);
+  return NodeId(raw_distance);
+}
 
-  for (const auto& node_id : distances_as_node_id)
-    network_statistics.UpdateNetworkAverageDistance(node_id);
+uint64_t LeadingBits(const NodeId& distance) {
+  const std::string raw_distance(distance.string());
+  uint64_t leading_bits(0);
+  for (int i(0); i != 8; ++i)
+    leading_bits = (leading_bits << 8) | static_cast<unsigned char>(raw_distance[i]);
+  return leading_bits;
+}
 
-  crypto::BigInt matrix_average_as_bigint(
-      (network_statistics.network_distance_data_.average_distance.ToStringEncoded(
-           NodeId::EncodingType::kHex) +
-       'h').c_str());
+}  // unnamed namespace
 
-  EXPECT_EQ(total / kCount, matrix_average_as_bigint);
+TEST(NetworkStatisticsTest, BEH_AverageDistance) {
+  NetworkStatistics network_statistics((NodeId(NodeId::kRandomId)));
+  EXPECT_EQ(NodeId(), network_statistics.GetNetworkAverageDistance());
+  network_statistics.UpdateNetworkAverageDistance(NodeId());
+  EXPECT_EQ(NodeId(), network_statistics.GetNetworkAverageDistance());
+
+  // Only the leading bits are kept.
+  const uint64_t kFirst(RandomUint32());
+  network_statistics.UpdateNetworkAverageDistance(MakeDistance(kFirst));
+  std::string expected(NodeId::kSize, 0);
+  expected.replace(0, 8, MakeDistance(kFirst).string().substr(0, 8));
+  EXPECT_EQ(NodeId(expected), network_statistics.GetNetworkAverageDistance());
+
+  // Until the window is full, the average is the plain mean (less up to one per distance lost to
+  // integer division).
+  const uint32_t kWindow(Parameters::average_distance_window);
+  uint64_t total(kFirst);
+  for (uint32_t i(1); i < kWindow; ++i) {
+    uint64_t leading_bits(RandomUint32());
+    total += leading_bits;
+    network_statistics.UpdateNetworkAverageDistance(MakeDistance(leading_bits));
+  }
+  uint64_t average(LeadingBits(network_statistics.GetNetworkAverageDistance()));
+  uint64_t mean(total / kWindow);
+  EXPECT_LE(std::max(average, mean) - std::min(average, mean), kWindow);
+
+  // After that, the average follows a change in the distances reported.
+  const uint64_t kLater(std::numeric_limits<uint64_t>::max() / 2);
+  for (uint32_t i(0); i != 16 * kWindow; ++i)
+    network_statistics.UpdateNetworkAverageDistance(MakeDistance(kLater));
+  average = LeadingBits(network_statistics.GetNetworkAverageDistance());
+  EXPECT_LE(average, kLater);
+  EXPECT_GE(average, kLater - kLater / 1000);
 }
 
 TEST(NetworkStatisticsTest, BEH_IsIdInGroupRange) {
@@ -94,7 +102,6 @@ TEST(NetworkStatisticsTest, BEH_IsIdInGroupRange) {
   while (static_cast<uint16_t>(routing_table.size()) < Parameters::max_routing_table_size) {
     NodeInfo node(MakeNode());
     nodes_id.push_back(node.node_id);
-    routing_table.group_matrix_.unique_nodes_.push_back(node);
     EXPECT_TRUE(routing_table.AddNode(node));
   }
 
@@ -21,6 +21,8 @@
 #include <future>
 
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "boost/filesystem/exception.hpp"
@@ -36,6 +38,7 @@
 #include "maidsafe/routing/return_codes.h"
 #include "maidsafe/routing/routing_table.h"
 #include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/shared_buffer.h"
 #include "maidsafe/routing/tests/test_utils.h"
 
 namespace maidsafe {
@@ -57,8 +60,65 @@ void SortFromThisNode(const NodeId& from, std::vector<NodeInfoAndPrivateKey> nod
   });
 }
 
+// Keeps what would be sent to each peer rather than sending it.
+class SendCapturingNetworkUtils : public NetworkUtils {
+ public:
+  SendCapturingNetworkUtils(RoutingTable& routing_table, ClientRoutingTable& client_routing_table)
+      : NetworkUtils(routing_table, client_routing_table), sent_messages() {}
+  std::vector<std::pair<NodeId, std::string>> sent_messages;
+
+ private:
+  virtual void RudpSend(const NodeId& peer_id, const protobuf::Message& message,
+                        const rudp::MessageSentFunctor& /*message_sent_functor*/,
+                        const SharedBuffer& payload) {
+    std::string serialised_message(message.SerializeAsString());
+    serialised_message.append(payload.data(), payload.size());
+    sent_messages.push_back(std::make_pair(peer_id, serialised_message));
+  }
+};
+
 }  // anonymous namespace
 
+TEST(NetworkUtilsTest, BEH_SendToDirectToSeveralPeers) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  ClientRoutingTable client_routing_table(routing_table.kNodeId());
+  SendCapturingNetworkUtils network(routing_table, client_routing_table);
+
+  protobuf::Message message;
+  message.set_routing_message(false);
+  message.set_client_node(false);
+  message.set_request(true);
+  message.set_direct(true);
+  message.set_type(10);
+  message.set_hops_to_live(Parameters::hops_to_live);
+  message.set_source_id(node_id.string());
+  message.set_destination_id(NodeId(NodeId::kRandomId).string());
+  message.add_data("data");
+  message.add_data(RandomString(1024));
+  message.set_signature(RandomString(512));
+  const protobuf::Message kOriginal(message);
+
+  std::vector<NodeInfo> peers(3);
+  for (auto& peer : peers) {
+    peer.node_id = NodeId(NodeId::kRandomId);
+    peer.connection_id = NodeId(NodeId::kRandomId);
+  }
+  network.SendToDirect(message, peers);
+
+  // The caller's message, payload and signature included, is left as it was.
+  EXPECT_EQ(kOriginal.SerializeAsString(), message.SerializeAsString());
+  ASSERT_EQ(peers.size(), network.sent_messages.size());
+  for (size_t i(0); i != peers.size(); ++i) {
+    EXPECT_EQ(peers[i].connection_id, network.sent_messages[i].first);
+    protobuf::Message received_message, expected_message(kOriginal);
+    ASSERT_TRUE(received_message.ParseFromString(network.sent_messages[i].second));
+    expected_message.set_destination_id(peers[i].node_id.string());
+    EXPECT_EQ(expected_message.SerializeAsString(), received_message.SerializeAsString());
+  }
+}
+
 TEST(NetworkUtilsTest, BEH_ProcessSendDirectInvalidEndpoint) {
   protobuf::Message message;
   message.set_routing_message(true);
@@ -373,7 +373,7 @@ void GenericNode::PrintRoutingTable() {
              << (IsClient() ? " (Client)" : " (Vault) :")
              << "Routing table size: " << routing_->pimpl_->routing_table_.nodes_.size();
   {
-    std::lock_guard<std::mutex> lock(routing_->pimpl_->routing_table_.mutex_);
+    RoutingTable::SharedLock lock(routing_->pimpl_->routing_table_.mutex_);
     for (const auto& node_info : routing_->pimpl_->routing_table_.nodes_) {
       LOG(kInfo) << "\tNodeId : " << HexSubstr(node_info.node_id.string());
     }
@@ -388,13 +388,15 @@ void GenericNode::PrintRoutingTable() {
 
 std::vector<NodeId> GenericNode::ReturnRoutingTable() {
   std::vector<NodeId> routing_nodes;
-  std::lock_guard<std::mutex> lock(routing_->pimpl_->routing_table_.mutex_);
+  RoutingTable::SharedLock lock(routing_->pimpl_->routing_table_.mutex_);
   for (const auto& node_info : routing_->pimpl_->routing_table_.nodes_)
     routing_nodes.push_back(node_info.node_id);
   return routing_nodes;
 }
 
-void GenericNode::PrintGroupMatrix() { routing_->pimpl_->routing_table_.PrintGroupMatrix(); }
+void GenericNode::PrintGroupMatrix() {
+  LOG(kVerbose) << routing_->pimpl_->routing_table_.PrintGroupMatrix();
+}
 
 std::string GenericNode::SerializeRoutingTable() {
   std::vector<NodeId> node_list;
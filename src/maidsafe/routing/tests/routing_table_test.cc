@@ -16,6 +16,7 @@
     See the Licences for the specific language governing permissions and limitations relating to
     use of the MaidSafe Software.                                                                 */
 
+#include <algorithm>
 #include <bitset>
 #include <memory>
 #include <vector>
@@ -772,6 +773,276 @@ TEST(RoutingTableTest, BEH_GetNthClosest) {
   }
 }
 
+TEST(RoutingTableTest, BEH_ClosestLookupLeavesTableUnchanged) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  std::vector<NodeId> nodes_id;
+  while (routing_table.size() < Parameters::max_routing_table_size) {
+    NodeInfo node(MakeNode());
+    if (routing_table.AddNode(node))
+      nodes_id.push_back(node.node_id);
+  }
+  std::vector<NodeId> table_order(routing_table.nodes_.size());
+  std::transform(routing_table.nodes_.begin(), routing_table.nodes_.end(), table_order.begin(),
+                 [](const NodeInfo & node_info) { return node_info.node_id; });
+  EXPECT_TRUE(std::is_sorted(table_order.begin(), table_order.end()));
+
+  for (int i(0); i != 20; ++i) {
+    NodeId target(i % 2 == 0 ? NodeId(NodeId::kRandomId) :
+                               nodes_id.at(RandomUint32() % nodes_id.size()));
+    uint16_t count(static_cast<uint16_t>(RandomUint32() % (nodes_id.size() + 2)));
+    SortIdsFromTarget(target, nodes_id);
+    std::vector<NodeId> expected(nodes_id.begin(),
+                                 nodes_id.begin() + std::min(nodes_id.size(),
+                                                             static_cast<size_t>(count)));
+    EXPECT_EQ(expected, routing_table.GetClosestNodes(target, count));
+    EXPECT_EQ(nodes_id.front(), routing_table.GetClosestNode(target).node_id);
+    if (count != 0 && count <= nodes_id.size()) {
+      EXPECT_EQ(nodes_id.at(count - 1), routing_table.GetNthClosestNode(target, count).node_id);
+    }
+  }
+
+  for (size_t index(0); index != table_order.size(); ++index)
+    EXPECT_EQ(table_order.at(index), routing_table.nodes_.at(index).node_id);
+}
+
+TEST(RoutingTableTest, BEH_SnapshotUnaffectedByLaterChanges) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  auto empty_snapshot(routing_table.Snapshot());
+  EXPECT_EQ(0, empty_snapshot->size());
+
+  NodeInfo node(MakeNode());
+  EXPECT_TRUE(routing_table.AddNode(node));
+  auto snapshot(routing_table.Snapshot());
+  EXPECT_LT(empty_snapshot->version(), snapshot->version());
+  EXPECT_EQ(0, empty_snapshot->size());
+  EXPECT_FALSE(empty_snapshot->Contains(node.node_id));
+  EXPECT_TRUE(snapshot->Contains(node.node_id));
+
+  EXPECT_EQ(node.node_id, routing_table.DropNode(node.node_id, true).node_id);
+  EXPECT_FALSE(routing_table.Contains(node.node_id));
+  EXPECT_LT(snapshot->version(), routing_table.Snapshot()->version());
+  EXPECT_TRUE(snapshot->Contains(node.node_id));
+  EXPECT_EQ(node.node_id, snapshot->GetClosestNode(node.node_id).node_id);
+}
+
+TEST(RoutingTableTest, BEH_CloseBoundariesFollowChanges) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  auto check_boundaries([&]() {
+    EXPECT_EQ(routing_table.GetNthClosestNode(node_id, Parameters::closest_nodes_size).node_id,
+              routing_table.FurthestCloseNode());
+    EXPECT_EQ(routing_table.GetNthClosestNode(node_id, 2 * Parameters::closest_nodes_size).node_id,
+              routing_table.FurthestClientCloseNode());
+  });
+  check_boundaries();
+  EXPECT_EQ(NodeId(NodeId::kMaxId) ^ node_id, routing_table.FurthestCloseNode());
+
+  std::vector<NodeId> added;
+  while (routing_table.size() < Parameters::max_routing_table_size) {
+    NodeInfo node(MakeNode());
+    if (routing_table.AddNode(node))
+      added.push_back(node.node_id);
+    check_boundaries();
+  }
+  SortIdsFromTarget(node_id, added);
+  for (const auto& close_node : added) {
+    routing_table.DropNode(close_node, true);
+    check_boundaries();
+    if (routing_table.size() < Parameters::closest_nodes_size)
+      break;
+  }
+  EXPECT_EQ(NodeId(NodeId::kMaxId) ^ node_id, routing_table.FurthestCloseNode());
+}
+
+TEST(RoutingTableTest, BEH_RouteMatchesSeparateQueries) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  std::vector<NodeId> added;
+  auto check_routes([&]() {
+    auto snapshot(routing_table.Snapshot());
+    std::vector<NodeId> destinations(added);
+    destinations.push_back(NodeId(NodeId::kRandomId));
+    destinations.push_back(node_id ^ NodeId(NodeId::kRandomId));
+    for (const auto& destination : destinations) {
+      for (int ignore_exact_match(0); ignore_exact_match != 2; ++ignore_exact_match) {
+        RouteDecision route(RoutingTableSnapshot::Route(snapshot, destination,
+                                                        ignore_exact_match != 0));
+        EXPECT_EQ(snapshot->Contains(destination), route.destination_in_table);
+        EXPECT_EQ(snapshot->IsThisNodeInRange(destination, Parameters::group_size),
+                  route.this_node_in_group_range);
+        EXPECT_EQ(snapshot->IsThisNodeInRange(destination, Parameters::closest_nodes_size),
+                  route.this_node_in_close_range);
+        EXPECT_EQ(snapshot->IsThisNodeClosestTo(destination, ignore_exact_match != 0),
+                  route.this_node_closest);
+        EXPECT_EQ(snapshot->IsThisNodeClosestToIncludingMatrix(destination,
+                                                               ignore_exact_match != 0),
+                  snapshot->IsThisNodeClosestToIncludingMatrix(route));
+        std::vector<std::string> exclude;
+        if (!route.closest_nodes.empty())
+          exclude.push_back(route.closest_nodes.front().node_id.string());
+        EXPECT_EQ(snapshot->GetNodeForSendingMessage(destination, exclude,
+                                                     ignore_exact_match != 0).node_id,
+                  snapshot->GetNodeForSendingMessage(route, exclude).node_id);
+      }
+    }
+  });
+
+  check_routes();
+  while (routing_table.size() < Parameters::max_routing_table_size) {
+    NodeInfo node(MakeNode());
+    if (routing_table.AddNode(node))
+      added.push_back(node.node_id);
+    if (added.size() % 8 == 1)
+      check_routes();
+  }
+  check_routes();
+}
+
+TEST(RoutingTableTest, BEH_PrintRoutingTable) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  EXPECT_NE(std::string::npos, routing_table.PrintRoutingTable().find("Routing table size: 0\n"));
+
+  std::vector<NodeId> added;
+  for (uint16_t i(0); i != Parameters::closest_nodes_size; ++i) {
+    NodeInfo node(MakeNode());
+    if (routing_table.AddNode(node))
+      added.push_back(node.node_id);
+  }
+  std::string dump(routing_table.PrintRoutingTable());
+  EXPECT_NE(std::string::npos,
+            dump.find("Routing table size: " + std::to_string(added.size()) + "\n"));
+  // Peers are listed closest first.
+  SortIdsFromTarget(node_id, added);
+  size_t previous_position(0);
+  for (const auto& peer : added) {
+    size_t position(dump.find("Peer [" + DebugId(peer) + "]"));
+    ASSERT_NE(std::string::npos, position);
+    EXPECT_LT(previous_position, position);
+    previous_position = position;
+  }
+  EXPECT_NE(std::string::npos, routing_table.PrintGroupMatrix().find(DebugId(node_id)));
+}
+
+TEST(RoutingTableTest, BEH_DuplicatePublicKey) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  std::vector<NodeInfo> nodes;
+  for (uint16_t i(0); i != Parameters::closest_nodes_size; ++i) {
+    nodes.push_back(MakeNode());
+    EXPECT_TRUE(routing_table.AddNode(nodes.back()));
+  }
+
+  NodeInfo duplicate(MakeNode());
+  duplicate.public_key = nodes.front().public_key;
+  EXPECT_FALSE(routing_table.AddNode(duplicate));
+  EXPECT_FALSE(routing_table.Contains(duplicate.node_id));
+
+  // Once the node holding the key has gone, the key can be used again.
+  routing_table.DropNode(nodes.front().node_id, true);
+  EXPECT_TRUE(routing_table.AddNode(duplicate));
+  duplicate.node_id = NodeId(NodeId::kRandomId);
+  EXPECT_FALSE(routing_table.AddNode(duplicate));
+}
+
+TEST(RoutingTableTest, BEH_SetBucketIndex) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  NodeInfo node;
+  node.node_id = node_id;
+  routing_table.SetBucketIndex(node);
+  EXPECT_EQ(0, node.bucket);
+
+  // Differing first at bit 'i' (most significant first) puts a node in bucket 511 - i.
+  const std::string raw_id(node_id.string());
+  for (int i(0); i != NodeId::kSize * 8; ++i) {
+    std::string peer_raw_id(raw_id);
+    peer_raw_id[i / 8] = static_cast<char>(peer_raw_id[i / 8] ^ (0x80 >> (i % 8)));
+    for (int j(i / 8 + 1); j < NodeId::kSize; ++j)
+      peer_raw_id[j] = static_cast<char>(RandomUint32());
+    node.node_id = NodeId(peer_raw_id);
+    routing_table.SetBucketIndex(node);
+    EXPECT_EQ(NodeId::kSize * 8 - 1 - i, node.bucket);
+  }
+}
+
+TEST(RoutingTableTest, FUNC_BucketCountsFollowChanges) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  auto check_buckets([&routing_table]() {
+    for (int32_t bucket(0); bucket != NodeId::kSize * 8; ++bucket) {
+      auto range(routing_table.BucketRange(bucket));
+      auto range_size(range.second - range.first);
+      EXPECT_EQ(routing_table.bucket_counts_[bucket], static_cast<size_t>(range_size));
+      EXPECT_EQ(std::count_if(routing_table.nodes_.begin(), routing_table.nodes_.end(),
+                              [bucket](const NodeInfo & node_info) {
+                  return node_info.bucket == bucket;
+                }),
+                range_size);
+      for (auto itr(range.first); itr != range.second; ++itr)
+        EXPECT_EQ(bucket, itr->bucket);
+    }
+  });
+
+  // Biased ids fill the near buckets, so adding more nodes to a full table evicts some.
+  for (int i(0); i != 2 * Parameters::max_routing_table_size; ++i) {
+    NodeInfo node(MakeNode());
+    if (i % 2 == 0)
+      node.node_id = GenerateUniqueRandomId(node_id, 500 - (i % 16));
+    routing_table.AddNode(node);
+  }
+  EXPECT_EQ(Parameters::max_routing_table_size, routing_table.size());
+  check_buckets();
+
+  for (int i(0); i != Parameters::max_routing_table_size / 2; ++i)
+    routing_table.DropNode(routing_table.nodes_.at(RandomUint32() % routing_table.size()).node_id,
+                           true);
+  check_buckets();
+
+  NodeInfo removable(routing_table.GetRemovableNode());
+  EXPECT_TRUE(routing_table.Contains(removable.node_id));
+}
+
+TEST(RoutingTableTest, BEH_CheckNodes) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  NodeInfo node(MakeNode());
+  EXPECT_TRUE(routing_table.AddNode(node));
+
+  std::vector<NodeId> candidates(1, node.node_id), expected;
+  candidates.push_back(node_id);
+  candidates.push_back(NodeId());
+  for (int i(0); i != 4; ++i) {
+    candidates.push_back(NodeId(NodeId::kRandomId));
+    expected.push_back(candidates.back());
+  }
+  EXPECT_EQ(expected, routing_table.CheckNodes(candidates));
+
+  while (routing_table.size() < Parameters::max_routing_table_size) {
+    NodeInfo extra_node(MakeNode());
+    routing_table.AddNode(extra_node);
+  }
+  candidates.clear();
+  for (int i(0); i != 20; ++i)
+    candidates.push_back(NodeId(NodeId::kRandomId));
+  for (const auto& accepted : routing_table.CheckNodes(candidates)) {
+    NodeInfo peer;
+    peer.node_id = accepted;
+    EXPECT_TRUE(routing_table.CheckNode(peer));
+  }
+}
+
 TEST(RoutingTableTest, FUNC_GetClosestNodeWithExclusion) {
   NodeId node_id(NodeId::kRandomId);
   NetworkStatistics network_statistics(node_id);
@@ -1225,6 +1496,50 @@ TEST(RoutingTableTest, BEH_MatrixChange) {
   EXPECT_EQ(count, Parameters::closest_nodes_size + 2);
 }
 
+TEST(RoutingTableTest, BEH_AddNodes) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  int matrix_change_count(0), group_change_count(0);
+  routing_table.InitialiseFunctors([](int) {}, [](const NodeInfo&, bool) {}, []() {},  // NOLINT
+                                   [&group_change_count](const std::vector<NodeInfo>&,
+                                                         const std::vector<NodeInfo>&) {
+                                     ++group_change_count;
+                                   },
+                                   [&matrix_change_count](std::shared_ptr<MatrixChange>) {
+                                     ++matrix_change_count;
+                                   });
+  std::vector<NodeInfo> peers;
+  for (uint16_t i(0); i != Parameters::closest_nodes_size * 2; ++i)
+    peers.push_back(MakeNode());
+  peers.push_back(peers.front());  // Duplicates are only added once
+  NodeInfo invalid(MakeNode());
+  invalid.node_id = node_id;
+  peers.push_back(invalid);
+
+  auto added(routing_table.AddNodes(peers));
+  EXPECT_EQ(Parameters::closest_nodes_size * 2U, added.size());
+  EXPECT_EQ(added.size(), routing_table.size());
+  for (const auto& peer : added)
+    EXPECT_TRUE(routing_table.Contains(peer.node_id));
+  EXPECT_EQ(1, matrix_change_count);
+  EXPECT_EQ(1, group_change_count);
+
+  // The nodes closest once the whole batch is in are the connected peers.
+  std::vector<NodeId> closest(
+      routing_table.GetClosestNodes(node_id, Parameters::closest_nodes_size));
+  std::vector<NodeInfo> connected_peers(
+      routing_table.Snapshot()->group_matrix().GetConnectedPeers());
+  ASSERT_EQ(closest.size(), connected_peers.size());
+  for (size_t i(0); i != closest.size(); ++i)
+    EXPECT_EQ(closest[i], connected_peers[i].node_id);
+
+  // Nothing left to add, so no further notifications.
+  EXPECT_TRUE(routing_table.AddNodes(peers).empty());
+  EXPECT_EQ(1, matrix_change_count);
+  EXPECT_EQ(1, group_change_count);
+}
+
 TEST(RoutingTableTest, FUNC_ClosestToId) {
   NodeId own_node_id(NodeId::kRandomId);
   NetworkStatistics network_statistics(own_node_id);
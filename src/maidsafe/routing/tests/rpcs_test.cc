@@ -193,6 +193,40 @@ TEST(RpcsTest, BEH_FindNodesMessageNodeRelayMode) {
   ASSERT_FALSE(node.IsZero());
 }
 
+TEST(RpcsTest, BEH_ClosestNodesUpdateDeltaMessageNode) {
+  NodeInfo us(MakeNode()), them(MakeNode());
+  std::vector<NodeInfo> added_nodes(1, MakeNode());
+  added_nodes.front().rank = 3;
+  std::vector<NodeId> removed_nodes(2, NodeId(NodeId::kRandomId));
+  protobuf::Message message =
+      rpcs::ClosestNodesUpdateDelta(them.node_id, us.node_id, added_nodes, removed_nodes, 7);
+  ASSERT_TRUE(message.IsInitialized());
+  protobuf::ClosestNodesUpdate closest_nodes_update;
+  EXPECT_TRUE(closest_nodes_update.ParseFromString(message.data(0)));
+  EXPECT_EQ(us.node_id.string(), closest_nodes_update.node());
+  EXPECT_TRUE(closest_nodes_update.delta());
+  EXPECT_FALSE(closest_nodes_update.resend_requested());
+  EXPECT_EQ(7U, closest_nodes_update.sequence());
+  ASSERT_EQ(1, closest_nodes_update.nodes_info_size());
+  EXPECT_EQ(added_nodes.front().node_id.string(), closest_nodes_update.nodes_info(0).node_id());
+  EXPECT_EQ(3, closest_nodes_update.nodes_info(0).rank());
+  ASSERT_EQ(2, closest_nodes_update.removed_nodes_size());
+  EXPECT_EQ(removed_nodes.front().string(), closest_nodes_update.removed_nodes(0));
+  EXPECT_EQ(them.node_id.string(), message.destination_id());
+  EXPECT_EQ(us.node_id.string(), message.source_id());
+  EXPECT_TRUE(message.direct());
+  EXPECT_EQ(static_cast<int32_t>(MessageType::kClosestNodesUpdate), message.type());
+  EXPECT_TRUE(message.request());
+
+  message = rpcs::ClosestNodesUpdateResendRequest(them.node_id, us.node_id);
+  ASSERT_TRUE(message.IsInitialized());
+  EXPECT_TRUE(closest_nodes_update.ParseFromString(message.data(0)));
+  EXPECT_EQ(us.node_id.string(), closest_nodes_update.node());
+  EXPECT_TRUE(closest_nodes_update.resend_requested());
+  EXPECT_FALSE(closest_nodes_update.delta());
+  EXPECT_EQ(0, closest_nodes_update.nodes_info_size());
+}
+
 }  // namespace test
 
 }  // namespace routing
@@ -0,0 +1,112 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <limits>
+#include <string>
+
+#include "maidsafe/common/test.h"
+
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/trace.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+namespace {
+
+std::string Evaluated(int& count) {
+  ++count;
+  return "evaluated";
+}
+
+}  // unnamed namespace
+
+TEST(TraceTest, BEH_ArgumentsOnlyEvaluatedIfEnabled) {
+  const int kTraceLevel(Parameters::trace_level), kLogFilterLevel(LogFilterLevel());
+  int count(0);
+
+  // Let everything through the logging filter, leaving trace_level to decide.
+  detail::log_filter_level = kVerbose;
+
+  Parameters::trace_level = kWarning;
+  EXPECT_FALSE(TraceEnabled(kVerbose));
+  EXPECT_FALSE(TraceEnabled(kInfo));
+  EXPECT_TRUE(TraceEnabled(kWarning));
+  TRACE(kVerbose) << Evaluated(count);
+  TRACE(kInfo) << Evaluated(count) << Evaluated(count);
+  EXPECT_EQ(0, count);
+  TRACE(kError) << Evaluated(count);
+  EXPECT_EQ(1, count);
+
+  // Usable as the body of an unbraced if.
+  if (count == 1)
+    TRACE(kError) << Evaluated(count);
+  else
+    ++count;
+  EXPECT_EQ(2, count);
+
+  Parameters::trace_level = kVerbose;
+  TRACE(kVerbose) << Evaluated(count);
+#ifdef ROUTING_STRIP_VERBOSE_TRACE
+  EXPECT_FALSE(TraceEnabled(kVerbose));
+  EXPECT_EQ(2, count);
+#else
+  EXPECT_TRUE(TraceEnabled(kVerbose));
+  EXPECT_EQ(3, count);
+#endif
+
+  Parameters::trace_level = kTraceLevel;
+  detail::log_filter_level = kLogFilterLevel;
+}
+
+TEST(TraceTest, BEH_ArgumentsNotEvaluatedIfFilteredOut) {
+  // By default the logging filter alone decides what is traced.
+  EXPECT_EQ(kVerbose, Parameters::trace_level);
+  const int kLogFilterLevel(LogFilterLevel());
+  int count(0);
+
+  detail::log_filter_level = kWarning;
+  EXPECT_FALSE(TraceEnabled(kVerbose));
+  EXPECT_FALSE(TraceEnabled(kInfo));
+  EXPECT_TRUE(TraceEnabled(kWarning));
+  TRACE(kVerbose) << Evaluated(count);
+  TRACE(kInfo) << Evaluated(count);
+  EXPECT_EQ(0, count);
+  TRACE(kError) << Evaluated(count);
+  EXPECT_EQ(1, count);
+
+  // Nothing is traced if the filter lets nothing through for this project.
+  detail::log_filter_level = std::numeric_limits<int>::max();
+  EXPECT_FALSE(TraceEnabled(kAlways));
+  TRACE(kAlways) << Evaluated(count);
+  EXPECT_EQ(1, count);
+
+  // Refreshing reads the level back from the filter.
+  detail::log_filter_level = kLogFilterLevel;
+  RefreshLogFilterLevel();
+  EXPECT_EQ(detail::ReadLogFilterLevel(), LogFilterLevel());
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,140 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/distance_sort.h"
+#include "maidsafe/routing/uint512.h"
+#include "maidsafe/routing/tests/test_utils.h"
+
+namespace maidsafe {
+namespace routing {
+namespace test {
+
+TEST(Uint512Test, BEH_RoundTripAndOrdering) {
+  EXPECT_EQ(NodeId(), Uint512().ToNodeId());
+  EXPECT_EQ(Uint512(), Uint512(NodeId()));
+  EXPECT_EQ(NodeId(NodeId::kMaxId), Uint512(NodeId(NodeId::kMaxId)).ToNodeId());
+
+  for (int i(0); i != 100; ++i) {
+    NodeId lhs(NodeId::kRandomId), rhs(NodeId::kRandomId), target(NodeId::kRandomId);
+    EXPECT_EQ(lhs, Uint512(lhs).ToNodeId());
+    EXPECT_EQ(lhs < rhs, Uint512(lhs) < Uint512(rhs));
+    EXPECT_EQ(lhs ^ rhs, (Uint512(lhs) ^ Uint512(rhs)).ToNodeId());
+    EXPECT_EQ(NodeId::CloserToTarget(lhs, rhs, target),
+              (Uint512(lhs) ^ Uint512(target)) < (Uint512(rhs) ^ Uint512(target)));
+  }
+}
+
+TEST(Uint512Test, BEH_CountLeadingZeros) {
+  EXPECT_TRUE(Uint512().IsZero());
+  EXPECT_EQ(NodeId::kSize * 8, Uint512().CountLeadingZeros());
+  EXPECT_EQ(0, Uint512(NodeId(NodeId::kMaxId)).CountLeadingZeros());
+  for (int bit(0); bit != NodeId::kSize * 8; ++bit) {
+    std::string raw_id(NodeId::kSize, '\0');
+    raw_id[bit / 8] = static_cast<char>(0x80 >> (bit % 8));
+    Uint512 value((NodeId(raw_id)));
+    EXPECT_FALSE(value.IsZero());
+    EXPECT_EQ(bit, value.CountLeadingZeros());
+  }
+}
+
+TEST(Uint512Test, BEH_Arithmetic) {
+  auto small([](unsigned char value)->Uint512 {
+    std::string raw_id(NodeId::kSize, '\0');
+    raw_id.back() = static_cast<char>(value);
+    return Uint512(NodeId(raw_id));
+  });
+  Uint512 value(small(200));
+  EXPECT_EQ(0U, value.Add(small(55)));
+  EXPECT_EQ(small(255), value);
+  EXPECT_EQ(0U, value.MultiplyBy(1));
+  EXPECT_EQ(small(255), value);
+  EXPECT_EQ(3U, value.DivideBy(4));
+  EXPECT_EQ(small(63), value);
+  EXPECT_EQ(small(189), MultiplySaturating(value, 3));
+
+  Uint512 max(Uint512::Max());
+  EXPECT_EQ(NodeId(NodeId::kMaxId), max.ToNodeId());
+  EXPECT_EQ(1U, max.Add(small(1)));
+  EXPECT_TRUE(max.IsZero());
+  EXPECT_EQ(Uint512::Max(), MultiplySaturating(Uint512::Max(), 2));
+
+  for (int i(0); i != 100; ++i) {
+    const Uint512 original((NodeId(NodeId::kRandomId)));
+    const uint32_t factor(RandomUint32() % 1000 + 1);
+    // Multiplying then dividing (including the carried-out high word) restores the value.
+    Uint512 product(original);
+    uint32_t high_word(product.MultiplyBy(factor));
+    EXPECT_EQ(0U, product.DivideBy(factor, high_word));
+    EXPECT_EQ(original, product);
+    // Adding a value to itself doubles it.
+    Uint512 sum(original), doubled(original);
+    EXPECT_EQ(doubled.MultiplyBy(2), sum.Add(original));
+    EXPECT_EQ(doubled, sum);
+  }
+}
+
+TEST(Uint512Test, BEH_SortByDistance) {
+  const NodeId target(NodeId::kRandomId);
+  auto closer([&target](const NodeId & lhs, const NodeId & rhs) {
+    return NodeId::CloserToTarget(lhs, rhs, target);
+  });
+  std::vector<NodeId> node_ids;
+  for (int i(0); i != 50; ++i)
+    node_ids.push_back(GenerateUniqueRandomId(target, 500 - 10 * i));
+  node_ids.push_back(target);
+  std::random_shuffle(node_ids.begin(), node_ids.end());
+  std::vector<NodeId> expected(node_ids);
+  std::sort(expected.begin(), expected.end(), closer);
+
+  std::vector<NodeId> sorted(node_ids);
+  SortByDistance(sorted.begin(), sorted.end(), target);
+  EXPECT_EQ(expected, sorted);
+
+  std::vector<NodeId> partially_sorted(node_ids);
+  PartialSortByDistance(partially_sorted.begin(), partially_sorted.begin() + 8,
+                        partially_sorted.end(), target);
+  EXPECT_TRUE(std::equal(expected.begin(), expected.begin() + 8, partially_sorted.begin()));
+  std::sort(partially_sorted.begin() + 8, partially_sorted.end(), closer);
+  EXPECT_EQ(expected, partially_sorted);
+
+  std::vector<NodeId> closest(4);
+  EXPECT_EQ(closest.end(), PartialSortCopyByDistance(node_ids.begin(), node_ids.end(),
+                                                     closest.begin(), closest.end(), target));
+  EXPECT_TRUE(std::equal(closest.begin(), closest.end(), expected.begin()));
+
+  std::vector<NodeInfo> nodes_info(4);
+  for (size_t i(0); i != nodes_info.size(); ++i)
+    nodes_info[i].node_id = node_ids[i];
+  SortByDistance(nodes_info.begin(), nodes_info.end(), target);
+  EXPECT_TRUE(std::is_sorted(nodes_info.begin(), nodes_info.end(),
+                             [&closer](const NodeInfo & lhs, const NodeInfo & rhs) {
+    return closer(lhs.node_id, rhs.node_id);
+  }));
+}
+
+}  // namespace test
+}  // namespace routing
+}  // namespace maidsafe
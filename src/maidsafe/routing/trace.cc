@@ -0,0 +1,48 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/trace.h"
+
+#include <limits>
+#include <string>
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace detail {
+
+std::atomic<int> log_filter_level(kLogFilterLevelUnread);
+
+int ReadLogFilterLevel() {
+  const log::FilterMap filter(log::Logging::Instance().Filter());
+  auto itr(filter.find("routing"));
+  if (itr == filter.end())
+    itr = filter.find("*");
+  return itr == filter.end() ? std::numeric_limits<int>::max() : itr->second;
+}
+
+}  // namespace detail
+
+void RefreshLogFilterLevel() {
+  detail::log_filter_level.store(detail::ReadLogFilterLevel(), std::memory_order_relaxed);
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
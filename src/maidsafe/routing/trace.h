@@ -0,0 +1,97 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_TRACE_H_
+#define MAIDSAFE_ROUTING_TRACE_H_
+
+#include <atomic>
+
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/routing/parameters.h"
+
+namespace maidsafe {
+
+namespace routing {
+
+// Building with ROUTING_STRIP_VERBOSE_TRACE defined compiles kVerbose and kInfo traces out.
+#ifdef ROUTING_STRIP_VERBOSE_TRACE
+const int kLowestTraceLevel(kSuccess);
+#else
+const int kLowestTraceLevel(kVerbose);
+#endif
+
+namespace detail {
+
+// Not yet read from the maidsafe::log filter.
+const int kLogFilterLevelUnread(kVerbose - 1);
+
+// The lowest level the maidsafe::log filter lets through for this project, cached so that
+// checking it costs no more than an atomic load.
+extern std::atomic<int> log_filter_level;
+
+// Reads the level from the maidsafe::log filter: the "routing" entry, else the "*" one.  If there
+// is neither, nothing is logged and the level returned is above every log level.
+int ReadLogFilterLevel();
+
+}  // namespace detail
+
+// Re-reads the maidsafe::log filter.  It is read when first needed and again whenever a Routing
+// object is constructed; call this after changing the filter at any other time.
+void RefreshLogFilterLevel();
+
+inline int LogFilterLevel() {
+  int level(detail::log_filter_level.load(std::memory_order_relaxed));
+  if (level == detail::kLogFilterLevelUnread) {
+    RefreshLogFilterLevel();
+    level = detail::log_filter_level.load(std::memory_order_relaxed);
+  }
+  return level;
+}
+
+// Whether TRACE(level) statements run: only if the level isn't compiled out, isn't below
+// Parameters::trace_level and would be let through by the logging filter.  For use where a trace
+// needs work done before it is logged.
+inline bool TraceEnabled(int level) {
+  return level >= kLowestTraceLevel && level >= Parameters::trace_level &&
+         level >= LogFilterLevel();
+}
+
+namespace detail {
+
+// Lets the streamed TRACE expression be one branch of a conditional.
+struct TraceVoidify {
+  template <typename Stream>
+  void operator&(const Stream&) const {}
+};
+
+}  // namespace detail
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+// Used as LOG is, for logging on the per-message paths.  Unlike LOG's, the streamed arguments
+// (DebugId, HexSubstr and the like, each of which builds a string) are only evaluated if
+// TraceEnabled(level).  A trace compiled out by ROUTING_STRIP_VERBOSE_TRACE costs nothing at all.
+#define TRACE(level)                      \
+  !maidsafe::routing::TraceEnabled(level) \
+      ? static_cast<void>(0)              \
+      : maidsafe::routing::detail::TraceVoidify() & LOG(level)
+
+#endif  // MAIDSAFE_ROUTING_TRACE_H_
@@ -0,0 +1,125 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/uint512.h"
+
+#include <cassert>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace {
+
+// 'word' must be non-zero.
+int LeadingZeros(uint64_t word) {
+#if defined(__GNUC__)
+  return __builtin_clzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index(0);  // NOLINT
+  _BitScanReverse64(&index, word);
+  return 63 - static_cast<int>(index);
+#else
+  int count(0);
+  while ((word & (uint64_t(1) << 63)) == 0) {
+    word <<= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+
+}  // unnamed namespace
+
+bool Uint512::IsZero() const {
+  for (const auto& word : words_) {
+    if (word != 0)
+      return false;
+  }
+  return true;
+}
+
+int Uint512::CountLeadingZeros() const {
+  for (size_t i(0); i != kWordCount; ++i) {
+    if (words_[i] != 0)
+      return static_cast<int>(i * 64) + LeadingZeros(words_[i]);
+  }
+  return static_cast<int>(kWordCount * 64);
+}
+
+uint32_t Uint512::Add(const Uint512& other) {
+  uint64_t carry(0);
+  for (size_t i(kWordCount); i-- != 0;) {
+    uint64_t sum(words_[i] + other.words_[i]);
+    uint64_t carry_out(sum < words_[i] ? 1 : 0);
+    sum += carry;
+    if (sum < carry)
+      ++carry_out;
+    words_[i] = sum;
+    carry = carry_out;
+  }
+  return static_cast<uint32_t>(carry);
+}
+
+// Multiplication and division work on 32-bit halves of each word so that every intermediate result
+// fits in 64 bits.
+uint32_t Uint512::MultiplyBy(uint32_t factor) {
+  uint64_t carry(0);
+  for (size_t i(kWordCount); i-- != 0;) {
+    uint64_t low((words_[i] & 0xffffffff) * factor + carry);
+    uint64_t high((words_[i] >> 32) * factor + (low >> 32));
+    words_[i] = (high << 32) | (low & 0xffffffff);
+    carry = high >> 32;
+  }
+  return static_cast<uint32_t>(carry);
+}
+
+uint32_t Uint512::DivideBy(uint32_t divisor, uint32_t high_word) {
+  assert(divisor != 0 && high_word < divisor);
+  uint64_t remainder(high_word);
+  for (size_t i(0); i != kWordCount; ++i) {
+    uint64_t high((remainder << 32) | (words_[i] >> 32));
+    uint64_t high_quotient(high / divisor);
+    remainder = high % divisor;
+    uint64_t low((remainder << 32) | (words_[i] & 0xffffffff));
+    words_[i] = (high_quotient << 32) | (low / divisor);
+    remainder = low % divisor;
+  }
+  return static_cast<uint32_t>(remainder);
+}
+
+NodeId Uint512::ToNodeId() const {
+  std::string raw_id(NodeId::kSize, '\0');
+  for (size_t word_index(0), byte_index(0); word_index != kWordCount; ++word_index) {
+    for (int shift(56); shift >= 0; shift -= 8, ++byte_index)
+      raw_id[byte_index] = static_cast<char>((words_[word_index] >> shift) & 0xff);
+  }
+  return NodeId(raw_id);
+}
+
+Uint512 MultiplySaturating(Uint512 value, uint32_t factor) {
+  return (value.MultiplyBy(factor) == 0) ? value : Uint512::Max();
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -34,6 +34,7 @@
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/routing_table.h"
 #include "maidsafe/routing/rpcs.h"
+#include "maidsafe/routing/trace.h"
 
 namespace maidsafe {
 
@@ -76,9 +77,7 @@ bool ValidateAndAddToRoutingTable(NetworkUtils& network, RoutingTable& routing_t
   peer.connection_id = connection_id;
   bool routing_accepted_node(false);
   if (client) {
-    NodeId furthest_close_node_id =
-        routing_table.GetNthClosestNode(NodeId(routing_table.kNodeId()),
-                                        2 * Parameters::closest_nodes_size).node_id;
+    NodeId furthest_close_node_id(routing_table.FurthestClientCloseNode());
 
     if (client_routing_table.AddNode(peer, furthest_close_node_id))
       routing_accepted_node = true;
@@ -102,6 +101,44 @@ bool ValidateAndAddToRoutingTable(NetworkUtils& network, RoutingTable& routing_t
   return false;
 }
 
+std::vector<NodeInfo> ValidateAndAddToRoutingTable(
+    NetworkUtils& network, RoutingTable& routing_table, const std::vector<NodeInfo>& peers,
+    const std::vector<std::vector<NodeInfo>>& matrix_updates) {
+  assert(peers.size() == matrix_updates.size());
+  std::vector<NodeInfo> valid_peers;
+  std::vector<std::vector<NodeInfo>> valid_matrix_updates;
+  for (size_t i(0); i != peers.size(); ++i) {
+    if (network.MarkConnectionAsValid(peers[i].connection_id) != kSuccess) {
+      LOG(kError) << "[" << DebugId(routing_table.kNodeId()) << "] "
+                  << ". Rudp failed to validate connection with  Peer id : "
+                  << DebugId(peers[i].node_id)
+                  << " , Connection id : " << DebugId(peers[i].connection_id);
+      continue;
+    }
+    valid_peers.push_back(peers[i]);
+    valid_matrix_updates.push_back(matrix_updates[i]);
+  }
+  if (valid_peers.empty())
+    return valid_peers;
+
+  std::vector<NodeInfo> added(routing_table.AddNodes(valid_peers, valid_matrix_updates));
+  for (const auto& peer : valid_peers) {
+    if (std::any_of(added.begin(), added.end(), [&peer](const NodeInfo& node_info) {
+          return node_info.node_id == peer.node_id;
+        })) {
+      LOG(kVerbose) << "[" << DebugId(routing_table.kNodeId()) << "] "
+                    << "added node to routing table.  Node ID: "
+                    << HexSubstr(peer.node_id.string());
+      continue;
+    }
+    LOG(kInfo) << "[" << DebugId(routing_table.kNodeId()) << "] "
+               << "failed to add node to routing table.  Node ID: "
+               << HexSubstr(peer.node_id.string()) << ". Added rudp connection will be removed.";
+    network.Remove(peer.connection_id);
+  }
+  return added;
+}
+
 // FIXME
 void HandleSymmetricNodeAdd(RoutingTable& /*routing_table*/, const NodeId& /*peer_id*/,
                             const asymm::PublicKey& /*public_key*/) {
@@ -130,12 +167,12 @@ void HandleSymmetricNodeAdd(RoutingTable& /*routing_table*/, const NodeId& /*pee
 
 GroupRangeStatus GetProximalRange(const NodeId& target_id, const NodeId& node_id,
                                   const NodeId& this_node_id,
-                                  const crypto::BigInt& proximity_radius,
+                                  const Uint512& proximity_radius,
                                   const std::vector<NodeId>& holders) {
   assert((std::find(holders.begin(), holders.end(), target_id) == holders.end()) &&
          "Ensure to remove target id entry from holders, if present");
   assert(std::is_sorted(holders.begin(), holders.end(),
-                        [target_id](const NodeId & lhs, const NodeId & rhs) {
+                        [&target_id](const NodeId & lhs, const NodeId & rhs) {
            return NodeId::CloserToTarget(lhs, rhs, target_id);
          }) &&
          "Ensure to sort holders in order of distance to targer_id");
@@ -148,8 +185,7 @@ GroupRangeStatus GetProximalRange(const NodeId& target_id, const NodeId& node_id
     return GroupRangeStatus::kInRange;
   }
 
-  NodeId distance_id(node_id ^ target_id);
-  crypto::BigInt distance((distance_id.ToStringEncoded(NodeId::EncodingType::kHex) + 'h').c_str());
+  Uint512 distance(Uint512(node_id) ^ Uint512(target_id));
   return (distance < proximity_radius) ? GroupRangeStatus::kInProximalRange
                                        : GroupRangeStatus::kOutwithRange;
 }
@@ -190,15 +226,18 @@ bool ValidateMessage(const protobuf::Message& message) {
 
   // Message has traversed more hops than expected
   if (message.hops_to_live() <= 0) {
-    std::string route_history;
-    for (const auto& route : message.route_history())
-      route_history += HexSubstr(route) + ", ";
-    LOG(kError) << "Message has traversed more hops than expected. "
-                << Parameters::max_route_history
-                << " last hops in route history are: " << route_history
-                << " \nMessage source: " << HexSubstr(message.source_id())
-                << ", \nMessage destination: " << HexSubstr(message.destination_id())
-                << ", \nMessage type: " << message.type() << ", \nMessage id: " << message.id();
+    if (TraceEnabled(kError)) {
+      std::string route_history;
+      for (const auto& route : message.route_history())
+        route_history += HexSubstr(route) + ", ";
+      TRACE(kError) << "Message has traversed more hops than expected. "
+                    << Parameters::max_route_history
+                    << " last hops in route history are: " << route_history
+                    << " \nMessage source: " << HexSubstr(message.source_id())
+                    << ", \nMessage destination: " << HexSubstr(message.destination_id())
+                    << ", \nMessage type: " << message.type()
+                    << ", \nMessage id: " << message.id();
+    }
     return false;
   }
   // Invalid destination id, unknown message
@@ -259,8 +298,12 @@ boost::asio::ip::udp::endpoint GetEndpointFromProtobuf(const protobuf::Endpoint&
 }
 
 std::string MessageTypeString(const protobuf::Message& message) {
+  return MessageTypeString(message.type(), message.request());
+}
+
+std::string MessageTypeString(int32_t type, bool request) {
   std::string message_type;
-  switch (static_cast<MessageType>(message.type())) {
+  switch (static_cast<MessageType>(type)) {
     case MessageType::kPing:
       message_type = "kPing     ";
       break;
@@ -291,7 +334,7 @@ std::string MessageTypeString(const protobuf::Message& message) {
     default:
       message_type = "Unknown  ";
   }
-  if (message.request())
+  if (request)
     message_type = message_type + " Req";
   else
     message_type = message_type + " Res";
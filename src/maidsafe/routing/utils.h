@@ -34,6 +34,7 @@
 #include "maidsafe/routing/node_info.h"
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/uint512.h"
 
 namespace maidsafe {
 
@@ -62,11 +63,18 @@ bool ValidateAndAddToRoutingTable(
     const NodeId& peer_id, const NodeId& connection_id, const asymm::PublicKey& public_key,
     bool client, const std::vector<NodeInfo>& matrix_update = std::vector<NodeInfo>());
 
+// As above for several non-client peers, each with its public key set, which are added to the
+// routing table as one batch.  'matrix_updates' holds each peer's matrix update.  Returns the peers
+// added; the connections of the rest are removed.
+std::vector<NodeInfo> ValidateAndAddToRoutingTable(
+    NetworkUtils& network, RoutingTable& routing_table, const std::vector<NodeInfo>& peers,
+    const std::vector<std::vector<NodeInfo>>& matrix_updates);
+
 void HandleSymmetricNodeAdd(RoutingTable& routing_table, const NodeId& peer_id,
                             const asymm::PublicKey& public_key);
 GroupRangeStatus GetProximalRange(const NodeId& target_id, const NodeId& node_id,
                                   const NodeId& this_node_id,
-                                  const crypto::BigInt& proximity_radius,
+                                  const Uint512& proximity_radius,
                                   const std::vector<NodeId>& holders);
 
 bool IsRoutingMessage(const protobuf::Message& message);
@@ -84,6 +92,7 @@ void SetProtobufEndpoint(const boost::asio::ip::udp::endpoint& endpoint,
                          protobuf::Endpoint* pb_endpoint);
 boost::asio::ip::udp::endpoint GetEndpointFromProtobuf(const protobuf::Endpoint& pb_endpoint);
 std::string MessageTypeString(const protobuf::Message& message);
+std::string MessageTypeString(int32_t type, bool request);
 std::vector<boost::asio::ip::udp::endpoint> OrderBootstrapList(
     std::vector<boost::asio::ip::udp::endpoint> peer_endpoints);
 protobuf::NatType NatTypeProtobuf(const rudp::NatType& nat_type);